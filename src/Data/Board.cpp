@@ -1,9 +1,14 @@
 // Owl - www.owlclient.com
 // Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
 
+#include <atomic>
+#include <functional>
 #include <QDataStream>
+#include <QtConcurrent>
 #include <boost/functional/hash.hpp>
 
+#include <Parsers/LuaParserBase.h>
+#include <Utils/CookieStore.h>
 #include <Utils/Settings.h>
 #include <Utils/OwlLogger.h>
 #include <Utils/OwlUtils.h>
@@ -19,6 +24,19 @@ const char* const Board::Options::USE_ENCRYPTION		= "encryption.enabled";;
 const char* const Board::Options::ENCSEED				= "encryption.seed";;
 const char* const Board::Options::ENCKEY				= "encryption.key";
 
+// how many forum lists are fetched at once while crawling, which is also how
+// many connections a crawl opens to the board's host
+static const int CRAWL_MAX_CONCURRENT = 4;
+
+// how many of a thread list's unread threads get their posts prefetched
+static const int PREFETCH_UNREAD_THREADS = 3;
+
+// how long prefetched pages are kept when "prefetch.ttl" isn't set, in seconds
+static const int PREFETCH_DEFAULT_TTL = 60;
+
+// BoardItem var that carries a prefetched item's PageCache key
+static const char* const PREFETCH_KEY_VAR = "prefetch.key";
+
 Board::Board(const QString& url)
     : _url(url),
     _bEnabled(true),
@@ -74,6 +92,10 @@ void Board::setParser(ParserBasePtr parser)
 		// tell the old parser object to stop sending us signals
 		_parser->disconnect(this);
 
+        // whatever it prefetched belongs to the old session
+        _prefetchRequests.clear();
+        _pageCache.clear();
+
         // release the old object
         _parser.reset();
 	}
@@ -86,6 +108,7 @@ void Board::setParser(ParserBasePtr parser)
 		setProtocolName(_parser->getName());
 
 		_parser->setUserAgent(getUserAgent());
+        _parser->setCacheIdentity(getServiceUrl() + '\n' + getUsername());
 
 		QObject::connect(_parser.get(), SIGNAL(boardwareInfoCompleted(StringMap)), 
 			this, SLOT(boardwareInfoEvent(StringMap)), Qt::DirectConnection);
@@ -110,6 +133,16 @@ void Board::setParser(ParserBasePtr parser)
 
         QObject::connect(_parser.get(), SIGNAL(errorNotification(const Exception&)),
             this, SIGNAL(onRequestError(const Exception&)), Qt::DirectConnection);
+
+        QObject::connect(_parser.get(), SIGNAL(threadListPrefetched(ForumPtr)),
+            this, SLOT(threadListPrefetchedEvent(ForumPtr)), Qt::DirectConnection);
+
+        QObject::connect(_parser.get(), SIGNAL(postsPrefetched(ThreadPtr)),
+            this, SLOT(postsPrefetchedEvent(ThreadPtr)), Qt::DirectConnection);
+
+        const auto forgetRequest = [this](quint64 id) { _prefetchRequests.removeOne(id); };
+        QObject::connect(_parser.get(), &ParserBase::requestCompleted, this, forgetRequest, Qt::DirectConnection);
+        QObject::connect(_parser.get(), &ParserBase::requestCancelled, this, forgetRequest, Qt::DirectConnection);
 	}
 }
 
@@ -117,6 +150,11 @@ void Board::setLoginInfo(const LoginInfo& var)
 {
 	setUsername(var.first);
 	setPassword(var.second);
+
+    if (_parser)
+    {
+        _parser->setCacheIdentity(getServiceUrl() + '\n' + getUsername());
+    }
 }
 
 void Board::setCustomUserAgent(bool bCustom)
@@ -149,14 +187,50 @@ void Board::login()
 {
 	LoginInfo info(getUsername(), getPassword());
 
+    // resume the session from the last run if there is one, the parser confirms it's
+    // still good with its first request and logs in again if it isn't
+    const QByteArray session = CookieStore::instance().load(QString::fromStdString(_uuid));
+    if (!session.isEmpty() && getParser()->restoreSession(info, session))
+    {
+        _logger->debug("Restored session for board '{}' with user '{}'",
+            readableHash(), getUsername().toStdString());
+
+        StringMap params;
+        params.setOrAdd("success", true);
+        params.setOrAdd("restored", true);
+
+        // delivered from the event loop just like the result of a real login
+        QMetaObject::invokeMethod(this, "loginEvent", Qt::QueuedConnection, Q_ARG(StringMap, params));
+        return;
+    }
+
 	getParser()->loginAsync(info);
 }
 
+void Board::saveSession()
+{
+    if (_uuid.empty() || !_parser)
+    {
+        return;
+    }
+
+    const QByteArray session = _parser->saveSession();
+    if (!session.isEmpty())
+    {
+        CookieStore::instance().save(QString::fromStdString(_uuid), session);
+    }
+}
+
 void Board::loginEvent(StringMap params)
 {
 	if (params.getBool("success"))
 	{
         _status = BoardStatus::ONLINE;
+
+        if (!params.has("restored"))
+        {
+            saveSession();
+        }
 	}
 
 	Q_EMIT onLogin(shared_from_this(), params);
@@ -224,7 +298,14 @@ void Board::requestThreadList(ForumPtr forum, int options)
 	this->setCurrentForum(forum);
     int iPerPage = this->getOptions()->get<std::int32_t>("threadsPerPage");
     forum->setPerPage(iPerPage);
-    
+
+    if (takePrefetchedThreads(forum, options))
+    {
+        return;
+    }
+
+    // don't let guesses hold up what the user actually asked for
+    cancelPrefetches();
 	getParser()->getThreadListAsync(forum, options);
 }
 
@@ -239,17 +320,17 @@ void Board::requestPostList(ThreadPtr thread, int options, bool bForceGoto/*=fal
     int iPerPage = this->getOptions()->get<std::int32_t>("postsPerPage");
     thread->setPerPage(iPerPage);
 
-	if (!bForceGoto)
-	{
-        const auto viewOption =
-            static_cast<ParserBase::PostListOptions>(SettingsObject().read("view.threads.action").toInt());
+    const auto listOption = bForceGoto
+        ? ParserBase::PostListOptions::FIRST_POST
+        : static_cast<ParserBase::PostListOptions>(SettingsObject().read("view.threads.action").toInt());
 
-		getParser()->getPostsAsync(thread, viewOption, options);
-	}
-	else
-	{
-		getParser()->getPostsAsync(thread, ParserBase::PostListOptions::FIRST_POST, options);
-	}
+    if (takePrefetchedPosts(thread, listOption, options))
+    {
+        return;
+    }
+
+    cancelPrefetches();
+	getParser()->getPostsAsync(thread, listOption, options);
 }
 
 void Board::markForumRead(ForumPtr forum)
@@ -319,6 +400,7 @@ void Board::getThreadListEvent(ForumPtr forum)
             }
             
             Q_EMIT onGetThreads(sharedFromThis, forum);
+            prefetchNextPages(forum);
 		}
         else
         {
@@ -351,6 +433,7 @@ void Board::getPostsEvent(ThreadPtr thread)
 			}
 
 			Q_EMIT onGetPosts(shared_from_this(), thread);
+            prefetchNextPages(thread);
 		}
 	}
     else
@@ -361,14 +444,200 @@ void Board::getPostsEvent(ThreadPtr thread)
 
 void Board::markForumReadEvent(ForumPtr f)
 {
+    if (f)
+    {
+        // so the next update reports the forum again if it has new posts by then
+        QMutexLocker lock(&_unreadMutex);
+        _unreadForumIds.remove(f->getId());
+    }
+
     Q_EMIT onMarkedForumRead(shared_from_this(), f);
 }
 
-void Board::crawlSubForum(ForumPtr parent, ForumIdList* dupList /*= nullptr*/, bool bThrow /*= true*/)
+void Board::threadListPrefetchedEvent(ForumPtr forum)
+{
+    const QString key = forum ? forum->getVar(PREFETCH_KEY_VAR, false) : QString();
+    if (key.isEmpty() || !isPrefetchEnabled())
+    {
+        return;
+    }
+
+    _pageCache.put(key, QVariant::fromValue(forum));
+    _logger->trace("Prefetched '{}' for board '{}'", key.toStdString(), _url.toStdString());
+}
+
+void Board::postsPrefetchedEvent(ThreadPtr thread)
+{
+    const QString key = thread ? thread->getVar(PREFETCH_KEY_VAR, false) : QString();
+    if (key.isEmpty() || !isPrefetchEnabled())
+    {
+        return;
+    }
+
+    _pageCache.put(key, QVariant::fromValue(thread));
+    _logger->trace("Prefetched '{}' for board '{}'", key.toStdString(), _url.toStdString());
+}
+
+bool Board::isPrefetchEnabled() const
+{
+    return _options->getBool("prefetch.enabled", false);
+}
+
+bool Board::takePrefetchedThreads(ForumPtr forum, int options)
+{
+    const QString key = PageCache::makeKey(QStringLiteral("threads"),
+        forum->getId(), forum->getPageNumber(), forum->getPerPage(), ParserEnums::REQUEST_DEFAULT);
+
+    // a page the user asked to reload has to come from the board
+    const ForumPtr cached = _pageCache.take(key).value<ForumPtr>();
+    if (!cached || !isPrefetchEnabled() || (options & ParserEnums::REQUEST_NOCACHE))
+    {
+        return false;
+    }
+
+    forum->getThreads() = cached->getThreads();
+    for (ThreadPtr thread : forum->getThreads())
+    {
+        thread->setParent(forum);
+    }
+
+    forum->setPageNumber(cached->getPageNumber());
+    forum->setPageCount(cached->getPageCount());
+
+    _logger->trace("Serving '{}' from the prefetch cache", key.toStdString());
+
+    // callers expect the result after they've returned, like any other request
+    QTimer::singleShot(0, this, [this, forum]() { getThreadListEvent(forum); });
+    return true;
+}
+
+bool Board::takePrefetchedPosts(ThreadPtr thread, ParserBase::PostListOptions listOption, int options)
+{
+    const QString key = PageCache::makeKey(QStringLiteral("posts"),
+        thread->getId(), thread->getPageNumber(), thread->getPerPage(), listOption);
+
+    const ThreadPtr cached = _pageCache.take(key).value<ThreadPtr>();
+    if (!cached || !isPrefetchEnabled() || (options & ParserEnums::REQUEST_NOCACHE))
+    {
+        return false;
+    }
+
+    thread->getPosts() = cached->getPosts();
+    for (PostPtr post : thread->getPosts())
+    {
+        post->setParent(thread);
+    }
+
+    thread->setPageNumber(cached->getPageNumber());
+    thread->setPageCount(cached->getPageCount());
+    thread->setFirstUnreadPost(cached->getFirstUnread().lock());
+
+    _logger->trace("Serving '{}' from the prefetch cache", key.toStdString());
+
+    QTimer::singleShot(0, this, [this, thread]() { getPostsEvent(thread); });
+    return true;
+}
+
+void Board::prefetchNextPages(ForumPtr forum)
+{
+    if (!isPrefetchEnabled())
+    {
+        return;
+    }
+
+    if (forum->getPageNumber() < forum->getPageCount())
+    {
+        prefetchThreadList(forum->getId(), forum->getPageNumber() + 1);
+    }
+
+    // the posts are fetched the way clicking on the thread would fetch them
+    const auto listOption =
+        static_cast<ParserBase::PostListOptions>(SettingsObject().read("view.threads.action").toInt());
+
+    int count = 0;
+    for (ThreadPtr thread : forum->getThreads())
+    {
+        if (count >= PREFETCH_UNREAD_THREADS)
+        {
+            break;
+        }
+
+        if (thread->hasUnread())
+        {
+            prefetchPostList(thread->getId(), listOption, thread->getPageNumber());
+            count++;
+        }
+    }
+}
+
+void Board::prefetchNextPages(ThreadPtr thread)
+{
+    if (isPrefetchEnabled() && thread->getPageNumber() < thread->getPageCount())
+    {
+        // paging through a thread always asks for the page's first post
+        prefetchPostList(thread->getId(), ParserBase::PostListOptions::FIRST_POST, thread->getPageNumber() + 1);
+    }
+}
+
+void Board::prefetchThreadList(const QString& forumId, int page)
+{
+    const int perPage = getOptions()->get<std::int32_t>("threadsPerPage");
+    const QString key = PageCache::makeKey(QStringLiteral("threads"), forumId, page, perPage, ParserEnums::REQUEST_DEFAULT);
+
+    if (_pageCache.contains(key))
+    {
+        return;
+    }
+
+    ForumPtr forum(new Forum(forumId));
+    forum->setPageNumber(page);
+    forum->setPerPage(perPage);
+    forum->setVar(PREFETCH_KEY_VAR, key);
+
+    _pageCache.setTtl(std::chrono::seconds(_options->has("prefetch.ttl")
+        ? _options->get<std::int32_t>("prefetch.ttl") : PREFETCH_DEFAULT_TTL));
+
+    _prefetchRequests.push_back(getParser()->prefetchThreadListAsync(forum));
+}
+
+void Board::prefetchPostList(const QString& threadId, ParserBase::PostListOptions listOption, int page)
+{
+    const int perPage = getOptions()->get<std::int32_t>("postsPerPage");
+    const QString key = PageCache::makeKey(QStringLiteral("posts"), threadId, page, perPage, listOption);
+
+    if (_pageCache.contains(key))
+    {
+        return;
+    }
+
+    ThreadPtr thread(new Thread(threadId));
+    thread->setPageNumber(page);
+    thread->setPerPage(perPage);
+    thread->setVar(PREFETCH_KEY_VAR, key);
+
+    _pageCache.setTtl(std::chrono::seconds(_options->has("prefetch.ttl")
+        ? _options->get<std::int32_t>("prefetch.ttl") : PREFETCH_DEFAULT_TTL));
+
+    _prefetchRequests.push_back(getParser()->prefetchPostsAsync(thread, listOption));
+}
+
+void Board::cancelPrefetches()
+{
+    // cancelling emits requestCancelled() which removes the id from the list
+    const auto requests = _prefetchRequests;
+    _prefetchRequests.clear();
+
+    for (const auto id : requests)
+    {
+        getParser()->cancelRequest(id);
+    }
+}
+
+void Board::crawlSubForum(ForumPtr parent, ForumIdList* dupList /*= nullptr*/, bool bThrow /*= true*/, ForumListCache* cache /*= nullptr*/)
 {
 	Q_ASSERT(!parent->getId().isEmpty());
 
-	ForumList forums = _parser->getForumList(parent->getId());
+	ForumList forums = fetchForumList(parent->getId(), cache);
 	parent->getForums().clear();
 
     for (ForumPtr forum : forums)
@@ -385,7 +654,7 @@ void Board::crawlSubForum(ForumPtr parent, ForumIdList* dupList /*= nullptr*/, b
                 forum->getName().toStdString(), forum->getId().toStdString());
 
 			dupList->push_back(forum->getId());
-			crawlSubForum(forum, dupList, bThrow);
+			crawlSubForum(forum, dupList, bThrow, cache);
 		}
 	}
 }
@@ -400,7 +669,11 @@ void Board::crawlRoot(bool bThrow /*= true*/)
 	try
 	{
 		_root = Forum::createRootForum(_parser->getRootForumId());
-		ForumList list = _parser->getForumList(_root->getId());
+
+        // the tree is still built depth first exactly as before, the forum
+        // lists just come out of the cache instead of one request at a time
+        ForumListCache cache = prefetchForumLists(_root->getId());
+		ForumList list = fetchForumList(_root->getId(), &cache);
 
 		for(ForumPtr forum : list)
 		{
@@ -417,7 +690,7 @@ void Board::crawlRoot(bool bThrow /*= true*/)
                     _logger->debug("Crawling Root Forum: {} ({})",
                         forum->getName().toStdString(), forum->getId().toStdString());
 
-					crawlSubForum(forum, &dupList, bThrow);
+					crawlSubForum(forum, &dupList, bThrow, &cache);
 				}
 
 				// even if the this is a Forum::LINK, add it to the duplicate list
@@ -463,7 +736,8 @@ ForumPtr Board::getRootStructure(bool bThrow /* = true */)
 
 	try
 	{
-		ForumList list = _parser->getForumList(root->getId());
+        ForumListCache cache = prefetchForumLists(root->getId());
+		ForumList list = fetchForumList(root->getId(), &cache);
         
         for (ForumPtr forum : list)
 		{
@@ -478,7 +752,7 @@ ForumPtr Board::getRootStructure(bool bThrow /* = true */)
                     _logger->debug("Crawling Root Forum: {} ({})",
                         forum->getName().toStdString(), forum->getId().toStdString());
 
-					crawlSubForum(forum, &dupList, bThrow);
+					crawlSubForum(forum, &dupList, bThrow, &cache);
 				}
                 
 				// even if the this is a Forum::LINK, add it to the duplicate list
@@ -516,23 +790,367 @@ ForumPtr Board::getRootStructure(bool bThrow /* = true */)
     return root;
 }
 
-void Board::updateUnread()
+Board::ForumListCache Board::prefetchForumLists(const QString& rootId)
+{
+    ForumListCache cache;
+
+    // clones of a Lua parser share its Lua state and take turns with it, a
+    // pool of them would fetch no faster than the crawl does on its own
+    if (std::dynamic_pointer_cast<LuaParserBase>(getParser()))
+    {
+        return cache;
+    }
+
+    // a parser only handles one request at a time so each concurrent request gets its own
+    std::vector<ParserBasePtr> parsers;
+    try
+    {
+        for (int i = 0; i < CRAWL_MAX_CONCURRENT; i++)
+        {
+            parsers.push_back(cloneParser());
+        }
+    }
+    catch (const owl::Exception& e)
+    {
+        _logger->debug("Cannot clone parser, crawling '{}' serially: {}", _url.toStdString(), e.message().toStdString());
+        return cache;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(CRAWL_MAX_CONCURRENT);
+
+    QMutex mutex;
+    QSet<QString> discovered { rootId };
+    QStringList level { rootId };
+    int fetched = 0;
+
+    const BoardPtr self = shared_from_this();
+
+    // the workers run on the pool's threads, they have to stop with the
+    // operation that started the crawl
+    const CancellationTokenPtr token = CancellationToken::current();
+
+    while (!level.isEmpty())
+    {
+        QStringList nextLevel;
+        std::atomic<int> next { 0 };
+
+        // every forum of the level is fetched before moving on to the next one
+        QList<QFuture<void>> workers;
+        for (const ParserBasePtr& parser : parsers)
+        {
+            workers.push_back(QtConcurrent::run(&pool, [&, parser]()
+            {
+                CancellationToken::Scope scope(token);
+
+                for (int i = next++; i < level.size(); i = next++)
+                {
+                    if (token && token->isCancelled())
+                    {
+                        break;
+                    }
+
+                    const QString& id = level.at(i);
+                    ForumList list;
+                    bool bFetched = false;
+
+                    try
+                    {
+                        list = parser->getForumList(id);
+                        bFetched = true;
+                    }
+                    catch (...)
+                    {
+                        // left out of the cache, the crawl fetches it again and deals with the error
+                        _logger->debug("Prefetching forum list of '{}' failed", id.toStdString());
+                    }
+
+                    int progress = 0;
+                    int total = 0;
+
+                    {
+                        QMutexLocker locker(&mutex);
+
+                        if (bFetched)
+                        {
+                            cache.insert(id, list);
+
+                            for (const ForumPtr& forum : list)
+                            {
+                                if (forum->getForumType() != owl::Forum::LINK && !discovered.contains(forum->getId()))
+                                {
+                                    discovered.insert(forum->getId());
+                                    nextLevel.push_back(forum->getId());
+                                }
+                            }
+                        }
+
+                        progress = ++fetched;
+                        total = discovered.size();
+                    }
+
+                    // the signal is delivered directly to slots that may take
+                    // their time, the other workers shouldn't wait on them
+                    Q_EMIT onCrawlProgress(self, progress, total);
+                }
+            }));
+        }
+
+        for (auto& worker : workers)
+        {
+            worker.waitForFinished();
+        }
+
+        if (token && token->isCancelled())
+        {
+            break;
+        }
+
+        level.swap(nextLevel);
+    }
+
+    _logger->debug("Prefetched {} forum lists for '{}'", cache.size(), _url.toStdString());
+
+    return cache;
+}
+
+ForumList Board::fetchForumList(const QString& id, ForumListCache* cache)
+{
+    if (cache != nullptr)
+    {
+        // each list is used once, a forum that is crawled twice gets fresh
+        // objects from the parser just like it would without the cache
+        auto it = cache->find(id);
+        if (it != cache->end())
+        {
+            ForumList retval = it.value();
+            cache->erase(it);
+            return retval;
+        }
+    }
+
+    return _parser->getForumList(id);
+}
+
+ForumChangeList Board::syncStructure(ForumPtr storedRoot)
+{
+    ForumChangeList changes;
+
+    if (!_parser || !storedRoot) return changes;
+
+    ForumListCache cache = prefetchForumLists(storedRoot->getId());
+    syncBranch(storedRoot, &cache, changes);
+
+    std::stable_partition(changes.begin(), changes.end(),
+        [](const ForumChange& change) { return change.type == ForumChange::REMOVED; });
+
+    _logger->debug("Found {} change(s) in the forum structure of '{}'", changes.size(), _url.toStdString());
+
+    return changes;
+}
+
+void Board::syncBranch(ForumPtr stored, ForumListCache* cache, ForumChangeList& changes)
+{
+    const ForumList current = fetchForumList(stored->getId(), cache);
+
+    QHash<QString, ForumPtr> currentById;
+    for (const ForumPtr& forum : current)
+    {
+        currentById.insert(forum->getId(), forum);
+    }
+
+    // forums saved before fingerprints were stored don't have one yet
+    const QString storedFingerprint = stored->getFingerprint().isEmpty()
+        ? Forum::fingerprint(stored->getForums())
+        : stored->getFingerprint();
+
+    if (Forum::fingerprint(current) != storedFingerprint)
+    {
+        const ForumChangeList branch = Forum::diffForums(stored->getId(), stored->getForums(), current);
+
+        for (const ForumChange& change : branch)
+        {
+            if (change.type == ForumChange::ADDED && change.forum->getForumType() != Forum::LINK)
+            {
+                // nothing is stored for a new branch so it is crawled whole
+                ForumIdList dupList { change.forum->getId() };
+                crawlSubForum(change.forum, &dupList, true, cache);
+            }
+        }
+
+        changes.append(branch);
+    }
+
+    // only the forums that are still there are compared further down, new
+    // ones were crawled above and removed ones took their sub forums with them
+    for (const ForumPtr& child : stored->getForums())
+    {
+        const ForumPtr currentChild = currentById.value(child->getId());
+        if (currentChild && currentChild->getForumType() != Forum::LINK)
+        {
+            syncBranch(child, cache, changes);
+        }
+    }
+}
+
+void Board::applyStructureChanges(const ForumChangeList& changes)
+{
+    if (!_root) return;
+
+    QMutexLocker locker(&_hashMutex);
+    doUpdateHash(_root);
+
+    std::function<void(const ForumPtr&)> unhash = [this, &unhash](const ForumPtr& forum)
+    {
+        _forumHash.remove(forum->getId());
+
+        for (const ForumPtr& child : forum->getForums())
+        {
+            unhash(child);
+        }
+    };
+
+    ForumList parents;
+
+    for (const ForumChange& change : changes)
+    {
+        const ForumPtr parent = _forumHash.value(change.parentId);
+        if (!parent)
+        {
+            _logger->warn("Cannot apply change to forum '{}' because its parent '{}' was not found",
+                change.forum->getId().toStdString(), change.parentId.toStdString());
+            continue;
+        }
+
+        ForumList& siblings = parent->getForums();
+        const auto existing = std::find_if(siblings.begin(), siblings.end(),
+            [&change](const ForumPtr& forum) { return forum->getId() == change.forum->getId(); });
+
+        if (change.type == ForumChange::ADDED)
+        {
+            change.forum->setBoard(shared_from_this());
+            parent->addChild(change.forum, false);
+            siblings.push_back(change.forum);
+            doUpdateHash(change.forum);
+        }
+        else if (existing == siblings.end())
+        {
+            _logger->warn("Cannot apply change to forum '{}' because it was not found",
+                change.forum->getId().toStdString());
+            continue;
+        }
+        else if (change.type == ForumChange::REMOVED)
+        {
+            unhash(*existing);
+            parent->removeChild(*existing, false);
+            siblings.erase(existing);
+        }
+        else if (change.type == ForumChange::RENAMED)
+        {
+            (*existing)->setName(change.forum->getName());
+            (*existing)->setForumType(change.forum->getForumType());
+        }
+        else if (change.type == ForumChange::REORDERED)
+        {
+            (*existing)->setDisplayOrder(change.forum->getDisplayOrder());
+        }
+
+        if (!parents.contains(parent))
+        {
+            parents.push_back(parent);
+        }
+    }
+
+    for (const ForumPtr& parent : parents)
+    {
+        std::stable_sort(parent->getForums().begin(), parent->getForums().end(),
+            [](const ForumPtr& a, const ForumPtr& b) { return a->getDisplayOrder() < b->getDisplayOrder(); });
+
+        parent->setFingerprint(Forum::fingerprint(parent->getForums()));
+    }
+}
+
+bool Board::updateUnread(bool bThrow /*= false*/)
 {
     _logger->info("Updating unread threads for {}", this->getName().toStdString());
-    
+
+    bool bChanged = false;
+
 	try
 	{
 		updateForumHash();
 		ForumList list = _parser->getUnreadForums();
         _hasUnread = list.size() > 0;
-        Q_EMIT onGetUnreadForums(shared_from_this(), list);
+
+        QSet<QString> unreadIds;
+        for (const ForumPtr& forum : list)
+        {
+            unreadIds.insert(forum->getId());
+        }
+
+        ForumList becameUnread;
+        ForumList becameRead;
+
+        {
+            QMutexLocker hashLock(&_hashMutex);
+            QMutexLocker lock(&_unreadMutex);
+
+            if (!_bUnreadKnown)
+            {
+                // the first update is compared to what the tree was loaded with
+                for (const ForumPtr& forum : _forumHash)
+                {
+                    if (forum->hasUnread())
+                    {
+                        _unreadForumIds.insert(forum->getId());
+                    }
+                }
+
+                _bUnreadKnown = true;
+            }
+
+            for (const QString& id : unreadIds - _unreadForumIds)
+            {
+                if (ForumPtr forum = _forumHash.value(id); forum)
+                {
+                    forum->setHasUnread(true);
+                    becameUnread.push_back(forum);
+                }
+            }
+
+            for (const QString& id : _unreadForumIds - unreadIds)
+            {
+                if (ForumPtr forum = _forumHash.value(id); forum)
+                {
+                    forum->setHasUnread(false);
+                    becameRead.push_back(forum);
+                }
+            }
+
+            bChanged = unreadIds != _unreadForumIds;
+            _unreadForumIds = unreadIds;
+        }
+
+        if (!becameUnread.isEmpty() || !becameRead.isEmpty())
+        {
+            _logger->debug("Board '{}' has {} newly unread and {} newly read forum(s)",
+                this->getName().toStdString(), becameUnread.size(), becameRead.size());
+
+            Q_EMIT onUnreadForumsChanged(shared_from_this(), becameUnread, becameRead);
+        }
 	}
 	catch (const owl::Exception& e)
 	{
         _logger->error("Exception '{}'", e.message().toStdString());
+
+        if (bThrow)
+        {
+            throw;
+        }
 	}
 
     _logger->info("Leaving updateUnread of {}", this->getName().toStdString());
+    return bChanged;
 }
 
 /// Called when changes to the forum structre of the Board are made
@@ -612,6 +1230,12 @@ QString Board::getPostQuote(PostPtr post)
 void Board::refreshOptions()
 {
 	_parser->updateClients();
+
+    if (!isPrefetchEnabled())
+    {
+        cancelPrefetches();
+        _pageCache.clear();
+    }
 }
     
 /**
@@ -9,6 +9,7 @@
 #include <QSqlQuery>
 #include <Parsers/ParserBase.h>
 #include <Parsers/Forum.h>
+#include <Utils/PageCache.h>
 
 namespace spdlog
 {
@@ -69,6 +70,9 @@ public:
     // METHODS
 	void login();
 
+    // saves the parser's session so the next login() can resume it, see CookieStore
+    void saveSession();
+
 	// CRUD
     void submitNewThread(ThreadPtr);
 	void submitNewPost(PostPtr);
@@ -77,7 +81,19 @@ public:
 
 	void crawlRoot(bool bThrow = true);	 // create forum structure
     ForumPtr getRootStructure(bool bThrow = true);
-	void updateUnread(); // crawls the exists tree updating the forum's unread
+
+    // compares the board's forum structure to `storedRoot` and returns the
+    // differences, REMOVED changes come first so a forum that moved is taken
+    // out of its old parent before it is added to the new one. The stored
+    // tree is not modified, this is safe to call from a worker thread
+    ForumChangeList syncStructure(ForumPtr storedRoot);
+
+    // applies changes returned by syncStructure() to the board's own tree
+    void applyStructureChanges(const ForumChangeList& changes);
+    // crawls the existing tree updating the forums' unread state, returns true if the
+    // set of unread forums changed since the last update. Errors are logged unless
+    // bThrow is set
+	bool updateUnread(bool bThrow = false);
 
     void requestThreadList(ForumPtr forum);
 	void requestThreadList(ForumPtr forum, int options);
@@ -87,6 +103,12 @@ public:
     
     void markForumRead(ForumPtr forum);
 
+    // With the "prefetch.enabled" board option set, the next page of a thread list or
+    // thread and the top unread threads of a thread list are fetched in the background
+    // once a page is shown. They're kept for "prefetch.ttl" seconds so that moving on
+    // to them is served from memory
+    bool isPrefetchEnabled() const;
+
 	// MAINTENANCE
 	void updateForumHash();
 
@@ -189,10 +211,17 @@ Q_SIGNALS:
 	void onGetForum(BoardPtr, ForumPtr);
 	void onGetThreads(BoardPtr, ForumPtr);
 	void onGetPosts(BoardPtr, ThreadPtr);
-	void onGetUnreadForums(BoardPtr, ForumList);
+
+    // emitted by updateUnread() with the forums of the board's tree whose unread
+    // state changed since the last update, their flags have already been set
+    void onUnreadForumsChanged(BoardPtr, ForumList becameUnread, ForumList becameRead);
+
 	void onNewThread(BoardPtr, ThreadPtr);
 	void onNewPost(BoardPtr, PostPtr);
     void onMarkedForumRead(BoardPtr, ForumPtr);
+
+    // emitted while crawling the forum structure, may come from any thread
+    void onCrawlProgress(BoardPtr, int fetched, int discovered);
     void onRequestError(const Exception&);
 
 public Q_SLOTS:
@@ -207,11 +236,29 @@ private Q_SLOTS:
 	void getThreadListEvent(ForumPtr);
 	void getPostsEvent(ThreadPtr thread);
     void markForumReadEvent(ForumPtr);
+    void threadListPrefetchedEvent(ForumPtr forum);
+    void postsPrefetchedEvent(ThreadPtr thread);
 
 private:
-    void crawlSubForum(ForumPtr parent, ForumIdList* dupList = nullptr, bool bThrow = true);
+    // forum lists fetched ahead of a crawl, keyed by the parent's id
+    using ForumListCache = QHash<QString, ForumList>;
+
+    void crawlSubForum(ForumPtr parent, ForumIdList* dupList = nullptr, bool bThrow = true, ForumListCache* cache = nullptr);
+    ForumListCache prefetchForumLists(const QString& rootId);
+    ForumList fetchForumList(const QString& id, ForumListCache* cache);
+    void syncBranch(ForumPtr stored, ForumListCache* cache, ForumChangeList& changes);
 	void doUpdateHash(ForumPtr parent);
 
+    // fill the requested item from the PageCache, returns false if it wasn't there
+    bool takePrefetchedThreads(ForumPtr forum, int options);
+    bool takePrefetchedPosts(ThreadPtr thread, ParserBase::PostListOptions listOption, int options);
+
+    void prefetchNextPages(ForumPtr forum);
+    void prefetchNextPages(ThreadPtr thread);
+    void prefetchThreadList(const QString& forumId, int page);
+    void prefetchPostList(const QString& threadId, ParserBase::PostListOptions listOption, int page);
+    void cancelPrefetches();
+
 	uint			_boardId;
     std::string     _uuid;
 
@@ -251,6 +298,13 @@ private:
 	QMutex			_hashMutex;
     QMutex          _itemDocMutex;
 
+    QSet<QString>   _unreadForumIds;    // as of the last updateUnread()
+    bool            _bUnreadKnown = false;
+    QMutex          _unreadMutex;
+
+    PageCache                       _pageCache;
+    QList<ParserBase::RequestId>    _prefetchRequests;
+
     std::shared_ptr<spdlog::logger>  _logger;
 };
     
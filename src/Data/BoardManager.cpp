@@ -8,6 +8,7 @@
 #include <QSqlRecord>
 #include <QUuid>
 
+#include <Utils/CookieStore.h>
 #include <Utils/OwlLogger.h>
 
 #include "BoardManager.h"
@@ -220,12 +221,34 @@ QSqlDatabase BoardManager::initializeDatabase(const QString& filename)
     else
     {
         _logger->info("Opening database file '{}'", _databaseFilename);
-
+        upgradeDatabase();
     }
 
     return getDatabase(true);
 }
 
+void BoardManager::upgradeDatabase()
+{
+    QSqlDatabase db = getDatabase();
+    const QSqlRecord forums = db.record("forums");
+
+    if (!forums.isEmpty() && !forums.contains("fingerprint"))
+    {
+        QSqlQuery query(db);
+
+        // the column is filled in the next time each forum's structure is synced
+        if (query.exec("ALTER TABLE forums ADD COLUMN fingerprint TEXT"))
+        {
+            _logger->info("Added column 'fingerprint' to table 'forums'");
+        }
+        else
+        {
+            _logger->error("upgradeDatabase() failed: {}", query.lastError().text().toStdString());
+            _logger->debug("executed query: {}", query.lastQuery().toStdString());
+        }
+    }
+}
+
 owl::BoardPtr BoardManager::getBoardInfo(int boardId)
 {
 	QMutexLocker locker(&_mutex);
@@ -384,8 +407,8 @@ void BoardManager::createForumEntries( ForumPtr forum, BoardPtr board )
 	QSqlQuery		query(db);
 
 	query.prepare("INSERT INTO forums "
-		"(boardId, forumId, parentId, forumName, forumType, forumOrder) "
-		"VALUES (:boardId, :forumId, :parentId, :forumName, :forumType, :forumOrder)");	
+		"(boardId, forumId, parentId, forumName, forumType, forumOrder, fingerprint) "
+		"VALUES (:boardId, :forumId, :parentId, :forumName, :forumType, :forumOrder, :fingerprint)");	
 
 	query.bindValue(":boardId", board->getDBId());
 	query.bindValue(":forumId", forum->getId());
@@ -397,6 +420,9 @@ void BoardManager::createForumEntries( ForumPtr forum, BoardPtr board )
 	query.bindValue(":forumType", forum->getForumTypeString());
 	query.bindValue(":forumOrder", forum->getDisplayOrder());
 
+	forum->setFingerprint(Forum::fingerprint(forum->getForums()));
+	query.bindValue(":fingerprint", forum->getFingerprint());
+
 	if (query.exec())
 	{
 		db.commit();
@@ -573,6 +599,7 @@ void BoardManager::retrieveSubForumList(BoardPtr board, ForumPtr forum, bool bDe
 		int forumName = rec.indexOf("forumName");
 		int forumType = rec.indexOf("forumType");
 		int forumOrder = rec.indexOf("forumOrder");
+		int fingerprint = rec.indexOf("fingerprint");
 
 		while (query.next())
 		{
@@ -580,6 +607,7 @@ void BoardManager::retrieveSubForumList(BoardPtr board, ForumPtr forum, bool bDe
             newForum->setDBId(static_cast<std::int32_t>(query.value(id).toUInt()));
 			newForum->setName(query.value(forumName).toString());
             newForum->setDisplayOrder(static_cast<std::int32_t>(query.value(forumOrder).toUInt()));
+			newForum->setFingerprint(query.value(fingerprint).toString());
 
 			forum->addChild(newForum);
 			newForum->setBoard(board);
@@ -754,6 +782,9 @@ bool BoardManager::deleteBoard(BoardPtr board)
 
         
         db.commit();
+
+        // a deleted board shouldn't leave its session behind
+        CookieStore::instance().remove(QString::fromStdString(board->uuid()));
         
         auto boardIt = std::find_if(_boardList.begin(), _boardList.end(),
             [&board](const owl::BoardPtr& other) -> bool
@@ -812,6 +843,111 @@ bool BoardManager::deleteForumVars(const QString& forumId) const
     return bRet;
 }
 
+void BoardManager::deleteForumEntries(ForumPtr forum)
+{
+    for (ForumPtr child : forum->getForums())
+    {
+        deleteForumEntries(child);
+    }
+
+    deleteForumVars(QString::number(forum->getDBId()));
+
+    QSqlDatabase db = getDatabase();
+    QSqlQuery query(db);
+
+    query.prepare("DELETE FROM forums WHERE id = :id");
+    query.bindValue(":id", forum->getDBId());
+
+    if (!query.exec())
+    {
+        _logger->error("deleteForumEntries() failed: {}", query.lastError().text().toStdString());
+        _logger->debug("executed query: {}", query.lastQuery().toStdString());
+    }
+}
+
+void BoardManager::updateForumStructure(BoardPtr board, const ForumChangeList& changes)
+{
+    QMutexLocker locker(&_mutex);
+    QSqlDatabase db = getDatabase();
+    QSqlQuery query(db);
+
+    QStringList parentIds;
+
+    for (const ForumChange& change : changes)
+    {
+        switch (change.type)
+        {
+            case ForumChange::ADDED:
+                // applyStructureChanges() already hung the forum off its parent
+                createForumEntries(change.forum, board);
+            break;
+
+            case ForumChange::REMOVED:
+                // the stored forum, so it still has the ids of its rows
+                deleteForumEntries(change.forum);
+            break;
+
+            case ForumChange::RENAMED:
+                query.prepare("UPDATE forums SET forumName=:forumName, forumType=:forumType "
+                    "WHERE boardId=:boardId AND parentId=:parentId AND forumId=:forumId");
+                query.bindValue(":forumName", change.forum->getName());
+                query.bindValue(":forumType", change.forum->getForumTypeString());
+            break;
+
+            case ForumChange::REORDERED:
+                query.prepare("UPDATE forums SET forumOrder=:forumOrder "
+                    "WHERE boardId=:boardId AND parentId=:parentId AND forumId=:forumId");
+                query.bindValue(":forumOrder", change.forum->getDisplayOrder());
+            break;
+        }
+
+        if (change.type == ForumChange::RENAMED || change.type == ForumChange::REORDERED)
+        {
+            query.bindValue(":boardId", board->getDBId());
+            query.bindValue(":parentId", change.parentId);
+            query.bindValue(":forumId", change.forum->getId());
+
+            if (!query.exec())
+            {
+                _logger->error("updateForumStructure() failed: {}", query.lastError().text().toStdString());
+                _logger->debug("executed query: {}", query.lastQuery().toStdString());
+            }
+        }
+
+        if (!parentIds.contains(change.parentId))
+        {
+            parentIds.push_back(change.parentId);
+        }
+    }
+
+    // the root isn't stored in the forums table, its fingerprint is always
+    // worked out from the top level forums
+    for (const QString& parentId : parentIds)
+    {
+        const ForumPtr parent = board->getForumHash().value(parentId);
+        if (!parent || parent->IsRoot())
+        {
+            continue;
+        }
+
+        query.prepare("UPDATE forums SET fingerprint=:fingerprint WHERE id=:id");
+        query.bindValue(":fingerprint", parent->getFingerprint());
+        query.bindValue(":id", parent->getDBId());
+
+        if (!query.exec())
+        {
+            _logger->error("updateForumStructure() failed: {}", query.lastError().text().toStdString());
+            _logger->debug("executed query: {}", query.lastQuery().toStdString());
+        }
+    }
+
+    db.commit();
+
+    _logger->debug("Applied {} forum change(s) to board '{}'", changes.size(), board->getName().toStdString());
+
+    Q_EMIT onForumStructureChanged(board, changes);
+}
+
 void BoardManager::updateBoardOptions(BoardPtr board, bool bDoCommit /*= false*/)
 {
 	QSqlDatabase db = getDatabase();
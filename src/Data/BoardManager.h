@@ -71,21 +71,32 @@ public:
     // FORUM - CRUD
     bool deleteForumVars(const QString& forumId) const;
 
+    // writes changes that have been applied to the board with
+    // Board::applyStructureChanges(), only the affected rows are touched
+    void updateForumStructure(BoardPtr board, const ForumChangeList& changes);
+
 Q_SIGNALS:
     void onBeginAddBoard(int index);
     void onEndAddBoard();
     void onBeginRemoveBoard(int index);
     void onEndRemoveBoard();
 
+    // emitted by updateForumStructure() once the rows have been written
+    void onForumStructureChanged(BoardPtr board, ForumChangeList changes);
+
 
 private:
     BoardManager();
 
     QSqlDatabase getDatabase(bool doOpen = true) const;
 
+    // brings a database created by an older version up to date
+    void upgradeDatabase();
+
 	void createBoardOptions(BoardPtr board);	
 	void createForumEntries(ForumPtr forum, BoardPtr board);
 	void createForumVars(ForumPtr forum);
+	void deleteForumEntries(ForumPtr forum);
 
 	void retrieveSubForumVars(ForumPtr forum);
 	void retrieveSubForumList(BoardPtr board, ForumPtr forum, bool bDeep = false);
@@ -42,7 +42,8 @@ CREATE TABLE forums
 	parentId TEXT, 			-- FK to the parent forumId
 	forumName TEXT,			-- dislay name of the forum
 	forumType TEXT, 		-- enum, FORUM, CATEGORY, LINK
-	forumOrder INTEGER		-- display order of the forum
+	forumOrder INTEGER,		-- display order of the forum
+	fingerprint TEXT		-- hash of the forum's sub forums, see Forum::fingerprint()
 );
 
 CREATE TABLE forumvars 
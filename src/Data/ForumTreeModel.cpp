@@ -25,6 +25,24 @@ ForumTreeModel::ForumTreeModel(const ForumPtr root, QObject *parent)
     : QAbstractItemModel(parent)
 {
     crawlForums(root, _nodes);
+
+    for (std::size_t i = 0; i < _nodes.size(); i++)
+    {
+        _rows.insert(_nodes[i].get(), static_cast<int>(i));
+    }
+}
+
+void ForumTreeModel::updateForums(const ForumList& forums)
+{
+    for (const ForumPtr& forum : forums)
+    {
+        const auto it = _rows.find(forum.get());
+        if (it != _rows.end())
+        {
+            const QModelIndex idx = index(it.value(), 0);
+            Q_EMIT dataChanged(idx, idx);
+        }
+    }
 }
 
 QModelIndex ForumTreeModel::index(int row, int column, const QModelIndex & parent) const
@@ -22,6 +22,9 @@ public:
     explicit ForumTreeModel(const ForumPtr root, QObject *parent = nullptr);
     ~ForumTreeModel() = default;
 
+    // repaints the rows of the given forums, ones that aren't in the model are ignored
+    void updateForums(const ForumList& forums);
+
 private:
     // Inherited via `QAbstractItemModel`
     QModelIndex index(int row, int column, const QModelIndex & parent = QModelIndex()) const override;
@@ -30,7 +33,8 @@ private:
     int columnCount(const QModelIndex & parent = QModelIndex()) const override;
     QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
 
-    std::vector<ForumPtr>   _nodes;
+    std::vector<ForumPtr>           _nodes;
+    QHash<const owl::Forum*, int>   _rows;
 };
 
 } // namespace
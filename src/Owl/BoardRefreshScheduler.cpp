@@ -0,0 +1,345 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <algorithm>
+
+#include <QtConcurrent>
+
+#include "Data/Board.h"
+#include "Data/BoardManager.h"
+#include "BoardRefreshScheduler.h"
+
+#include <Utils/OwlLogger.h>
+#include <Utils/OwlUtils.h>
+
+namespace owl
+{
+
+// how often the timer wheel ticks, in milliseconds
+static const int TICK_INTERVAL = 1000;
+
+// one turn of the wheel, in ticks
+static const std::size_t WHEEL_SLOTS = 64;
+
+// used when a board has no "refreshRate" option, in seconds
+static const std::uint32_t DEFAULT_REFRESH_RATE = 60 * 60;
+
+// bounds of the refresh interval when the board doesn't set them, as a
+// fraction and a multiple of its refresh rate. The adaptive interval stays
+// in the neighbourhood of what the user picked rather than going from one
+// minute to an hour whatever the rate
+static const std::uint32_t DEFAULT_MIN_DIVISOR = 2;
+static const std::uint32_t DEFAULT_MAX_FACTOR = 4;
+
+// how long between each structure check, in seconds
+static const qint64 STRUCTURE_CHECK_PERIOD = 60 * 60 * 24;
+
+BoardRefreshScheduler::BoardRefreshScheduler(int maxConcurrent, QObject* parent)
+    : QObject(parent),
+      _maxConcurrent(std::max(1, maxConcurrent)),
+      _wheel(WHEEL_SLOTS),
+      _logger(owl::initializeLogger("BoardRefreshScheduler"))
+{
+    _pool.setMaxThreadCount(_maxConcurrent);
+
+    _timer.setInterval(TICK_INTERVAL);
+    QObject::connect(&_timer, &QTimer::timeout, this, &BoardRefreshScheduler::tick);
+    _timer.start();
+}
+
+BoardRefreshScheduler::~BoardRefreshScheduler()
+{
+    _timer.stop();
+
+    for (auto& kv : _boards)
+    {
+        if (kv.second.token)
+        {
+            kv.second.token->cancel();
+        }
+    }
+
+    _pool.waitForDone();
+}
+
+void BoardRefreshScheduler::addBoard(BoardPtr board)
+{
+    const Key key = board->hash();
+
+    if (_boards.find(key) != _boards.end())
+    {
+        return;
+    }
+
+    _logger->debug("Scheduling refreshes of board '{}'", board->getName().toStdString());
+
+    Entry& entry = _boards[key];
+    entry.board = board;
+    entry.bReady = true;
+    entry.policy = RefreshPolicy(policyConfig(board));
+
+    _ready.push_back(key);
+    dispatch();
+}
+
+void BoardRefreshScheduler::removeBoard(BoardPtr board)
+{
+    const Key key = board->hash();
+
+    auto it = _boards.find(key);
+    if (it == _boards.end())
+    {
+        return;
+    }
+
+    if (it->second.token)
+    {
+        it->second.token->cancel();
+    }
+
+    _wheel.cancel(key);
+    _ready.erase(std::remove(_ready.begin(), _ready.end(), key), _ready.end());
+    _boards.erase(it);
+
+    _logger->debug("Stopped refreshing board '{}'", board->getName().toStdString());
+}
+
+bool BoardRefreshScheduler::contains(BoardPtr board) const
+{
+    return _boards.find(board->hash()) != _boards.end();
+}
+
+void BoardRefreshScheduler::tick()
+{
+    for (const Key key : _wheel.advance())
+    {
+        auto it = _boards.find(key);
+        if (it != _boards.end() && !it->second.bReady)
+        {
+            it->second.bReady = true;
+            _ready.push_back(key);
+        }
+    }
+
+    dispatch();
+}
+
+void BoardRefreshScheduler::dispatch()
+{
+    while (static_cast<int>(_running.size()) < _maxConcurrent)
+    {
+        // a board that was removed and added back while it was refreshing
+        // waits for the old run to stop
+        auto next = std::find_if(_ready.begin(), _ready.end(),
+            [this](Key key) { return _running.find(key) == _running.end(); });
+
+        if (next == _ready.end())
+        {
+            break;
+        }
+
+        const Key key = *next;
+        _ready.erase(next);
+
+        auto it = _boards.find(key);
+        if (it == _boards.end())
+        {
+            continue;
+        }
+
+        Entry& entry = it->second;
+        entry.bReady = false;
+
+        BoardPtr board = entry.board.lock();
+        if (!board)
+        {
+            _boards.erase(it);
+            continue;
+        }
+
+        entry.token = std::make_shared<CancellationToken>();
+        _running.insert(key);
+
+        auto watcher = new QFutureWatcher<RefreshPolicy::Outcome>(this);
+        QObject::connect(watcher, &QFutureWatcherBase::finished, this,
+            [this, key, watcher, token = entry.token]()
+            {
+                watcher->deleteLater();
+                finished(key, token, watcher->result());
+            });
+
+        watcher->setFuture(QtConcurrent::run(&_pool,
+            [this, board, token = entry.token]()
+            {
+                // the parser's operations pick the token up, see ParserBase
+                CancellationToken::Scope scope(token);
+                return refresh(board);
+            }));
+    }
+}
+
+void BoardRefreshScheduler::finished(Key key, CancellationTokenPtr token, RefreshPolicy::Outcome outcome)
+{
+    _running.erase(key);
+
+    // the board may have been removed while it was refreshing, or removed
+    // and added back in which case the entry belongs to the new board
+    auto it = _boards.find(key);
+    if (it != _boards.end() && it->second.token == token)
+    {
+        Entry& entry = it->second;
+        entry.token.reset();
+
+        if (BoardPtr board = entry.board.lock(); board)
+        {
+            // pick up changes to the board's options
+            entry.policy.setConfig(policyConfig(board));
+
+            const double jitter = owl::randomInteger(0, 1000) / 1000.0;
+            const auto next = entry.policy.update(outcome, QDateTime::currentDateTime(), jitter);
+
+            _logger->debug("Next refresh of board '{}' in {} seconds (interval {}, errors {})",
+                board->getName().toStdString(), next.count(),
+                entry.policy.getInterval().count(), entry.policy.getErrorCount());
+
+            _wheel.schedule(key, static_cast<quint64>(next.count()) * 1000 / TICK_INTERVAL);
+        }
+        else
+        {
+            _boards.erase(it);
+        }
+    }
+
+    dispatch();
+}
+
+RefreshPolicy::Config BoardRefreshScheduler::policyConfig(BoardPtr board)
+{
+    const StringMapPtr options = board->getOptions();
+
+    const auto seconds = [&options](const char* key, std::uint32_t defaultValue)
+    {
+        return RefreshPolicy::Seconds(options->has(key) ? options->get<std::uint32_t>(key) : defaultValue);
+    };
+
+    RefreshPolicy::Config config;
+    config.initialInterval = seconds("refreshRate", DEFAULT_REFRESH_RATE);
+
+    if (options->has("refresh.adaptive") && !options->getBool("refresh.adaptive", false))
+    {
+        config.minInterval = config.initialInterval;
+        config.maxInterval = config.initialInterval;
+    }
+    else
+    {
+        const auto rate = static_cast<std::uint32_t>(config.initialInterval.count());
+        config.minInterval = seconds("refresh.minInterval", std::max<std::uint32_t>(rate / DEFAULT_MIN_DIVISOR, 1));
+        config.maxInterval = seconds("refresh.maxInterval", rate * DEFAULT_MAX_FACTOR);
+    }
+
+    return config;
+}
+
+RefreshPolicy::Outcome BoardRefreshScheduler::refresh(BoardPtr board)
+{
+    const std::string boardName { board->getName().toStdString() };
+    auto outcome = RefreshPolicy::Outcome::FAILED;
+
+    try
+    {
+        _logger->debug("Refresh of board '{}' started", boardName);
+
+        outcome = board->updateUnread(true)
+            ? RefreshPolicy::Outcome::CHANGED
+            : RefreshPolicy::Outcome::UNCHANGED;
+
+        _logger->debug("Refresh of board '{}' completed", boardName);
+    }
+    catch (const TimeoutException& ex)
+    {
+        // a board that doesn't answer in time is backed off like any other error
+        _logger->error("Refresh of board '{}' timed out: {}", boardName, ex.message().toStdString());
+        return RefreshPolicy::Outcome::FAILED;
+    }
+    catch (const CancelledException&)
+    {
+        // only happens when the board is being removed, the outcome doesn't matter
+        _logger->debug("Refresh of board '{}' was cancelled", boardName);
+        return RefreshPolicy::Outcome::UNCHANGED;
+    }
+    catch (const owl::Exception& ex)
+    {
+        _logger->error("Error refreshing board '{}': {}", boardName, ex.message().toStdString());
+        return outcome;
+    }
+    catch (const std::exception& ex)
+    {
+        // anything else escaping would be rethrown by the watcher's result()
+        _logger->error("Error refreshing board '{}': {}", boardName, ex.what());
+        return RefreshPolicy::Outcome::FAILED;
+    }
+
+    try
+    {
+        checkStructureUpdate(board);
+    }
+    catch (const owl::Exception& ex)
+    {
+        _logger->error("Error checking the structure of board '{}': {}", boardName, ex.message().toStdString());
+    }
+    catch (const std::exception& ex)
+    {
+        _logger->error("Error checking the structure of board '{}': {}", boardName, ex.what());
+    }
+
+    return outcome;
+}
+
+void BoardRefreshScheduler::checkStructureUpdate(BoardPtr board)
+{
+    const QDateTime boardTime = board->getLastUpdate();
+
+    _logger->trace("Board {}({}) - last update was {}",
+        board->getName().toStdString(), board->getDBId(), boardTime.toString().toStdString());
+
+    if (boardTime.secsTo(QDateTime::currentDateTime()) < STRUCTURE_CHECK_PERIOD)
+    {
+        return;
+    }
+
+    _logger->debug("Board {}({}) - verifying forum structure",
+        board->getName().toStdString(), board->getDBId());
+
+    // compare against a copy of what's stored, the board's own tree
+    // belongs to the GUI thread
+    BoardPtr savedBoard = BOARDMANAGER->getBoardInfo(board->getDBId());
+    ForumPtr savedRoot = savedBoard->getRoot();
+
+    if (savedRoot != nullptr)
+    {
+        const ForumChangeList changes = board->syncStructure(savedRoot);
+
+        if (changes.isEmpty())
+        {
+            _logger->trace("Board {}({}) - stored structure and online structure are the same",
+                board->getName().toStdString(), board->getDBId());
+        }
+        else
+        {
+            _logger->debug("Board {}({}) - found {} change(s) in the online structure",
+                board->getName().toStdString(), board->getDBId(), changes.size());
+
+            Q_EMIT onForumStructureChanged(board, changes);
+        }
+
+        board->setLastUpdate(QDateTime::currentDateTime());
+        BOARDMANAGER->updateBoard(board);
+    }
+    else
+    {
+        _logger->warn("Board {}({}) - getBoardInfo(), getRoot() returned a 'nullptr' root",
+            board->getName().toStdString(), board->getDBId());
+    }
+}
+
+} // namespace owl
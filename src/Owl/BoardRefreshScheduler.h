@@ -0,0 +1,105 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <QtCore>
+#include <Parsers/Forum.h>
+#include <Utils/CancellationToken.h>
+#include <Utils/RefreshPolicy.h>
+#include <Utils/TimerWheel.h>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+class Board;
+using BoardPtr = std::shared_ptr<Board>;
+using BoardWeakPtr = std::weak_ptr<Board>;
+
+// Refreshes the unread forums of every signed on board, and once a day checks
+// its forum structure. The refreshes run on a small thread pool so the number
+// of threads doesn't grow with the number of boards, and at most maxConcurrent
+// boards are refreshed at once. Boards come due on a timer wheel that ticks
+// once a second.
+//
+// A board's next refresh is scheduled when its last one finishes, by a
+// RefreshPolicy that learns from how often the board's unread forums change.
+// The board options that drive it are (all in seconds):
+//
+//   refreshRate            where the interval starts out
+//   refresh.minInterval    lower bound, defaults to half of refreshRate
+//   refresh.maxInterval    upper bound, defaults to four times refreshRate
+//   refresh.adaptive       set to false to always wait refreshRate
+//
+// The scheduler must be used from the thread it lives in.
+class BoardRefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int DEFAULT_MAX_CONCURRENT = 2;
+
+    explicit BoardRefreshScheduler(int maxConcurrent = DEFAULT_MAX_CONCURRENT, QObject* parent = nullptr);
+    virtual ~BoardRefreshScheduler();
+
+    // the board is refreshed right away and then periodically until it's removed,
+    // adding a board that is already scheduled does nothing
+    void addBoard(BoardPtr board);
+
+    // a refresh that is running is cancelled, if the board is added back
+    // before it stops the new refresh waits for it
+    void removeBoard(BoardPtr board);
+
+    bool contains(BoardPtr board) const;
+
+    int getMaxConcurrent() const { return _maxConcurrent; }
+    int getRunningCount() const { return static_cast<int>(_running.size()); }
+
+Q_SIGNALS:
+    // emitted from a pool thread, the changes still have to be applied,
+    // see Board::applyStructureChanges()
+    void onForumStructureChanged(BoardPtr board, ForumChangeList changes);
+
+private:
+    using Key = TimerWheel::Key;
+
+    struct Entry
+    {
+        BoardWeakPtr            board;
+        CancellationTokenPtr    token;          // set while the board is being refreshed, identifies the run
+        bool                    bReady = false; // due and waiting for a free slot
+        RefreshPolicy           policy;
+    };
+
+    static RefreshPolicy::Config policyConfig(BoardPtr board);
+
+    void tick();
+    void dispatch();
+    void finished(Key key, CancellationTokenPtr token, RefreshPolicy::Outcome outcome);
+
+    // run on the pool
+    RefreshPolicy::Outcome refresh(BoardPtr board);
+    void checkStructureUpdate(BoardPtr board);
+
+    const int                   _maxConcurrent;
+    std::set<Key>               _running;       // boards with a refresh on the pool, even removed ones
+
+    QThreadPool                 _pool;
+    QTimer                      _timer;
+    TimerWheel                  _wheel;
+
+    std::map<Key, Entry>        _boards;
+    std::deque<Key>             _ready;
+
+    std::shared_ptr<spdlog::logger>  _logger;
+};
+
+} // namespace owl
@@ -1,4 +1,5 @@
 #include "BoardsModel.h"
+#include "Data/BoardManager.h"
 #include <Utils/OwlLogger.h>
 
 namespace owl
@@ -82,7 +83,8 @@ const uint BoardsModel::ITEMHEIGHT = 24;
 BoardsModel::BoardsModel(QWidget* parent)
     : QStandardItemModel(parent)
 {
-    // do nothing
+    QObject::connect(BoardManager::instance().get(), &BoardManager::onForumStructureChanged,
+        this, &BoardsModel::applyForumChanges);
 }
 
 BoardsModel::~BoardsModel()
@@ -155,6 +157,9 @@ QStandardItem* BoardsModel::addBoardItem(const BoardPtr& b, bool bThrowOnFail)
                 addForums(b, forum);
             }
 
+            QObject::connect(b.get(), &Board::onUnreadForumsChanged,
+                this, &BoardsModel::updateUnreadForums);
+
             // insert a last item object so that we can properly paint the servcesTree
             QStandardItem* lastItem(new QStandardItem());
             lastItem->setData(true, LASTITEM_ROLE);
@@ -254,19 +259,7 @@ void BoardsModel::addForums(BoardPtr board, ForumPtr forum)
         parentItem->appendRow(subItem);
     }
 
-    if (forum->getForumType() == Forum::FORUM)
-    {
-        subItem->setIcon(QIcon(":/icons/forum.png"));
-    }
-    else if (forum->getForumType() == Forum::CATEGORY)
-    {
-        subItem->setIcon(QIcon(":/icons/category.png"));
-        subItem->setFlags(Qt::ItemIsEnabled);
-    }
-    else if (forum->getForumType() == Forum::LINK)
-    {
-        subItem->setIcon(QIcon(":/icons/link.png"));
-    }
+    setForumItemType(subItem, forum);
 
     subItem->setData(QVariant::fromValue(forum));
     subItem->setSizeHint(QSize(subItem->sizeHint().width(), ITEMHEIGHT));
@@ -348,6 +341,134 @@ QStandardItem* BoardsModel::updateForumItem(BoardPtr b, ForumPtr forum)
     return parentItem;
 }
 
+void BoardsModel::setForumItemType(QStandardItem* item, ForumPtr forum)
+{
+    if (forum->getForumType() == Forum::FORUM)
+    {
+        item->setIcon(QIcon(":/icons/forum.png"));
+    }
+    else if (forum->getForumType() == Forum::CATEGORY)
+    {
+        item->setIcon(QIcon(":/icons/category.png"));
+        item->setFlags(Qt::ItemIsEnabled);
+    }
+    else if (forum->getForumType() == Forum::LINK)
+    {
+        item->setIcon(QIcon(":/icons/link.png"));
+    }
+}
+
+void BoardsModel::removeForumItem(BoardPtr board, ForumPtr forum)
+{
+    for (ForumPtr child : forum->getForums())
+    {
+        removeForumItem(board, child);
+    }
+
+    QStandardItem* item = _index.take(getIndexKey(board, forum));
+    if (item != nullptr)
+    {
+        // top level forums hang off the board's item
+        QStandardItem* parentItem = item->parent() != nullptr ? item->parent() : invisibleRootItem();
+        parentItem->removeRow(item->row());
+    }
+}
+
+void BoardsModel::updateUnreadForums(BoardPtr b, const ForumList& becameUnread, const ForumList& becameRead)
+{
+    QMutexLocker locker(&_indexMutex);
+
+    for (const ForumList* list : { &becameUnread, &becameRead })
+    {
+        for (const ForumPtr& forum : *list)
+        {
+            QStandardItem* item = _index.value(getIndexKey(b, forum));
+            if (item != nullptr && forum->getForumType() == Forum::FORUM)
+            {
+                item->setIcon(QIcon(forum->hasUnread()
+                    ? ":/icons/forum_new.png"
+                    : ":/icons/forum.png"));
+            }
+        }
+    }
+}
+
+void BoardsModel::applyForumChanges(BoardPtr b, const ForumChangeList& changes)
+{
+    QMutexLocker locker(&_indexMutex);
+    QStringList parentIds;
+
+    for (const ForumChange& change : changes)
+    {
+        if (change.type == ForumChange::ADDED)
+        {
+            addForums(b, change.forum);
+        }
+        else if (change.type == ForumChange::REMOVED)
+        {
+            // the stored forum, its sub forums are the ones that had rows
+            removeForumItem(b, change.forum);
+        }
+        else if (change.type == ForumChange::RENAMED)
+        {
+            QStandardItem* item = _index.value(getIndexKey(b, change.forum));
+            if (item != nullptr)
+            {
+                QTextDocument doc;
+                doc.setHtml(change.forum->getName());
+
+                item->setText(doc.toPlainText());
+
+                // a category that became a forum has to be selectable again
+                item->setFlags(QStandardItem().flags());
+                setForumItemType(item, change.forum);
+            }
+        }
+
+        if (!parentIds.contains(change.parentId))
+        {
+            parentIds.push_back(change.parentId);
+        }
+    }
+
+    // added rows were appended and others may have moved, so put the rows of
+    // every parent that changed back in the order of the board's tree
+    for (const QString& parentId : parentIds)
+    {
+        const ForumPtr parent = b->getForumHash().value(parentId);
+        if (!parent)
+        {
+            continue;
+        }
+
+        QStandardItem* parentItem = parent->IsRoot()
+            ? getBoardItem(b)
+            : _index.value(getIndexKey(b, parent));
+
+        if (parentItem == nullptr)
+        {
+            continue;
+        }
+
+        int row = 0;
+        for (ForumPtr child : parent->getForums())
+        {
+            QStandardItem* item = _index.value(getIndexKey(b, child));
+            if (item == nullptr || item->parent() != parentItem)
+            {
+                continue;
+            }
+
+            if (item->row() != row)
+            {
+                parentItem->insertRow(row, parentItem->takeRow(item->row()));
+            }
+
+            row++;
+        }
+    }
+}
+
 QStandardItem* BoardsModel::getBoardItem(BoardPtr board, bool bThrowOnFail /*= true*/)
 {
     QStandardItem* ret(nullptr);
@@ -30,6 +30,14 @@ public:
 	// returns the parent item updated
 	QStandardItem* updateForumItem(BoardPtr b, ForumPtr f);
 
+	// updates only the rows affected by changes that have been applied to the
+	// board with Board::applyStructureChanges()
+	void applyForumChanges(BoardPtr b, const ForumChangeList& changes);
+
+	// updates only the rows of forums whose unread state changed, connected
+	// to Board::onUnreadForumsChanged() of every board in the model
+	void updateUnreadForums(BoardPtr b, const ForumList& becameUnread, const ForumList& becameRead);
+
     QStandardItem* addBoardItem(const BoardPtr& b, bool bThrowOnFail = false);
 	QStandardItem* getBoardItem(BoardPtr b, bool bThrowOnFail = true);
 	void removeBoardItem(BoardPtr b);
@@ -41,6 +49,8 @@ public:
 
 private: 
 	void addForums(BoardPtr board, ForumPtr forum);
+	void setForumItemType(QStandardItem* item, ForumPtr forum);
+	void removeForumItem(BoardPtr board, ForumPtr forum);
 	QStandardItem* doGetForumItem(QStandardItem* parentItem, ForumPtr f);
 
 	QHash<QString, QStandardItem*>      _index;
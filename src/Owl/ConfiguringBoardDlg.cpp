@@ -391,7 +391,16 @@ owl::StringMap ConfiguringBoardDlg::createBoard(const QString& parserName, const
         _logger->info("Crawling new board '{}' ({})",
             _newBoard->getName().toStdString(), _newBoard->getUrl().toStdString());
 
+        // progress arrives from the crawler's threads, statusLbl as the context queues it to the UI
+        auto progress = QObject::connect(_newBoard.get(), &Board::onCrawlProgress, statusLbl,
+            [this](BoardPtr, int fetched, int discovered)
+            {
+                statusLbl->setText(tr("Login successful. Retrieving forum list (%1 of %2)...")
+                    .arg(fetched).arg(discovered));
+            });
+
 		_newBoard->crawlRoot();
+        QObject::disconnect(progress);
 
 		if (_newBoard->getRoot()->getForums().size() > 0)
 		{
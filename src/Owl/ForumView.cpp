@@ -370,4 +370,16 @@ void ForumView::doBoardClicked(const owl::BoardWeakPtr boardWeakPtr)
     Q_EMIT onForumListLoaded();
 }
 
+void ForumView::updateUnreadForums(owl::BoardPtr board, const owl::ForumList& forums)
+{
+    // a board that isn't cached gets a fresh model, and so its current
+    // flags, the next time it's clicked
+    if (_rootCache.contains(board->hash()))
+    {
+        auto& [expiry, cacheModel] = *(_rootCache.object(board->hash()));
+        Q_UNUSED(expiry);
+        cacheModel->updateForums(forums);
+    }
+}
+
 } // namespace
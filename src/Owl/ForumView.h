@@ -60,6 +60,9 @@ public:
 
      void doBoardClicked(const owl::BoardWeakPtr);
 
+     // repaints the given forums if the board's list is loaded
+     void updateUnreadForums(owl::BoardPtr board, const owl::ForumList& forums);
+
 Q_SIGNALS:
      void onForumClicked(owl::ForumPtr);
      void onForumListLoaded();
@@ -15,7 +15,7 @@
 #include "QuickAddDlg.h"
 #include "Core.h"
 #include "MainWindow.h"
-#include "BoardUpdateWorker.h"
+#include "BoardRefreshScheduler.h"
 
 #ifdef Q_OS_WIN
 #include "windows.h"
@@ -93,6 +93,10 @@ MainWindow::MainWindow(SplashScreen *splash, QWidget *parent)
     this->centralWidget()->setMaximumWidth(CENTRALWIDGETWIDTH);
     this->centralWidget()->setMinimumWidth(CENTRALWIDGETWIDTH);
 
+    _refreshScheduler = new BoardRefreshScheduler(BoardRefreshScheduler::DEFAULT_MAX_CONCURRENT, this);
+    QObject::connect(_refreshScheduler, &BoardRefreshScheduler::onForumStructureChanged,
+        this, &MainWindow::onForumStructureChanged, Qt::QueuedConnection);
+
     // TODO: move this to the OwlApplication class
     readWindowSettings();
     
@@ -296,9 +300,6 @@ bool MainWindow::initBoard(const BoardPtr& b)
             boardAction->setMenu(boardMenu);
             boardToolbar->addAction(boardAction);
 
-            // lastly start thr worker thread
-            _workerMap.insert(b->hash(), new QThreadEx());
-
             ok = true;
         }
     }
@@ -384,6 +385,16 @@ void MainWindow::closeEvent(QCloseEvent *event)
 {
     _logger->debug("Closing Owl window");
     writeWindowSettings();
+
+    // sessions may have been refreshed since login so save them again for the next run
+    for (const BoardPtr& b : BOARDMANAGER->getBoardList())
+    {
+        if (b->getStatus() == BoardStatus::ONLINE)
+        {
+            b->saveSession();
+        }
+    }
+
     QMainWindow::closeEvent(event);
 }
 
@@ -427,34 +438,14 @@ void MainWindow::boardwareInfoEvent(BoardPtr b, StringMap sp)
         b->getName().toStdString(), bn.toStdString(), bv.toStdString());
 }
     
-void MainWindow::onForumStructureChanged(BoardPtr b)
+void MainWindow::onForumStructureChanged(BoardPtr b, ForumChangeList changes)
 {
-    if (qApp->activeModalWidget() == nullptr)
-    {
-        QString strTitle = QString("Forum '%1' Needs to be Updated").arg(b->getName());
+    _logger->info("Forum structure of board '{}' changed, applying {} change(s)",
+        b->getName().toStdString(), changes.size());
 
-        QString strMsg = QString(
-            "The message board '%1' has changed. You must remove the board "
-            "and add it back to Owl to see the changes.")
-            .arg(b->getName());
-
-        QMessageBox* msgBox = new QMessageBox(
-            QMessageBox::Information,
-            strTitle,
-            strMsg,
-            QMessageBox::Ok,
-            this,
-            Qt::Sheet);
-
-        QString strDetails("The message board referenced above has been changed. Common changes include the message board administrator "
-            "adding new forums, removing existing forums, or renaming a forum. These changes will not be reflected in Owl until you remove "
-            "and add the board back to Owl. Note: Future versions of Owl will provide this functionality automatically.");
-
-        msgBox->setDetailedText(strDetails);
-
-        _logger->debug("Forum structure changed: {}", strMsg.toStdString());
-        msgBox->open();
-    }
+    // the tree first, BoardManager looks up the parents of the changes in it
+    b->applyStructureChanges(changes);
+    BOARDMANAGER->updateForumStructure(b, changes);
 }
 
 void MainWindow::loginEvent(BoardPtr b, const StringMap& sp)
@@ -469,39 +460,7 @@ void MainWindow::loginEvent(BoardPtr b, const StringMap& sp)
     
     if (sp.getBool("success"))
     {
-        if (_workerMap.contains(b->hash()))
-        {
-            QThreadEx* workerThread = _workerMap.value(b->hash());
-            
-            const QString threadName = QString("%1:%2:%3")
-                .arg(b->getName()).arg(b->getServiceUrl()).arg(b->hash());
-            workerThread->setObjectName(threadName);
-
-            BoardUpdateWorker* pWorker = new BoardUpdateWorker(b);
-            pWorker->moveToThread(workerThread);
-
-            QObject::connect(pWorker, &BoardUpdateWorker::onForumStructureChanged,
-                [this](BoardPtr board)
-                {
-                    QMetaObject::invokeMethod(this, "onForumStructureChanged", Q_ARG(owl::BoardPtr, board));
-                });
-
-            QObject::connect(workerThread, &QThread::started,
-                [pWorker]()
-                {
-                    QMetaObject::invokeMethod(pWorker, "doWork");
-                });
-
-            QObject::connect(workerThread, &QThread::finished, 
-                [workerThread, pWorker]()
-                {
-                    pWorker->setIsDone(true);
-                    pWorker->deleteLater();
-                    workerThread->deleteLater();
-                });
-
-            workerThread->start();
-        }
+        _refreshScheduler->addBoard(b);
 
         msg = QString(tr("User %1 signed on %2"))
             .arg(b->getUsername())
@@ -565,14 +524,15 @@ void MainWindow::getThreadsHandler(BoardPtr /*b*/, ForumPtr forum)
     contentView->doShowListOfThreads(forum);
 }
 
-// SLOT: handles the SIGNAL from a Board object. Called when the board responds 
-// from a request to get a (flat) list of all forums with unread posts
-// NOTE: duplicates should be removed before the list is handed to 
-// this function
-void MainWindow::getUnreadForumsEvent(BoardPtr board, ForumList list)
+// SLOT: handles the SIGNAL from a Board object. Called when the unread state
+// of some of the board's forums changed, only those forums are repainted
+void MainWindow::unreadForumsChangedEvent(BoardPtr board, ForumList becameUnread, ForumList becameRead)
 {
-    _logger->debug("unread forum list retrieved for '{}' with {} forums", board->readableHash(), list.size());
+    _logger->debug("unread forums changed for '{}', {} unread and {} read",
+        board->readableHash(), becameUnread.size(), becameRead.size());
+
     boardIconPanel->update();
+    threadListWidget2->updateUnreadForums(board, becameUnread + becameRead);
 }
 
 void MainWindow::onNewBoard()
@@ -610,7 +570,7 @@ void MainWindow::connectBoard(BoardPtr board)
     connect(board.get(), SIGNAL(onLogin(BoardPtr, StringMap)),this, SLOT(loginEvent(BoardPtr, StringMap)));
     connect(board.get(), SIGNAL(onGetThreads(BoardPtr, ForumPtr)), this, SLOT(getThreadsHandler(BoardPtr, ForumPtr)));
     connect(board.get(), SIGNAL(onGetPosts(BoardPtr, ThreadPtr)), this, SLOT(getPostsHandler(BoardPtr, ThreadPtr)));
-    connect(board.get(), SIGNAL(onGetUnreadForums(BoardPtr, ForumList)), this, SLOT(getUnreadForumsEvent(BoardPtr, ForumList)));
+    connect(board.get(), SIGNAL(onUnreadForumsChanged(BoardPtr, ForumList, ForumList)), this, SLOT(unreadForumsChangedEvent(BoardPtr, ForumList, ForumList)));
     connect(board.get(), SIGNAL(onMarkedForumRead(BoardPtr, ForumPtr)), this, SLOT(markForumReadHandler(BoardPtr, ForumPtr)));
     connect(board.get(), SIGNAL(onNewThread(BoardPtr, ThreadPtr)), this, SLOT(newThreadHandler(BoardPtr, ThreadPtr)));
     connect(board.get(), SIGNAL(onNewPost(BoardPtr, PostPtr)), this, SLOT(newPostHandler(BoardPtr, PostPtr)));
@@ -1567,14 +1527,7 @@ void MainWindow::createBoardPanel()
             BoardPtr board = bwp.lock();
             if (board)
             {
-                QThreadEx* thread = _workerMap.value(board->hash());
-                Q_ASSERT(thread);
-                thread->exit();
-
-                // NOTE: More of Qt's lifetime management, this will, in fact, delete
-                // the `BoardUpdateWorker` and `QThreadEx` objects that are in the
-                // `_workerMap`
-                _workerMap.remove(board->hash());
+                _refreshScheduler->removeBoard(board);
 
                 // delete the board from the toolbar
                 auto actionList = boardToolbar->actions();
@@ -1778,10 +1731,7 @@ void MainWindow::onBoardDelete()
 void MainWindow::onBoardDelete(BoardPtr b)
 {
     // stop any pending requests
-    QThread* thread = _workerMap.value(b->hash());
-    thread->exit();
-
-    _workerMap.remove(b->hash());
+    _refreshScheduler->removeBoard(b);
 
     // search the toolbar (top of the client) and
     // remove the board icon
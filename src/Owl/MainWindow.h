@@ -4,7 +4,6 @@
 #include <QtWidgets>
 #include <Parsers/ParserManager.h>
 #include <Utils/Exception.h>
-#include <Utils/QThreadEx.h>
 #include "Data/BoardManager.h"
 #include "NewThreadDlg.h"
 #include "AspectRatioPixmapLabel.h"
@@ -25,12 +24,10 @@ namespace Ui
 namespace owl
 {
 
+class BoardRefreshScheduler;
 class ErrorReportDlg;
 class QuickAddDlg;
 
-// uint - DB Id
-typedef QHash<std::size_t, QThreadEx*> WorkerMap;
-
 typedef QList<QPair<QString, QString> > UrlQueryItems;
 
 typedef std::function<void (const UrlQueryItems&)> LinkHandler;
@@ -224,7 +221,7 @@ private Q_SLOTS:
 	// handlers
 	void boardwareInfoEvent(BoardPtr, StringMap);
     void loginEvent(BoardPtr, const StringMap&);
-	void getUnreadForumsEvent(BoardPtr, ForumList);
+	void unreadForumsChangedEvent(BoardPtr, ForumList, ForumList);
 
 	void getThreadsHandler(BoardPtr, ForumPtr);
 	void getPostsHandler(BoardPtr, ThreadPtr);
@@ -241,7 +238,7 @@ private Q_SLOTS:
 
 	void onCopyUrl();
     
-    void onForumStructureChanged(BoardPtr);
+    void onForumStructureChanged(BoardPtr, ForumChangeList);
 	void onDisplayOrderChanged(BoardPtr, int);
 
 private:
@@ -293,8 +290,8 @@ private:
     // TODO: ensure this is a good model for mutexes
     QMutex _updateMutex;
 
-    // map of threads for each board
-    WorkerMap       _workerMap;
+    // refreshes the boards that are signed on
+    BoardRefreshScheduler*  _refreshScheduler = nullptr;
 
 
     MenuActions     _actions;
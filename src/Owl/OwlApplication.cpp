@@ -4,8 +4,10 @@
 #include <QtQml>
 #include <QSysInfo>
 #include <Parsers/ParserManager.h>
+#include <Utils/CookieStore.h>
 #include <Utils/Settings.h>
 #include <Utils/OwlUtils.h>
+#include <Utils/WebCache.h>
 #include "ErrorReportDlg.h"
 #include "Core.h"
 #include "OwlApplication.h"
@@ -63,6 +65,12 @@ static void loadDefaultSettings(SettingsFilePtr settings)
 
     const QString defaultAgent = QString("Mozilla/5.0 Firefox/3.5.6 %1 / %2").arg(APP_NAME).arg(OWL_VERSION);
     root->write("web.useragent", defaultAgent);
+    // opt-in, it keeps pages on disk
+    root->write("web.cache.enabled", false);
+    root->write("web.cache.path",
+                QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("webcache"));
+    root->write("web.cache.maxsize", 256); // megabytes, 0 is unlimited
+    root->write("web.sessions.enabled", true);
 
     root->write("boardlist.icons.visible", true);
     root->write("boardlist.background.color", "#444444");
@@ -139,6 +147,7 @@ void registerMetaTypes()
 
     qRegisterMetaType<owl::ForumPtr>("ForumPtr");
     qRegisterMetaType<owl::ForumList>("ForumList");
+    qRegisterMetaType<owl::ForumChangeList>("ForumChangeList");
 
     qRegisterMetaType<owl::ThreadPtr>("ThreadPtr");
     qRegisterMetaType<owl::ThreadList>("ThreadList");
@@ -221,8 +230,32 @@ void OwlApplication::init()
         OWL_THROW_EXCEPTION(owl::Exception(msg));
     }
 
-    // load the native and Lua parsers
     SettingsObject object;
+
+    // initialize the on-disk cache of web responses
+    if (object.read("web.cache.enabled").toBool())
+    {
+        WebCache::instance().setMaxSize(object.read("web.cache.maxsize").toLongLong() * 1024 * 1024);
+        WebCache::instance().setPath(object.read("web.cache.path").toString());
+    }
+
+    // boards' sessions are kept next to the database so they survive a restart,
+    // web.sessions.key only obfuscates them since it is stored right here in
+    // the settings, see CookieStore
+    if (object.read("web.sessions.enabled").toBool(true))
+    {
+        QByteArray key = QByteArray::fromBase64(object.read("web.sessions.key").toString().toLatin1());
+        if (key.isEmpty())
+        {
+            key = CookieStore::generateKey();
+            object.write("web.sessions.key", QString::fromLatin1(key.toBase64()));
+        }
+
+        CookieStore::instance().setKey(key);
+        CookieStore::instance().setPath(QFileInfo(_dbFileName).absoluteDir().filePath(QStringLiteral("sessions")));
+    }
+
+    // load the native and Lua parsers
     const bool parsersEnabled = object.read("parsers.enabled").toBool();
     if (parsersEnabled)
     {
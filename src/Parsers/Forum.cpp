@@ -188,6 +188,66 @@ bool Forum::isStructureEqual(std::shared_ptr<Forum> other)
 	return isStructureEqual(*other);
 }
 
+QString Forum::fingerprint(const ForumList& forums)
+{
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    for (const ForumPtr& forum : forums)
+    {
+        stream << forum->getId()
+            << forum->getName()
+            << static_cast<qint32>(forum->getForumType())
+            << static_cast<qint32>(forum->getDisplayOrder());
+    }
+
+    return QString::fromLatin1(QCryptographicHash::hash(buffer, QCryptographicHash::Sha1).toHex());
+}
+
+ForumChangeList Forum::diffForums(const QString& parentId, const ForumList& stored, const ForumList& current)
+{
+    ForumChangeList retval;
+
+    QHash<QString, ForumPtr> storedById;
+    for (const ForumPtr& forum : stored)
+    {
+        storedById.insert(forum->getId(), forum);
+    }
+
+    QSet<QString> currentIds;
+    for (const ForumPtr& forum : current)
+    {
+        currentIds.insert(forum->getId());
+
+        const ForumPtr previous = storedById.value(forum->getId());
+        if (!previous)
+        {
+            retval.push_back(ForumChange { ForumChange::ADDED, parentId, forum });
+            continue;
+        }
+
+        if (previous->getName() != forum->getName() || previous->getForumType() != forum->getForumType())
+        {
+            retval.push_back(ForumChange { ForumChange::RENAMED, parentId, forum });
+        }
+
+        if (previous->getDisplayOrder() != forum->getDisplayOrder())
+        {
+            retval.push_back(ForumChange { ForumChange::REORDERED, parentId, forum });
+        }
+    }
+
+    for (const ForumPtr& forum : stored)
+    {
+        if (!currentIds.contains(forum->getId()))
+        {
+            retval.push_back(ForumChange { ForumChange::REMOVED, parentId, forum });
+        }
+    }
+
+    return retval;
+}
+
 BoardItemPtr BoardItem::addChild(BoardItemPtr child, bool bThrow /*= true*/)
 {
 	QMutexLocker lock(&_childLock);
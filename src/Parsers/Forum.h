@@ -32,6 +32,9 @@ class Forum;
 typedef std::shared_ptr<owl::Forum> ForumPtr;
 typedef QList<ForumPtr> ForumList;
 
+struct ForumChange;
+typedef QList<ForumChange> ForumChangeList;
+
 struct DateTimeFormatOptions;
 
 class TagList : public QStringList
@@ -389,6 +392,18 @@ public:
 	virtual bool isStructureEqual(Forum& other);
     virtual bool isStructureEqual(std::shared_ptr<Forum> other);
 
+    // hashes the id, name, type and display order of each forum in the list,
+    // two lists with the same fingerprint hold the same forums in the same order
+    static QString fingerprint(const ForumList& forums);
+
+    // fingerprint of this forum's sub forums as they were last saved
+    void setFingerprint(const QString& var) { _fingerprint = var; }
+    const QString& getFingerprint() const { return _fingerprint; }
+
+    // returns what changed between the `stored` and `current` sub forums of
+    // `parentId`, forums are matched by their id
+    static ForumChangeList diffForums(const QString& parentId, const ForumList& stored, const ForumList& current);
+
 	virtual bool operator==(Forum& other)
 	{
 		return getId() == other.getId() 
@@ -413,9 +428,28 @@ private:
     QList<std::shared_ptr<Forum> >	_forums;
     QList<std::shared_ptr<Thread> >   _threads;
 
+    QString     _fingerprint;
+
 	QStandardItem* _modelItem;
 };
 
+// a single difference between the stored forum structure of a board and the
+// structure on the board itself
+struct ForumChange
+{
+    typedef enum
+    {
+        ADDED,      // `forum` is new, along with all of its sub forums
+        REMOVED,    // `forum` is the stored forum, its sub forums are gone too
+        RENAMED,    // the name or the type of `forum` changed
+        REORDERED   // the display order of `forum` changed
+    } ChangeType;
+
+    ChangeType  type;
+    QString     parentId;
+    ForumPtr    forum;
+};
+
 } // namespace owl
 
 Q_DECLARE_METATYPE(owl::PostPtr)
@@ -424,3 +458,4 @@ Q_DECLARE_METATYPE(owl::ThreadPtr)
 Q_DECLARE_METATYPE(owl::ThreadList)
 Q_DECLARE_METATYPE(owl::ForumPtr)
 Q_DECLARE_METATYPE(owl::ForumList)
+Q_DECLARE_METATYPE(owl::ForumChangeList)
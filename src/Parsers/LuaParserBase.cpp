@@ -1,3 +1,6 @@
+#include <algorithm>
+
+#include "../Utils/CancellationToken.h"
 #include "../Utils/OwlUtils.h"
 #include "../Utils/OwlLogger.h"
 #include "OwlLua.h"
@@ -6,16 +9,23 @@
 namespace owl
 {
 
+// how many Lua VM instructions run between checks of the CancellationToken
+const int CANCELLATION_HOOK_COUNT = 1000;
+
 LuaParserBase::LuaParserBase(const QString& url, const QString& luaFile)
 	: ParserBase("#luaparser", "#luaparser", url),
 	  _strLuaFile(luaFile),
+      _state(std::make_shared<LuaParserState>()),
 	  _stateObjIdx(0),
-      L(luaL_newstate()),
+      L(_state->L),
+      _stateMutex(_state, &_state->mutex),
       _logger(owl::initializeLogger("LuaParserBase"))
 {
-    _stateMutex = std::make_shared<std::mutex>();
 	luaL_openlibs(L);
 
+    // lets a script that is stuck in a loop be stopped when its operation is cancelled
+    lua_sethook(L, &LuaParserBase::cancellationHook, LUA_MASKCOUNT, CANCELLATION_HOOK_COUNT);
+
 	// store a reference to 'this' as a global variable so we
 	// can reference it later
 	lua_newtable(L); 
@@ -67,14 +77,56 @@ LuaParserBase::LuaParserBase(const QString& url, const QString& luaFile)
 
 	// store the lua state
 	_stateObjIdx = luaL_ref(L, LUA_REGISTRYINDEX);
+    _state->objIdx = _stateObjIdx;
+    _state->parsers.push_back(this);
+}
+
+LuaParserBase::LuaParserBase(const QString& url, const QString& luaFile, LuaParserStatePtr state)
+    : ParserBase("#luaparser", "#luaparser", url),
+      _strLuaFile(luaFile),
+      _state(std::move(state)),
+      _stateObjIdx(_state->objIdx),
+      L(_state->L),
+      _stateMutex(_state, &_state->mutex),
+      _logger(owl::initializeLogger("LuaParserBase"))
+{
+    std::lock_guard<std::mutex> locker(*_stateMutex);
+    _state->parsers.push_back(this);
 }
 
 LuaParserBase::~LuaParserBase()
-{   
-    // HACK: the Lua state needs to be closed when prudent!
-    if (_doCloseState)
+{
+    // running work uses the Lua state and holds its mutex
+    shutdown();
+
+    std::lock_guard<std::mutex> locker(*_stateMutex);
+
+    auto& parsers = _state->parsers;
+    parsers.erase(std::remove(parsers.begin(), parsers.end(), this), parsers.end());
+
+    // the script's webclients find their parser through `__parserObj`, so it
+    // is handed to a parser that is still around. The state itself is closed
+    // by the last one when its _state is released.
+    if (!parsers.empty())
     {
-        lua_close(L);
+        lua_pushlightuserdata(L, static_cast<void*>(parsers.front()));
+        lua_setglobal(L, "__parserObj");
+    }
+}
+
+void LuaParserBase::cancellationHook(lua_State* L, lua_Debug*)
+{
+    bool bCancelled = false;
+
+    {
+        // luaL_error() doesn't return, so the token can't still be held when it's called
+        const auto token = CancellationToken::current();
+        bCancelled = token && token->isCancelled();
+    }
+
+    if (bCancelled)
+    {
+        luaL_error(L, "operation cancelled");
     }
 }
 
@@ -263,20 +315,18 @@ ParserBasePtr LuaParserBase::clone(ParserBasePtr other)
 {
     // NOTE: There is no need to set the WebClient's CookieJar since
     // a clone will use the *SAME* Lua-state as the original object
-    // and therefor the same WebClient object (and cookie jar)
-    LuaParserBasePtr retval = std::make_shared<LuaParserBase>(getBaseUrl(), _strLuaFile);
+    // and therefor the same WebClient object (and cookie jar). Attaching
+    // to the state also means the script isn't loaded and run again.
+    LuaParserBasePtr retval { new LuaParserBase(getBaseUrl(), _strLuaFile, _state) };
     ParserBase::clone(retval);
 
     retval->_dtParser = _dtParser;
-    retval->_stateObjIdx = _stateObjIdx;
-    retval->L = L;
 
-    // make sure we don't close the singleton Lua state when this object is destroryed
-    retval->_doCloseState = false;
-
-    // delete the old LuaState mutex and assign ours
-    retval->_stateMutex.reset();
-    retval->_stateMutex = _stateMutex;
+    // these were read from the script's globals when the state was created
+    for (const char* key : { "boardware", "boardwaremax", "boardwaremin" })
+    {
+        retval->_options->add(key, _options->getText(key, false));
+    }
 
     return retval;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <mutex>
+#include <vector>
 #include <setjmp.h>
 #include <QtCore>
 #include <lua/lua.hpp>
@@ -20,11 +21,37 @@ namespace owl
 
 class LuaParserBase;
 class LuaParserException;
+struct LuaParserState;
 
 using LuaParserBasePtr = std::shared_ptr<LuaParserBase>;
 using LuaParserExceptionPtr = std::shared_ptr<LuaParserException>;
+using LuaParserStatePtr = std::shared_ptr<LuaParserState>;
 using MutexPtr = std::shared_ptr<std::mutex>;
 
+// The Lua state a parser's script runs in. A parser and its clones share the
+// same state, and so the same script objects and cookies, and it is closed
+// when the last of them is destroyed.
+struct LuaParserState
+{
+    lua_State*                      L;
+    int                             objIdx = 0;     // registry index of the script's parser object
+    std::mutex                      mutex;
+    std::vector<LuaParserBase*>     parsers;        // `__parserObj` is always one of these
+
+    LuaParserState()
+        : L(luaL_newstate())
+    {
+    }
+
+    ~LuaParserState()
+    {
+        lua_close(L);
+    }
+
+    LuaParserState(const LuaParserState&) = delete;
+    LuaParserState& operator=(const LuaParserState&) = delete;
+};
+
 // TODO: see if we need to pass the lua_State
 class LuaParserException : public Exception
 {
@@ -110,18 +137,24 @@ protected:
     virtual QVariant doGetEncryptionSettings() override;
 
 private:
+    // used by clone(), attaches to the state of an existing parser
+    LuaParserBase(const QString& url, const QString& luaFile, LuaParserStatePtr state);
+
+    // Lua count hook that stops a script once its operation's CancellationToken is cancelled
+    static void cancellationHook(lua_State* L, lua_Debug* ar);
+
 	void registerFunctions();
 	StringMap tableToParams(int tablePos);
     QString getItemUrlHelper(const QString &funcName, const QString itemId);
 
 	DateTimeParser	_dtParser;
 
-    QString         _strLuaFile;
-    int             _stateObjIdx;
-    bool            _doCloseState = true;
+    QString             _strLuaFile;
 
-    lua_State*      L;
-    MutexPtr        _stateMutex;
+    LuaParserStatePtr   _state;
+    int                 _stateObjIdx;
+    lua_State*          L;
+    MutexPtr            _stateMutex;    // points into _state
 
     std::shared_ptr<spdlog::logger>  _logger;
 };
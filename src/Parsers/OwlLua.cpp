@@ -6,6 +6,26 @@
 
 namespace owl
 {
+
+namespace
+{
+
+// pushes the body as it came over the wire, a round trip through QString
+// would copy it twice and mangle anything that isn't Latin-1
+void pushReply(lua_State* L, const WebClient::ReplyPtr& reply)
+{
+    if (reply)
+    {
+        const auto body = reply->view();
+        lua_pushlstring(L, body.data(), body.size());
+    }
+    else
+    {
+        lua_pushstring(L, "");
+    }
+}
+
+} // namespace
 	
 StringMap OwlLua::tableToParams(lua_State* L, int tablePos)
 {
@@ -84,7 +104,7 @@ int OwlLua::doCDebug(lua_State* L)
 int OwlLua::getWebPage(lua_State* L)
 {
     WebClient	client;
-	QString		pageSrc;
+	WebClient::ReplyPtr reply;
 	int			status = 200;
 	bool		bIsError = false;
 	QString strUrl(luaL_checkstring(L, 1));
@@ -100,11 +120,11 @@ int OwlLua::getWebPage(lua_State* L)
 	{
 		if (strMethod == "GET")
 		{
-			pageSrc = client.DownloadString(strUrl);
+			reply = client.GetUrl(strUrl);
 		}
 		else if (strMethod == "POST")
 		{
-			pageSrc = client.UploadString(strUrl, strPostData);
+			reply = client.PostUrl(strUrl, strPostData);
 		}
 		else
 		{
@@ -118,7 +138,7 @@ int OwlLua::getWebPage(lua_State* L)
 		status = ex.statuscode();
 	}
 
-	lua_pushstring(L, pageSrc.toLatin1());
+	pushReply(L, reply);
 	lua_pushnumber(L, status);
 	lua_pushboolean(L, bIsError);
 
@@ -231,13 +251,13 @@ int OwlLua::WebClientGet(lua_State* L)
         options = WebClient::NOCACHE;
 	}
 
-	QString		pageSrc;
+	WebClient::ReplyPtr reply;
 	int			status = 200;
 	bool		bIsError = false;
 
 	try
 	{
-		pageSrc = client->DownloadString(url, options);
+		reply = client->GetUrl(url, options);
 	}
 	catch (const WebException& ex)
 	{
@@ -245,7 +265,7 @@ int OwlLua::WebClientGet(lua_State* L)
 		status = ex.statuscode();
 	}
 
-	lua_pushstring(L, pageSrc.toLatin1());
+	pushReply(L, reply);
 	lua_pushnumber(L, status);
 	lua_pushboolean(L, bIsError);
 	lua_gc(L, LUA_GCCOLLECT, 0);
@@ -260,15 +280,15 @@ int OwlLua::WebClientGetRaw(lua_State* L)
 
 	url = luaL_checkstring(L, -1);
 
-	QString		pageSrc;
+	WebClient::ReplyPtr reply;
 	int			status = 200;
 	bool		bIsError = false;
 
 	try
 	{
-        pageSrc = client->DownloadString(url, WebClient::NOTIDY |
-                                         WebClient::NOENCRYPT |
-                                         WebClient::NOCACHE);
+        reply = client->GetUrl(url, WebClient::NOTIDY |
+                              WebClient::NOENCRYPT |
+                              WebClient::NOCACHE);
 	}
 	catch (const WebException& ex)
 	{
@@ -276,7 +296,7 @@ int OwlLua::WebClientGetRaw(lua_State* L)
 		status = ex.statuscode();
 	}
 
-	lua_pushstring(L, pageSrc.toLatin1());
+	pushReply(L, reply);
 	lua_pushnumber(L, status);
 	lua_pushboolean(L, bIsError);
 	lua_gc(L, LUA_GCCOLLECT, 0);
@@ -316,13 +336,13 @@ int OwlLua::WebClientPost(lua_State* L)
         options = WebClient::NOCACHE;
 	}
 
-	QString		pageSrc;
+	WebClient::ReplyPtr reply;
 	int			status = 200;
 	bool		bIsError = false;
 
 	try
 	{
-		pageSrc = client->UploadString(url, payload, options);
+		reply = client->PostUrl(url, payload, options);
 	}
 	catch (const WebException& ex)
 	{
@@ -330,7 +350,7 @@ int OwlLua::WebClientPost(lua_State* L)
 		status = ex.statuscode();
 	}
 
-	lua_pushstring(L, pageSrc.toLatin1());
+	pushReply(L, reply);
 	lua_pushnumber(L, status);
 	lua_pushboolean(L, bIsError);
 	lua_gc(L, LUA_GCCOLLECT, 0);
@@ -345,13 +365,13 @@ int OwlLua::WebClientPostRaw(lua_State* L)
 	QString payload = luaL_checkstring(L, -1);
 	QString url = luaL_checkstring(L, -2);
 
-	QString		pageSrc;
+	WebClient::ReplyPtr reply;
 	int			status = 200;
 	bool		bIsError = false;
 
 	try
 	{
-		pageSrc = client->UploadString(url, payload, 
+		reply = client->PostUrl(url, payload, 
             WebClient::NOTIDY |
             WebClient::NOENCRYPT |
             WebClient::NOCACHE);
@@ -362,7 +382,7 @@ int OwlLua::WebClientPostRaw(lua_State* L)
 		status = ex.statuscode();
 	}
 
-	lua_pushstring(L, pageSrc.toLatin1());
+	pushReply(L, reply);
 	lua_pushnumber(L, status);
 	lua_pushboolean(L, bIsError);
 	lua_gc(L, LUA_GCCOLLECT, 0);
@@ -678,7 +698,7 @@ int OwlLua::SgmlTagAttribute(lua_State* L)
 
 	if (tag->hasAttribute(attrName))
 	{
-		attrVal = tag->Attributes.value(attrName);
+		attrVal = tag->getArgValue(attrName);
 	}
 
 	lua_pushstring(L, attrVal.toLatin1());
@@ -700,7 +720,7 @@ int OwlLua::SgmlTagSetAttribute(lua_State* L)
 	QString attrName(luaL_checkstring(L, -2));
 	QString attrVal(luaL_checkstring(L, -1));
 
-	tag->Attributes[attrName] = attrVal;
+	tag->setAttribute(attrName, attrVal);
 
 	return 1;
 }
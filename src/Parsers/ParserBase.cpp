@@ -1,5 +1,7 @@
 #include "ParserBase.h"
 
+#include <algorithm>
+
 #include <QtConcurrent>
 
 #include <Utils/OwlLogger.h>
@@ -7,18 +9,28 @@
 namespace owl
 {
 
+// how long an operation may take when the board doesn't set "web.timeout"
+const std::chrono::seconds DEFAULT_OPERATION_TIMEOUT { 120 };
+
+// the same for operations that walk the whole board, like finding the unread
+// forums, and the "web.timeout.board" option
+const std::chrono::seconds DEFAULT_BOARD_OPERATION_TIMEOUT { 900 };
+
 ParserBase::ParserBase(const QString& name, const QString& prettyName, const QString& baseUrl)
     : _options(StringMapPtr(new StringMap())),
       _name(name),
 	  _description(prettyName),
       _baseUrl(baseUrl),
-	  _requestFuture(nullptr), 
-      _requestWatcher(nullptr),
+      _inflight(std::make_shared<InFlightRequests>()),
       _logger(owl::initializeLogger("ParserBase"))
-{}
+{
+    QObject::connect(&_requests, &RequestQueue::requestCompleted, this, &ParserBase::requestCompleted);
+    QObject::connect(&_requests, &RequestQueue::requestCancelled, this, &ParserBase::requestCancelled);
+}
 
 ParserBase::~ParserBase()
 {
+    shutdown();
 }
 
 QString ParserBase::getPrettyName() const
@@ -43,6 +55,15 @@ void ParserBase::setUserAgent(const QString &agent)
     }
 }
 
+void ParserBase::setCacheIdentity(const QString& identity)
+{
+    if (identity != _cacheIdentity)
+    {
+        _cacheIdentity = identity;
+        updateClients();
+    }
+}
+
 void ParserBase::addWatcher(WebClient *webClient)
 {
     if (!_clientWatchers.contains(webClient))
@@ -82,85 +103,56 @@ bool ParserBase::canParse(const QString& html)
 
 StringMap ParserBase::login(LoginInfo& info)
 {
-    return this->doLogin(info).value<StringMap>();
+    return runOperation([&] { return doLogin(info); }).value<StringMap>();
 }
 
-void ParserBase::loginAsync(LoginInfo& info)
+ParserBase::RequestId ParserBase::loginAsync(LoginInfo& info)
 {
-	if (!_future.isRunning())
-	{
-		QObject::connect(&_watcher, SIGNAL(finished()), this, SLOT(loginSlot()));
-		_future = QtConcurrent::run(std::function<QVariant(void)>(
-			[this, info]
-			{
-				return doLogin(info);
-			}));
-
-	    _watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("loginAsync: ParserBase::_future.isRunning() == true");
-	}
+    return _requests.enqueue(RequestQueue::Priority::NORMAL, QStringLiteral("login"),
+        [this, info]
+        {
+            return runOperation([&] { return doLogin(info); });
+        },
+        [this](QFuture<QVariant> future) { loginFinished(future); });
 }
 
-void ParserBase::loginSlot()
+void ParserBase::loginFinished(QFuture<QVariant> future)
 {
     StringMap params;
 
-	// TODO: make a generic templated slot-handler for these (see submitNewThreadSlot() too)
-	// something like: void ParserBase<T>::futureSlot()
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-            params = w->future().result().value<StringMap>();
-            Q_EMIT loginCompleted(params);
-		}
-		catch (const owl::Exception& owe)
-		{
-            params.setOrAdd("success", false);
-            params.setOrAdd("error", owe.message());
-            _logger->warn("loginSlot() error: {}", owe.message().toStdString());
-            Q_EMIT errorNotification(owe);
-		}
-		catch (...)
-		{
-            const auto errorMessage = QString("There was an error connecting to ") + this->getBaseUrl() + QString(". Please check your login credentials, firewall/proxy settings or your Internet connection.");
-            params.setOrAdd("success", false);
-            params.setOrAdd("error", errorMessage);
-            _logger->warn("loginSlot() error: {}", errorMessage.toStdString());
-            Q_EMIT errorNotification(Exception(errorMessage));
-        }
-	}
-	else
-	{
-        _logger->error("loginSlot() could not cast sender() to QFutureWatcher<StringMap>*");
+    try
+    {
+        params = future.result().value<StringMap>();
+        Q_EMIT loginCompleted(params);
+    }
+    catch (const owl::Exception& owe)
+    {
         params.setOrAdd("success", false);
-        params.setOrAdd("error", "There was an unknown login error");
-        Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+        params.setOrAdd("error", owe.message());
+        _logger->warn("loginFinished() error: {}", owe.message().toStdString());
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
+        const auto errorMessage = QString("There was an error connecting to ") + this->getBaseUrl() + QString(". Please check your login credentials, firewall/proxy settings or your Internet connection.");
+        params.setOrAdd("success", false);
+        params.setOrAdd("error", errorMessage);
+        _logger->warn("loginFinished() error: {}", errorMessage.toStdString());
+        Q_EMIT errorNotification(Exception(errorMessage));
+    }
 }
 
 StringMap ParserBase::logout(LoginInfo&)
 {
-    return this->doLogout().value<StringMap>();
+    return runOperation([this] { return doLogout(); }).value<StringMap>();
 }
 
-void ParserBase::logoutAsync(LoginInfo&)
+ParserBase::RequestId ParserBase::logoutAsync(LoginInfo&)
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(logoutSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doLogout);
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("logoutAsync: ParserBase::_future.isRunning() == true");
-	}
+    // its own key so that logging in again afterwards can't cancel the logout
+    return _requests.enqueue(RequestQueue::Priority::NORMAL, QStringLiteral("logout"),
+        [this] { return runOperation([this] { return doLogout(); }); },
+        [this](QFuture<QVariant> future) { logoutFinished(future); });
 }
 
 ForumList ParserBase::getRootSubForumList()
@@ -168,83 +160,62 @@ ForumList ParserBase::getRootSubForumList()
     return getForumList(getRootForumId());
 }
 
-void ParserBase::getRootSubForumListAsync()
+ParserBase::RequestId ParserBase::getRootSubForumListAsync()
 {
-    getForumListAsync(getRootForumId());
+    return getForumListAsync(getRootForumId());
 }
 
-void ParserBase::logoutSlot()
+void ParserBase::logoutFinished(QFuture<QVariant> future)
 {
-    QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-            StringMap params = w->future().result().value<StringMap>();
+    try
+    {
+        StringMap params = future.result().value<StringMap>();
 
-			Q_EMIT logoutCompleted();
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-		}
-	}
-	else
-	{
-        _logger->error("logoutSlot() could not cast sender() to QFutureWatcher<StringMap>*");
+        Q_EMIT logoutCompleted();
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+    }
 }
 
 StringMap ParserBase::getBoardwareInfo()
 {
-    return this->doGetBoardwareInfo().value<StringMap>();
+    return runOperation([this] { return doGetBoardwareInfo(); }).value<StringMap>();
 }
 
-void ParserBase::getBoardwareInfoAsync()
+ParserBase::RequestId ParserBase::getBoardwareInfoAsync()
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(boardInfoSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doGetBoardwareInfo);
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("getBoardwareInfoAsync: ParserBase::_future.isRunning() == true");
-	}
+    return _requests.enqueue(RequestQueue::Priority::NORMAL, QStringLiteral("boardware"),
+        [this] { return runOperation([this] { return doGetBoardwareInfo(); }); },
+        [this](QFuture<QVariant> future) { boardInfoFinished(future); });
 }
 
-void ParserBase::boardInfoSlot()
+void ParserBase::boardInfoFinished(QFuture<QVariant> future)
 {
+    try
+    {
+        StringMap params = future.result().value<StringMap>();
 
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-            StringMap params = w->future().result().value<StringMap>();
-
-			Q_EMIT boardwareInfoCompleted(params);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-			return;
-		}
-	}
-	else
-	{
-        _logger->error("boardInfoSlot() could not cast sender() to QFutureWatcher<StringMap>*");
+        Q_EMIT boardwareInfoCompleted(params);
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}
+    }
 }
 
 ForumList ParserBase::getForumList(const QString& id)
 {
-	QVariant listVar(doGetForumList(id));
+	QVariant listVar(runOperation([&] { return coalescedForumList(id); }));
 
 	if (listVar.canConvert<ForumList>())
 	{
@@ -254,52 +225,34 @@ ForumList ParserBase::getForumList(const QString& id)
 	return ForumList();
 }
 
-void ParserBase::getForumListAsync(const QString& id)
+ParserBase::RequestId ParserBase::getForumListAsync(const QString& id)
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(getForumListSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doGetForumList, (const QString&)(id));
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("getForumListAsync: ParserBase::_future.isRunning() == true");
-	}
+    return _requests.enqueue(RequestQueue::Priority::NORMAL, QStringLiteral("forums:%1").arg(id),
+        [this, id] { return runOperation([&] { return coalescedForumList(id); }); },
+        [this](QFuture<QVariant> future) { forumListFinished(future); });
 }
 
-void ParserBase::getForumListSlot()
+void ParserBase::forumListFinished(QFuture<QVariant> future)
 {
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-			ForumList list = w->future().result().value<ForumList>();
+    try
+    {
+        ForumList list = future.result().value<ForumList>();
 
-			Q_EMIT forumListCompleted(list);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-		}
-		catch (...)
-		{
-            Q_EMIT errorNotification(Exception("There was an unknown error."));
-		}
-	}
-	else
-	{
-        _logger->error("getForumListSlot() could not cast sender() to QFutureWatcher<QVariant>*");
+        Q_EMIT forumListCompleted(list);
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+    }
 }
 
 ForumList ParserBase::getUnreadForums()
 {
-	QVariant listVar(doGetUnreadForums());
+	QVariant listVar(runOperation([this] { return coalescedUnreadForums(); }, boardOperationTimeout()));
 
 	if (listVar.canConvert<ForumList>())
 	{
@@ -309,47 +262,30 @@ ForumList ParserBase::getUnreadForums()
 	return ForumList();
 }
 
-void ParserBase::getUnreadForumsAsync()
+ParserBase::RequestId ParserBase::getUnreadForumsAsync()
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(getUnreadForumsSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doGetUnreadForums);
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("getUnreadForumsAsync: ParserBase::_future.isRunning() == true");
-	}
+    // this is a refresh, anything the user asks for goes ahead of it
+    return _requests.enqueue(RequestQueue::Priority::BACKGROUND, QStringLiteral("unread"),
+        [this] { return runOperation([this] { return coalescedUnreadForums(); }, boardOperationTimeout()); },
+        [this](QFuture<QVariant> future) { unreadForumsFinished(future); });
 }
 
-void ParserBase::getUnreadForumsSlot()
+void ParserBase::unreadForumsFinished(QFuture<QVariant> future)
 {
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-			ForumList list = w->future().result().value<ForumList>();
+    try
+    {
+        ForumList list = future.result().value<ForumList>();
 
-			Q_EMIT getUnreadForumsCompleted(list);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-		}
-		catch (...)
-		{
-            Q_EMIT errorNotification(Exception("There was an unknown error."));
-		}
-	}
-	else
-	{
-        _logger->error("getUnreadForumsSlot() could not cast sender() to QFutureWatcher<QVariant>*");
+        Q_EMIT getUnreadForumsCompleted(list);
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+    }
 }
     
 ThreadList ParserBase::getThreadList(ForumPtr forumInfo)
@@ -359,165 +295,162 @@ ThreadList ParserBase::getThreadList(ForumPtr forumInfo)
 
 ThreadList ParserBase::getThreadList(ForumPtr forumInfo, int options)
 {
-	QVariant var = doThreadList(forumInfo, options);
+	QVariant var = runOperation([&] { return coalescedThreadList(forumInfo, options); });
 	ForumPtr forum = var.value<ForumPtr>();
 
 	return forum->getThreads();
 }
 
-void ParserBase::getThreadListAsync(ForumPtr forumInfo)
+ParserBase::RequestId ParserBase::getThreadListAsync(ForumPtr forumInfo)
 {
-    getThreadListAsync(forumInfo, ParserEnums::REQUEST_DEFAULT);
+    return getThreadListAsync(forumInfo, ParserEnums::REQUEST_DEFAULT);
 }
     
-void ParserBase::getThreadListAsync(ForumPtr forumInfo, int options)
+ParserBase::RequestId ParserBase::getThreadListAsync(ForumPtr forumInfo, int options)
 {
-	if (!_future.isFinished())
-	{
-        _logger->debug("ParserBase::getThreadListAsync(): _future.isFinished() is FALSE, cancelling.");
-
-        _watcher.disconnect();
-        _future.cancel();
-    }
-
-    connect(&_watcher, SIGNAL(finished()), this, SLOT(getThreadListSlot()));
-    _future = QtConcurrent::run(this, &ParserBase::doThreadList, (ForumPtr)(forumInfo),(int)(options));
-    _watcher.setFuture(_future);
+    // only the thread list that was asked for last is of any use
+    return _requests.enqueue(RequestQueue::Priority::INTERACTIVE, QStringLiteral("threads"),
+        [this, forumInfo, options] { return runOperation([&] { return coalescedThreadList(forumInfo, options); }); },
+        [this](QFuture<QVariant> future) { threadListFinished(future); });
 }
 
-void ParserBase::getThreadListSlot()
+void ParserBase::threadListFinished(QFuture<QVariant> future)
 {
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-			ForumPtr forum = w->future().result().value<ForumPtr>();
+    try
+    {
+        ForumPtr forum = future.result().value<ForumPtr>();
 
-			Q_EMIT getThreadsCompleted(forum);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-			return;
-		}
-		catch (...)
-		{
-            Q_EMIT errorNotification(Exception("There was an unknown error."));
-			return;
-		}
-	}
-	else
-	{
-        _logger->error("getThreadListSlot() could not cast sender() to QFutureWatcher<QVariant>*");
+        Q_EMIT getThreadsCompleted(forum);
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+    }
 }
 
 PostList ParserBase::getPosts(ThreadPtr t, PostListOptions listOption, int webOptions)
 {
-	return doGetPostList(t, listOption, webOptions).value<ThreadPtr>()->getPosts();
+	return runOperation([&] { return coalescedPostList(t, listOption, webOptions); }).value<ThreadPtr>()->getPosts();
 }
 
-void ParserBase::getPostsAsync(ThreadPtr t, PostListOptions listOption, int webOptions)
+ParserBase::RequestId ParserBase::getPostsAsync(ThreadPtr t, PostListOptions listOption, int webOptions)
 {
-	if (!_future.isFinished())
-	{
-        _logger->debug("ParserBase::getPostsAsync(): _future.isFinished() is FALSE, cancelling.");
-        
-        _watcher.disconnect();
-        _future.cancel();
-    }
-    
-    connect(&_watcher, &QFutureWatcherBase::finished, [this]
-    {
-        try
+    // only the post list that was asked for last is of any use
+    return _requests.enqueue(RequestQueue::Priority::INTERACTIVE, QStringLiteral("posts"),
+        [this, t, listOption, webOptions] { return runOperation([&] { return coalescedPostList(t, listOption, webOptions); }); },
+        [this](QFuture<QVariant> future)
         {
-            _watcher.disconnect();
-            ThreadPtr thread = this->_future.result().value<ThreadPtr>();
+            try
+            {
+                ThreadPtr thread = future.result().value<ThreadPtr>();
 
-            Q_EMIT getPostsCompleted(thread);
-        }
-        catch (const owl::Exception& owe)
-        {
-            Q_EMIT errorNotification(owe);
-        }
-        catch (...)
+                Q_EMIT getPostsCompleted(thread);
+            }
+            catch (const owl::Exception& owe)
+            {
+                Q_EMIT errorNotification(owe);
+            }
+            catch (...)
+            {
+                Q_EMIT errorNotification(Exception("There was an unknown error."));
+            }
+        });
+}
+    
+ParserBase::RequestId ParserBase::prefetchThreadListAsync(ForumPtr forumInfo, int options)
+{
+    const QString key = QString("prefetch:threads:%1/%2").arg(forumInfo->getId()).arg(forumInfo->getPageNumber());
+
+    return _requests.enqueue(RequestQueue::Priority::BACKGROUND, key,
+        [this, forumInfo, options] { return runOperation([&] { return coalescedThreadList(forumInfo, options); }); },
+        [this](QFuture<QVariant> future)
         {
-            Q_EMIT errorNotification(Exception("There was an unknown error."));
-        }
-    });
+            try
+            {
+                Q_EMIT threadListPrefetched(future.result().value<ForumPtr>());
+            }
+            catch (const owl::Exception& owe)
+            {
+                _logger->debug("Prefetching a thread list failed: {}", owe.message().toStdString());
+            }
+            catch (...)
+            {
+                _logger->debug("Prefetching a thread list failed with an unknown error");
+            }
+        });
+}
 
-    _future = QtConcurrent::run(this, &ParserBase::doGetPostList, (ThreadPtr)(t), (PostListOptions)listOption, (int)webOptions);
-    
-    _watcher.setFuture(_future);
+ParserBase::RequestId ParserBase::prefetchPostsAsync(ThreadPtr t, PostListOptions listOption, int webOptions)
+{
+    const QString key = QString("prefetch:posts:%1/%2").arg(t->getId()).arg(t->getPageNumber());
+
+    return _requests.enqueue(RequestQueue::Priority::BACKGROUND, key,
+        [this, t, listOption, webOptions] { return runOperation([&] { return coalescedPostList(t, listOption, webOptions); }); },
+        [this](QFuture<QVariant> future)
+        {
+            try
+            {
+                Q_EMIT postsPrefetched(future.result().value<ThreadPtr>());
+            }
+            catch (const owl::Exception& owe)
+            {
+                _logger->debug("Prefetching posts failed: {}", owe.message().toStdString());
+            }
+            catch (...)
+            {
+                _logger->debug("Prefetching posts failed with an unknown error");
+            }
+        });
 }
-    
+
 void ParserBase::markForumRead(ForumPtr forumInfo)
 {
-    doMarkForumRead(forumInfo);
+    runOperation([&] { return doMarkForumRead(forumInfo); });
 }
 
-void ParserBase::markForumReadAsync(ForumPtr forumInfo)
+ParserBase::RequestId ParserBase::markForumReadAsync(ForumPtr forumInfo)
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(markForumReadSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doMarkForumRead,(ForumPtr)(forumInfo));
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("markForumReadAsync: ParserBase::_future.isRunning() == true");
-	}
+    return _requests.enqueue(RequestQueue::Priority::INTERACTIVE, QString(),
+        [this, forumInfo] { return runOperation([&] { return doMarkForumRead(forumInfo); }); },
+        [this](QFuture<QVariant> future) { markForumReadFinished(future); });
 }
 
-void ParserBase::markForumReadSlot()
+void ParserBase::markForumReadFinished(QFuture<QVariant> future)
 {
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-			ForumPtr forumPtr = w->future().result().value<ForumPtr>();
+    try
+    {
+        ForumPtr forumPtr = future.result().value<ForumPtr>();
 
-			Q_EMIT markForumReadCompleted(forumPtr);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-		}
-		catch (...)
-		{
-            Q_EMIT errorNotification(Exception("There was an unknown error."));
-		}
-	}
-	else
-	{
-        _logger->error("markForumReadSlot() could not cast sender() to QFutureWatcher<QVariant>*");
+        Q_EMIT markForumReadCompleted(forumPtr);
+    }
+    catch (const owl::Exception& owe)
+    {
+        Q_EMIT errorNotification(owe);
+    }
+    catch (...)
+    {
         Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+    }
 }
 
 ThreadPtr ParserBase::submitNewThread(ThreadPtr threadInfo)
 {
-	return doSubmitNewThread(threadInfo).value<ThreadPtr>();
+	return runOperation([&] { return doSubmitNewThread(threadInfo); }).value<ThreadPtr>();
 }
 
-void ParserBase::submitNewThreadAsync(ThreadPtr threadInfo)
+ParserBase::RequestId ParserBase::submitNewThreadAsync(ThreadPtr threadInfo)
 {
-    if (!_future.isRunning())
-    {
-        connect(&_watcher, &QFutureWatcherBase::finished, [this]
+    return _requests.enqueue(RequestQueue::Priority::INTERACTIVE, QString(),
+        [this, threadInfo] { return runOperation([&] { return doSubmitNewThread(threadInfo); }); },
+        [this](QFuture<QVariant> future)
         {
             try
             {
-                _watcher.disconnect();
-                const auto thread = this->_future.result().value<ThreadPtr>();
+                const auto thread = future.result().value<ThreadPtr>();
 
                 Q_EMIT submitNewThreadCompleted(thread);
             }
@@ -530,51 +463,56 @@ void ParserBase::submitNewThreadAsync(ThreadPtr threadInfo)
                 Q_EMIT errorNotification(Exception("There was an unknown error."));
             }
         });
-
-        _future = QtConcurrent::run(this, &ParserBase::doSubmitNewThread, (ThreadPtr)(threadInfo));
-        _watcher.setFuture(_future);
-    }
-    else
-    {
-        _logger->debug("submitNewThreadAsync: ParserBase::_future.isRunning() == true");
-    }
 }
 
 PostPtr ParserBase::submitNewPost(PostPtr postInfo)
 {
-	return doSubmitNewPost(postInfo).value<PostPtr>();
+	return runOperation([&] { return doSubmitNewPost(postInfo); }).value<PostPtr>();
 }
 
-void ParserBase::submitNewPostAsync(PostPtr postInfo)
+ParserBase::RequestId ParserBase::submitNewPostAsync(PostPtr postInfo)
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, &QFutureWatcherBase::finished, [this]
-		{
-			try
-			{
-                _watcher.disconnect();
-				PostPtr post = this->_future.result().value<PostPtr>();
+    return _requests.enqueue(RequestQueue::Priority::INTERACTIVE, QString(),
+        [this, postInfo] { return runOperation([&] { return doSubmitNewPost(postInfo); }); },
+        [this](QFuture<QVariant> future)
+        {
+            try
+            {
+                PostPtr post = future.result().value<PostPtr>();
 
-				Q_EMIT submitNewPostCompleted(post);
-			}
-			catch (const owl::Exception& owe)
-			{
+                Q_EMIT submitNewPostCompleted(post);
+            }
+            catch (const owl::Exception& owe)
+            {
                 Q_EMIT errorNotification(owe);
-			}
-			catch (...)
-			{
+            }
+            catch (...)
+            {
                 Q_EMIT errorNotification(Exception("There was an unknown error."));
-			}
-		});
+            }
+        });
+}
 
-		_future = QtConcurrent::run(this, &ParserBase::doSubmitNewPost, (PostPtr)(postInfo));
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("submitNewPostAsync: ParserBase::_future.isRunning() == true");
-	}
+bool ParserBase::cancelRequest(RequestId id)
+{
+    return _requests.cancel(id);
+}
+
+void ParserBase::cancel()
+{
+    _requests.cancelAll();
+
+    QMutexLocker lock(&_operationsMutex);
+    for (const auto& token : _operations)
+    {
+        token->cancel();
+    }
+}
+
+void ParserBase::shutdown()
+{
+    cancel();
+    _requests.shutdown();
 }
 
 QString ParserBase::getItemUrl(ForumPtr forum)
@@ -627,8 +565,7 @@ void ParserBase::getFavIconBuffer(QByteArray* buffer, const QStringList& iconFil
                 if (reply->status() == 200)
                 {
                     buffer->clear();
-                    buffer->append(reply->data().c_str(),
-                        static_cast<uint>(reply->data().size()));
+                    buffer->append(reply->byteArray());
 
                 	QImage image = QImage::fromData(*buffer);
                 	if (!image.isNull())
@@ -717,6 +654,140 @@ QVariant ParserBase::doMarkForumRead(ForumPtr)
     return QVariant::fromValue(ForumPtr());
 }
 
+QVariant ParserBase::coalescedForumList(const QString& forumId)
+{
+    return _inflight->run(QString("forumlist/%1").arg(forumId),
+        [&]() { return doGetForumList(forumId); });
+}
+
+QVariant ParserBase::coalescedUnreadForums()
+{
+    return _inflight->run(QStringLiteral("unreadforums"),
+        [&]() { return doGetUnreadForums(); });
+}
+
+QVariant ParserBase::coalescedThreadList(ForumPtr forumInfo, int options)
+{
+    // the thread list gets stored in the ForumPtr that's passed in, so only
+    // requests for the same forum object can share a result
+    const QString key = QString("threadlist/%1/%2/%3/%4/%5")
+        .arg(forumInfo->getId())
+        .arg(forumInfo->getPageNumber())
+        .arg(forumInfo->getPerPage())
+        .arg(options)
+        .arg(reinterpret_cast<quintptr>(forumInfo.get()));
+
+    return _inflight->run(key, [&]() { return doThreadList(forumInfo, options); });
+}
+
+QVariant ParserBase::coalescedPostList(ThreadPtr t, PostListOptions listOption, int webOptions)
+{
+    const QString key = QString("postlist/%1/%2/%3/%4/%5/%6")
+        .arg(t->getId())
+        .arg(t->getPageNumber())
+        .arg(t->getPerPage())
+        .arg(listOption)
+        .arg(webOptions)
+        .arg(reinterpret_cast<quintptr>(t.get()));
+
+    return _inflight->run(key, [&]() { return doGetPostList(t, listOption, webOptions); });
+}
+
+QVariant ParserBase::runOperation(const std::function<QVariant()>& work)
+{
+    return runOperation(work, operationTimeout());
+}
+
+QVariant ParserBase::runOperation(const std::function<QVariant()>& work, CancellationToken::Milliseconds timeout)
+{
+    const auto token = std::make_shared<CancellationToken>(timeout, CancellationToken::current());
+
+    {
+        QMutexLocker lock(&_operationsMutex);
+        _operations.push_back(token);
+    }
+
+    const auto unregister = [this, &token]()
+    {
+        QMutexLocker lock(&_operationsMutex);
+        _operations.erase(std::remove(_operations.begin(), _operations.end(), token), _operations.end());
+    };
+
+    CancellationToken::Scope scope(token);
+
+    try
+    {
+        QVariant retval;
+
+        try
+        {
+            retval = work();
+        }
+        catch (const CancelledException&)
+        {
+            // a coalesced request gets the leader's result, if it was the leader
+            // that got cancelled then do the work ourselves
+            if (token->isCancelled())
+            {
+                throw;
+            }
+
+            _logger->trace("Shared request was cancelled, running it again");
+            retval = work();
+        }
+
+        unregister();
+        return retval;
+    }
+    catch (const CancelledException&)
+    {
+        unregister();
+        throw;
+    }
+    catch (...)
+    {
+        unregister();
+
+        // parsers (and Lua scripts) tend to wrap whatever went wrong in their own
+        // error, report it for what it really is
+        if (token->isCancelled())
+        {
+            token->throwIfCancelled();
+        }
+
+        throw;
+    }
+}
+
+CancellationToken::Milliseconds ParserBase::operationTimeout() const
+{
+    return timeoutOption(QStringLiteral("web.timeout"), DEFAULT_OPERATION_TIMEOUT);
+}
+
+CancellationToken::Milliseconds ParserBase::boardOperationTimeout() const
+{
+    return timeoutOption(QStringLiteral("web.timeout.board"), DEFAULT_BOARD_OPERATION_TIMEOUT);
+}
+
+CancellationToken::Milliseconds ParserBase::timeoutOption(const QString& key, std::chrono::seconds defaultValue) const
+{
+    const StringMapPtr options = _options;
+
+    if (options && options->has(key))
+    {
+        bool bOk = false;
+        const int seconds = options->getText(key, false).toInt(&bOk);
+
+        if (bOk)
+        {
+            // zero or less turns the deadline off
+            return std::chrono::seconds(std::max(seconds, 0));
+        }
+    }
+
+    return defaultValue;
+}
+
 void ParserBase::updateClients()
 {
     WebClientConfig config = createWebClientConfig();
@@ -732,6 +803,7 @@ WebClientConfig ParserBase::createWebClientConfig()
 	WebClientConfig config;
 
 	config.userAgent = getUserAgent();
+    config.cacheIdentity = _cacheIdentity;
 
 	if (_options->getBool("encryption.enabled", false))
 	{
@@ -746,50 +818,44 @@ WebClientConfig ParserBase::createWebClientConfig()
 		config.encryptSeed = "";
 	}
 
+    config.useTidy = _options->has("web.tidy.enabled")
+        ? _options->getBool("web.tidy.enabled", false)
+        : defaultTidyEnabled();
+
+    // boards can opt out of HTTP/2 if a server or proxy misbehaves with it
+    config.useHttp2 = _options->has("web.http2.enabled")
+        ? _options->getBool("web.http2.enabled", false)
+        : WebClient::isHttp2Available();
+
 	return config;
 }
 
 StringMap ParserBase::getEncryptionSettings()
 {
-    return this->doGetEncryptionSettings().value<StringMap>();
+    return runOperation([this] { return doGetEncryptionSettings(); }).value<StringMap>();
 }
 
-void ParserBase::getEncryptionSettingsAsync()
+ParserBase::RequestId ParserBase::getEncryptionSettingsAsync()
 {
-	if (!_future.isRunning())
-	{
-		connect(&_watcher, SIGNAL(finished()), this, SLOT(getEncryptionSettingsSlot()));
-		_future = QtConcurrent::run(this, &ParserBase::doGetEncryptionSettings);
-		_watcher.setFuture(_future);
-	}
-	else
-	{
-        _logger->debug("getEncryptionSettingsAsync: ParserBase::_future.isRunning() == true");
-	}
-}
-
-void ParserBase::getEncryptionSettingsSlot()
-{
-	QFutureWatcher<QVariant>* w = reinterpret_cast<QFutureWatcher<QVariant>* >(sender());
-	if (w != nullptr)
-	{
-		try
-		{
-            _watcher.disconnect();
-            StringMap params = w->future().result().value<StringMap>();
+    return _requests.enqueue(RequestQueue::Priority::NORMAL, QStringLiteral("encryption"),
+        [this] { return runOperation([this] { return doGetEncryptionSettings(); }); },
+        [this](QFuture<QVariant> future)
+        {
+            try
+            {
+                StringMap params = future.result().value<StringMap>();
 
-			Q_EMIT getEncryptionSettingsCompleted(params);
-		}
-		catch (const owl::Exception& owe)
-		{
-            Q_EMIT errorNotification(owe);
-		}
-	}
-	else
-	{
-        _logger->error("getEncryptionSettingsSlot() could not cast sender() to QFutureWatcher<StringMap>*");
-        Q_EMIT errorNotification(Exception("There was an unknown error."));
-	}	
+                Q_EMIT getEncryptionSettingsCompleted(params);
+            }
+            catch (const owl::Exception& owe)
+            {
+                Q_EMIT errorNotification(owe);
+            }
+            catch (...)
+            {
+                Q_EMIT errorNotification(Exception("There was an unknown error."));
+            }
+        });
 }
 
 } // namespace owl
@@ -2,6 +2,7 @@
 #include <QtCore>
 #include "../Parsers/Forum.h"
 #include "../Utils/WebClient.h"
+#include "RequestQueue.h"
 
 namespace spdlog
 {
@@ -41,6 +42,9 @@ public:
 		LAST_POST = 0x0002
 	};
 
+    // identifies a request made through one of the *Async() methods, see requestCompleted()
+    using RequestId = RequestQueue::RequestId;
+
 	ParserBase(const QString& name, const QString& prettyName, const QString& baseUrl);
 	virtual ~ParserBase();
 
@@ -55,6 +59,8 @@ public:
         other->_description = _description;
         other->_baseUrl = _baseUrl;
         other->_userAgent = _userAgent;
+        other->_cacheIdentity = _cacheIdentity;
+        other->_inflight = _inflight;
 
         return other;
     }
@@ -72,6 +78,9 @@ public:
 	const QString& getUserAgent() const { return _userAgent; }
     void setUserAgent(const QString& agent);
 
+    // who requests are made as, keeps cached responses apart between accounts
+    void setCacheIdentity(const QString& identity);
+
     void addWatcher(WebClient* webClient);
     void removeWatcher(WebClient* webClient);
 
@@ -94,45 +103,82 @@ public:
     // This is the same as above except for threads per page instead of posts
     virtual const std::pair<uint, bool> defaultThreadsPerPage() const { return std::make_pair(25, false); }
 
+    // Whether HTML responses are run through tidy before they're handed to the parser. Parsers
+    // whose DOM layer tolerates malformed markup can skip it, and the "web.tidy.enabled" board
+    // option overrides this.
+    virtual bool defaultTidyEnabled() const { return true; }
+
 	//****************************************************************************//
 	// API
+    // The *Async() methods queue the request on the parser's RequestQueue and return
+    // right away. What the user asked for (threads, posts, submitting) goes ahead of
+    // background work like refreshing unread forums, and a new thread or post list
+    // request supersedes the previous one. The result is delivered by the matching
+    // *Completed signal followed by requestCompleted()
+    //
+    // Every operation runs under its own CancellationToken whose deadline is the
+    // "web.timeout" board option (in seconds), or "web.timeout.board" for ones
+    // that walk the whole board like getUnreadForums(). It is chained to the token
+    // installed on the calling thread, so a caller can impose a tighter deadline or
+    // cancel a synchronous call from elsewhere with a CancellationToken::Scope. An
+    // operation that is cancelled throws a CancelledException, one that runs past
+    // its deadline throws the TimeoutException subclass
+
     virtual StringMap getBoardwareInfo();
-	virtual void getBoardwareInfoAsync();
+	virtual RequestId getBoardwareInfoAsync();
 
     virtual bool canParse(const QString&);
 
     virtual StringMap login(LoginInfo&);
-	virtual void loginAsync(LoginInfo&);
+	virtual RequestId loginAsync(LoginInfo&);
 
     virtual StringMap logout(LoginInfo&);
-	virtual void logoutAsync(LoginInfo&);
+	virtual RequestId logoutAsync(LoginInfo&);
 
     virtual ForumList getRootSubForumList();
 
-    virtual void getRootSubForumListAsync();
+    virtual RequestId getRootSubForumListAsync();
 
 	virtual ForumList getForumList(const QString& id);
-	virtual void getForumListAsync(const QString& id);
+	virtual RequestId getForumListAsync(const QString& id);
 
 	virtual ForumList getUnreadForums();
-	virtual void getUnreadForumsAsync();
+	virtual RequestId getUnreadForumsAsync();
 
 	virtual ThreadList getThreadList(ForumPtr forumInfo);
 	virtual ThreadList getThreadList(ForumPtr forumInfo, int options);
-    virtual void getThreadListAsync(ForumPtr forumInfo);
-	virtual void getThreadListAsync(ForumPtr forumInfo, int options);
+    virtual RequestId getThreadListAsync(ForumPtr forumInfo);
+	virtual RequestId getThreadListAsync(ForumPtr forumInfo, int options);
 
 	virtual PostList getPosts(ThreadPtr t, PostListOptions listOption, int webOptions = ParserEnums::REQUEST_DEFAULT);
-	virtual void getPostsAsync(ThreadPtr t, PostListOptions listOptions, int webOptions = ParserEnums::REQUEST_DEFAULT);
+	virtual RequestId getPostsAsync(ThreadPtr t, PostListOptions listOptions, int webOptions = ParserEnums::REQUEST_DEFAULT);
+
+    // Fetch a thread list or a page of posts the user is likely to ask for next. These
+    // run at background priority, deliver their result with threadListPrefetched() and
+    // postsPrefetched() instead of the *Completed signals and only log their errors
+    virtual RequestId prefetchThreadListAsync(ForumPtr forumInfo, int options = ParserEnums::REQUEST_DEFAULT);
+    virtual RequestId prefetchPostsAsync(ThreadPtr t, PostListOptions listOption, int webOptions = ParserEnums::REQUEST_DEFAULT);
 
     virtual void markForumRead(ForumPtr forumInfo);
-    virtual void markForumReadAsync(ForumPtr forumInfo);
+    virtual RequestId markForumReadAsync(ForumPtr forumInfo);
 
 	virtual ThreadPtr submitNewThread(ThreadPtr threadInfo);
-	virtual void submitNewThreadAsync(ThreadPtr threadInfo);
+	virtual RequestId submitNewThreadAsync(ThreadPtr threadInfo);
 
 	virtual PostPtr submitNewPost(PostPtr postInfo);
-	virtual void submitNewPostAsync(PostPtr postInfo);
+	virtual RequestId submitNewPostAsync(PostPtr postInfo);
+
+    // drops a queued request or stops a running one and discards its result
+    bool cancelRequest(RequestId id);
+
+    // cancels everything running on this parser, synchronous calls included,
+    // and drops every queued request
+    void cancel();
+
+    // cancels everything and waits for the queued work that is running to stop,
+    // no more *Async() requests are started afterwards. Every derived destructor
+    // calls this first since the work uses the derived parser
+    void shutdown();
 
 	virtual QString getItemUrl(ForumPtr forum);
 	virtual QString getItemUrl(ThreadPtr thread);
@@ -141,7 +187,7 @@ public:
 	virtual QString getPostQuote(PostPtr post);
 
     virtual StringMap getEncryptionSettings();
-	virtual void getEncryptionSettingsAsync();
+	virtual RequestId getEncryptionSettingsAsync();
 
 	//****************************************************************************//
 
@@ -150,6 +196,15 @@ public:
 
     virtual QString getLastRequestUrl() = 0;
 
+    // Returns what the parser needs to resume its current session on the next run (cookies,
+    // login time, etc.) or an empty array if there's no session worth saving.
+    virtual QByteArray saveSession() { return QByteArray(); }
+
+    // Puts a session returned by saveSession() back in place without contacting the server.
+    // The session is validated by the first request that needs it, which logs in again with
+    // the given credentials if it has expired. Returns false if the session can't be used.
+    virtual bool restoreSession(const LoginInfo&, const QByteArray&) { return false; }
+
 Q_SIGNALS:
     void loginCompleted(StringMap loginInfo);
 	void logoutCompleted();
@@ -164,19 +219,14 @@ Q_SIGNALS:
 	void submitNewPostCompleted(PostPtr post);
     void markForumReadCompleted(ForumPtr forum);
     void getEncryptionSettingsCompleted(StringMap settings);
+    void threadListPrefetched(ForumPtr forum);
+    void postsPrefetched(ThreadPtr thread);
     void errorNotification(const Exception& ex);
 
-private Q_SLOTS:
-	void loginSlot();
-	void logoutSlot();
-	void boardInfoSlot();		
-	void getUnreadForumsSlot();
-	void getForumListSlot();
-	void getThreadListSlot();	
-	//void getPostListSlot();
-	void getEncryptionSettingsSlot();
-	void markForumReadSlot();
-	
+    // emitted once the request's result has been delivered, or when it is cancelled or superseded
+    void requestCompleted(quint64 requestId);
+    void requestCancelled(quint64 requestId);
+
 protected:
 
 	////////////////////////////////////////////////////////////////
@@ -218,21 +268,50 @@ protected:
     StringMapPtr _options;
 
 private:
+    using InFlightRequests = SingleFlight<QString, QVariant>;
+
+    // runs an operation under a new CancellationToken, see cancel()
+    QVariant runOperation(const std::function<QVariant()>& work);
+    QVariant runOperation(const std::function<QVariant()>& work, CancellationToken::Milliseconds timeout);
+
+    CancellationToken::Milliseconds operationTimeout() const;
+    CancellationToken::Milliseconds boardOperationTimeout() const;
+    CancellationToken::Milliseconds timeoutOption(const QString& key, std::chrono::seconds defaultValue) const;
+
+    // wrappers around the do* methods that share the result of an identical
+    // request if one is already running on this parser or one of its clones
+    QVariant coalescedForumList(const QString& forumId);
+    QVariant coalescedUnreadForums();
+    QVariant coalescedThreadList(ForumPtr forumInfo, int options);
+    QVariant coalescedPostList(ThreadPtr t, PostListOptions listOption, int webOptions);
+
+    // deliver the results of the *Async() requests
+    void loginFinished(QFuture<QVariant> future);
+    void logoutFinished(QFuture<QVariant> future);
+    void boardInfoFinished(QFuture<QVariant> future);
+    void forumListFinished(QFuture<QVariant> future);
+    void unreadForumsFinished(QFuture<QVariant> future);
+    void threadListFinished(QFuture<QVariant> future);
+    void markForumReadFinished(QFuture<QVariant> future);
+
     QString _name;
     QString _description; 
 
 	QString _baseUrl;
 	QString _userAgent;
+    QString _cacheIdentity;
 
     QList<WebClient*>			_clientWatchers;
 
-	QFuture<QVariant>*			_requestFuture;
-	QFutureWatcher<QVariant>*	_requestWatcher;
-	
-	QFuture<QVariant>			_future;
-    QFutureWatcher<QVariant>	_watcher;
+    std::shared_ptr<InFlightRequests>   _inflight;
+
+    QMutex                              _operationsMutex;
+    std::vector<CancellationTokenPtr>   _operations;    // tokens of the running operations
 
     std::shared_ptr<spdlog::logger>  _logger;
+
+    // declared last so it is destroyed before the members its work uses
+    RequestQueue                _requests;
 };
 
 } // namespace owl
@@ -0,0 +1,245 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "RequestQueue.h"
+
+#include <Utils/OwlLogger.h>
+
+namespace owl
+{
+
+RequestQueue::RequestQueue(int maxConcurrent, QObject* parent)
+    : QObject(parent),
+      _maxConcurrent(std::max(1, maxConcurrent)),
+      _logger(owl::initializeLogger("RequestQueue"))
+{
+}
+
+RequestQueue::~RequestQueue()
+{
+    shutdown();
+}
+
+void RequestQueue::shutdown()
+{
+    _shutdown = true;
+    _pending.clear();
+
+    // ask the running work to stop and wait for it rather than let it
+    // outlive the parser it is using
+    for (auto& kv : _running)
+    {
+        kv.second.token->cancel();
+    }
+
+    for (auto& kv : _running)
+    {
+        kv.second.watcher->disconnect(this);
+        kv.second.watcher->waitForFinished();
+        kv.second.watcher->deleteLater();
+    }
+
+    _running.clear();
+}
+
+RequestQueue::RequestId RequestQueue::enqueue(Priority priority, const QString& key, Work work, Handler handler)
+{
+    if (_shutdown)
+    {
+        const RequestId id = _nextId++;
+        Q_EMIT requestCancelled(id);
+        return id;
+    }
+
+    if (!key.isEmpty())
+    {
+        for (auto it = _pending.begin(); it != _pending.end();)
+        {
+            if (it->key == key)
+            {
+                const RequestId supersededId = it->id;
+                it = _pending.erase(it);
+
+                _logger->trace("Request {} superseded before it started", supersededId);
+                Q_EMIT requestCancelled(supersededId);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (auto& kv : _running)
+        {
+            if (kv.second.key == key && !kv.second.cancelled)
+            {
+                kv.second.cancelled = true;
+                kv.second.token->cancel();
+
+                _logger->trace("Request {} superseded while running, its result will be discarded", kv.first);
+                Q_EMIT requestCancelled(kv.first);
+            }
+        }
+    }
+
+    const RequestId id = _nextId++;
+    _pending.push_back(Request { id, priority, key, std::move(work), std::move(handler), CancellationToken::current() });
+
+    if (priority == Priority::INTERACTIVE)
+    {
+        preemptBackground();
+    }
+
+    startNext();
+
+    return id;
+}
+
+bool RequestQueue::cancel(RequestId id)
+{
+    auto pending = std::find_if(_pending.begin(), _pending.end(),
+        [id](const Request& request) { return request.id == id; });
+
+    if (pending != _pending.end())
+    {
+        _pending.erase(pending);
+        Q_EMIT requestCancelled(id);
+        return true;
+    }
+
+    auto running = _running.find(id);
+    if (running != _running.end() && !running->second.cancelled)
+    {
+        running->second.cancelled = true;
+        running->second.token->cancel();
+        Q_EMIT requestCancelled(id);
+        return true;
+    }
+
+    return false;
+}
+
+void RequestQueue::cancelAll()
+{
+    std::vector<RequestId> ids;
+
+    for (const auto& request : _pending)
+    {
+        ids.push_back(request.id);
+    }
+
+    for (const auto& kv : _running)
+    {
+        ids.push_back(kv.first);
+    }
+
+    for (const auto id : ids)
+    {
+        cancel(id);
+    }
+}
+
+void RequestQueue::startNext()
+{
+    while (static_cast<int>(_running.size()) < _maxConcurrent && !_pending.empty())
+    {
+        // the highest priority goes first, ties go to whoever was queued first
+        auto next = std::min_element(_pending.begin(), _pending.end(),
+            [](const Request& a, const Request& b)
+            {
+                if (a.priority != b.priority)
+                {
+                    return a.priority > b.priority;
+                }
+
+                return a.id < b.id;
+            });
+
+        Request request = std::move(*next);
+        _pending.erase(next);
+
+        const RequestId id = request.id;
+
+        auto watcher = new QFutureWatcher<QVariant>(this);
+        QObject::connect(watcher, &QFutureWatcherBase::finished, this, [this, id]() { finished(id); });
+
+        // chained to whatever token was installed when the request was queued,
+        // so callers can put a deadline on it with a CancellationToken::Scope
+        auto token = std::make_shared<CancellationToken>(
+            CancellationToken::Milliseconds::zero(), std::move(request.parent));
+
+        Running& running = _running[id];
+        running.priority = request.priority;
+        running.key = request.key;
+        running.handler = std::move(request.handler);
+        running.watcher = watcher;
+        running.token = token;
+
+        watcher->setFuture(QtConcurrent::run(
+            [token, work = std::move(request.work)]()
+            {
+                CancellationToken::Scope scope(token);
+                return work();
+            }));
+    }
+}
+
+void RequestQueue::preemptBackground()
+{
+    if (static_cast<int>(_running.size()) < _maxConcurrent)
+    {
+        return;
+    }
+
+    RequestId victim = 0;
+    for (const auto& kv : _running)
+    {
+        // a cancelled request frees its slot as soon as it stops, which is
+        // where the interactive work goes
+        if (kv.second.cancelled)
+        {
+            return;
+        }
+
+        if (victim == 0 && kv.second.priority == Priority::BACKGROUND)
+        {
+            victim = kv.first;
+        }
+    }
+
+    if (victim != 0)
+    {
+        // not queued again, a refresh that restarted with every click could
+        // be put off forever. The next refresh will redo it
+        _logger->trace("Request {} preempted by interactive work", victim);
+        cancel(victim);
+    }
+}
+
+void RequestQueue::finished(RequestId id)
+{
+    auto it = _running.find(id);
+    if (it == _running.end())
+    {
+        return;
+    }
+
+    Running running = std::move(it->second);
+    _running.erase(it);
+
+    running.watcher->deleteLater();
+
+    // keep the queue moving before handing over the result
+    startNext();
+
+    if (running.cancelled)
+    {
+        _logger->trace("Discarding the result of cancelled request {}", id);
+        return;
+    }
+
+    running.handler(running.watcher->future());
+    Q_EMIT requestCompleted(id);
+}
+
+} // namespace owl
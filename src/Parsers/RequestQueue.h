@@ -0,0 +1,118 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <functional>
+#include <map>
+#include <vector>
+#include <QtCore>
+#include <QtConcurrent>
+#include <Utils/CancellationToken.h>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+// Runs a parser's asynchronous requests on the global thread pool, at most
+// maxConcurrent at a time. Waiting requests are started in order of priority
+// (and in the order they were queued within a priority), so something the user
+// clicked on goes ahead of a background refresh that was queued earlier.
+//
+// A request can be given a key, queuing another request with the same key
+// supersedes it: it is dropped if it hasn't started yet, or its result is
+// discarded if it has. The queue must be used from the thread it lives in,
+// handlers are called on that thread.
+//
+// Each request runs with its own CancellationToken installed, cancelling or
+// superseding a running request cancels the token so the work stops at its
+// next web request (or Lua hook) instead of running to completion.
+//
+// INTERACTIVE work doesn't wait for BACKGROUND work that is already running
+// to finish: if every slot is taken, a running background request is
+// cancelled the same way and dropped, whoever queued it (like the refresh
+// scheduler) queues it again later. Its slot stays taken until the work has
+// actually stopped, so a parser never runs two requests at once.
+class RequestQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    using RequestId = quint64;
+
+    enum class Priority
+    {
+        BACKGROUND  = 0,
+        NORMAL      = 1,
+        INTERACTIVE = 2
+    };
+
+    using Work      = std::function<QVariant()>;
+
+    // called with the finished future, QFuture::result() rethrows any exception the work threw
+    using Handler   = std::function<void(QFuture<QVariant>)>;
+
+    explicit RequestQueue(int maxConcurrent = 1, QObject* parent = nullptr);
+    virtual ~RequestQueue();
+
+    RequestId enqueue(Priority priority, const QString& key, Work work, Handler handler);
+
+    // returns false if the request has already finished or been cancelled
+    bool cancel(RequestId id);
+    void cancelAll();
+
+    // cancels everything and waits for the running work to stop, nothing is
+    // started after this. The owner calls it while the objects the work uses
+    // are still alive
+    void shutdown();
+
+    std::size_t pendingCount() const { return _pending.size(); }
+    std::size_t runningCount() const { return _running.size(); }
+
+Q_SIGNALS:
+    // emitted after the request's handler has been called
+    void requestCompleted(quint64 requestId);
+    void requestCancelled(quint64 requestId);
+
+private:
+    struct Request
+    {
+        RequestId               id;
+        Priority                priority;
+        QString                 key;
+        Work                    work;
+        Handler                 handler;
+        CancellationTokenPtr    parent;     // the token current when it was queued
+    };
+
+    struct Running
+    {
+        Priority                    priority;
+        QString                     key;
+        Handler                     handler;
+        QFutureWatcher<QVariant>*   watcher = nullptr;
+        CancellationTokenPtr        token;
+        bool                        cancelled = false;
+    };
+
+    void startNext();
+    void finished(RequestId id);
+
+    // cancels a running BACKGROUND request if there's no free slot (and none
+    // about to be freed) for new INTERACTIVE work
+    void preemptBackground();
+
+    const int                       _maxConcurrent;
+    RequestId                       _nextId = 1;
+
+    std::vector<Request>            _pending;
+    std::map<RequestId, Running>    _running;
+    bool                            _shutdown = false;
+
+    std::shared_ptr<spdlog::logger> _logger;
+};
+
+} // namespace owl
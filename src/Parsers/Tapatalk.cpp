@@ -2,23 +2,31 @@
 #include "../Utils/QSgml.h"
 #include "Tapatalk.h"
 #include <cmath>
+#include <vector>
 
 #include <Utils/OwlLogger.h>
 
 namespace owl
 {
 
+namespace
+{
+
+// Reply::byteArray() only borrows the body, the response has to outlive the reply
+QByteArray toByteArray(const WebClient::Reply& reply)
+{
+    const auto body = reply.view();
+    return QByteArray(body.data(), static_cast<int>(body.size()));
+}
+
+} // namespace
+
 const uint Tapatalk4x::LOGINTIMEOUT = 60 * 15; // 15 minutes
 
 Tapatalk4x::Tapatalk4x(const QString& baseUrl)
     : ParserBase(TAPATALK_NAME, TAPATALK_PRETTYNAME, baseUrl),
-	  _rootId("-1"),
-      _rootIdRealized(false),
-	  _configLoaded(false),
-	  _bUseMD5(false),
-	  _bUseSha1(false),
-      _apiLevel(3),
-      _forumMapInitialized(false),
+      _info(std::make_shared<SharedSnapshot<BoardInfo>>()),
+      _sessionRestored(false),
       _mutex(QMutex::Recursive),
       _logger(owl::initializeLogger("Tapatalk4x"))
 {
@@ -41,7 +49,7 @@ Tapatalk4x::Tapatalk4x(const QString& baseUrl)
 
 Tapatalk4x::~Tapatalk4x()
 {
-    // do nothing
+    shutdown();
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -56,12 +64,13 @@ QVariant Tapatalk4x::doLogin(const LoginInfo& info)
 	QString username(info.first.toLatin1().toBase64());
 	QString password(info.second.toLatin1().toBase64());
 
-	if (_bUseMD5)
+	const auto boardInfo = _info->get();
+	if (boardInfo->useMD5)
 	{
 		// TODO: MD5 is not working with AMB for some reason
 		//password = QCryptographicHash::hash(password.toLatin1(),QCryptographicHash::Md5).toBase64();
 	}
-	else if (_bUseSha1)
+	else if (boardInfo->useSha1)
 	{
 		password = QCryptographicHash::hash(password.toLatin1(),QCryptographicHash::Sha1).toBase64();
 	}
@@ -118,11 +127,15 @@ QVariant Tapatalk4x::doLogin(const LoginInfo& info)
 
             result.setOrAdd("success", true);
 
-            if (!_rootIdRealized)
+            if (!_info->get()->rootIdRealized)
             {
-                QString strPostData(getRequestXml("get_forum"));
-                const QString ldata = uploadString(strPostData);
-                getRootId(ldata);
+                const auto discovery = _info->lockDiscovery();
+                if (!_info->get()->rootIdRealized)
+                {
+                    QString strPostData(getRequestXml("get_forum"));
+                    const QByteArray ldata = uploadString(strPostData);
+                    _info->update([this, &ldata](BoardInfo& info) { getRootId(ldata, info); });
+                }
             }
         }
         else
@@ -151,11 +164,72 @@ QVariant Tapatalk4x::doLogout()
 	return QVariant::fromValue(result);
 }
 
+QByteArray Tapatalk4x::saveSession()
+{
+    if (!_lastLogin.isValid())
+    {
+        return QByteArray();
+    }
+
+    QByteArray retval;
+    QDataStream stream(&retval, QIODevice::WriteOnly);
+
+    const auto info = _info->get();
+    stream << info->configLoaded << info->version << info->useMD5 << info->useSha1 << info->apiLevel
+           << info->rootIdRealized << info->rootId
+           << _webclient.exportCookies();
+
+    return retval;
+}
+
+bool Tapatalk4x::restoreSession(const LoginInfo& info, const QByteArray& session)
+{
+    bool configLoaded = false;
+    QString version;
+    bool useMD5 = false;
+    bool useSha1 = false;
+    int apiLevel = 0;
+    bool rootIdRealized = false;
+    QString rootId;
+    QByteArray cookies;
+
+    QDataStream stream(session);
+    stream >> configLoaded >> version >> useMD5 >> useSha1 >> apiLevel
+           >> rootIdRealized >> rootId
+           >> cookies;
+
+    if (stream.status() != QDataStream::Ok || cookies.isEmpty())
+    {
+        return false;
+    }
+
+    _info->update([&](BoardInfo& info)
+        {
+            info.configLoaded = configLoaded;
+            info.version = version;
+            info.useMD5 = useMD5;
+            info.useSha1 = useSha1;
+            info.apiLevel = apiLevel;
+            info.rootIdRealized = rootIdRealized;
+            info.rootId = rootId;
+        });
+
+    _webclient.deleteAllCookies();
+    _webclient.importCookies(cookies);
+
+    // the session is trusted until the first response says otherwise, see uploadString()
+    _loginInfo = info;
+    _lastLogin = QDateTime::currentDateTime();
+    _sessionRestored = true;
+
+    return true;
+}
+
 QVariant Tapatalk4x::doGetBoardwareInfo()
 {
    StringMap result;
     const QString strPostData(getRequestXml("get_config"));
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
 
     XRVariant response(data);
     if (!response.canConvert(QVariant::Map))
@@ -170,10 +244,11 @@ QVariant Tapatalk4x::doGetBoardwareInfo()
 		result.add("success", true);
 		result.add("boardware", "tapatalk");
 
-        // _version must be set before getForumName() is called else it will fail
+        // the version must be set before getForumName() is called else it will fail
         if (infoMap.contains("version"))
         {
-            _version = infoMap["version"].toString();
+            const QString version = infoMap["version"].toString();
+            _info->update([&version](BoardInfo& info) { info.version = version; });
         }
 
 		QString strName(getForumName());
@@ -229,35 +304,47 @@ QVariant Tapatalk4x::doGetForumList(const QString& forumId)
 	QMutexLocker locker(&_mutex);
 	ForumList retval;
 
-	if (!_forumMapInitialized)
+	if (!_info->get()->forumMapInitialized)
 	{
-		QString strPostData(getRequestXml("get_forum"));
+		const auto discovery = _info->lockDiscovery();
+		if (!_info->get()->forumMapInitialized)
+		{
+			QString strPostData(getRequestXml("get_forum"));
+			const QByteArray data = uploadString(strPostData);
 
-        const QString data = uploadString(strPostData);
-		getRootId(data);
+			_info->update([this, &data](BoardInfo& info)
+				{
+					getRootId(data, info);
 
-		ForumPtr root = Forum::createRootForum(_rootId);
-		_forumMap.insert(_rootId, root);
+					ForumMap forumMap;
+					forumMap.insert(info.rootId, Forum::createRootForum(info.rootId));
 
-		XRVariant response(data);
-		walkForum(&response);
+					XRVariant response(data);
+					walkForum(&response, forumMap);
 
-		_forumMapInitialized = true;
+					info.forumMap = forumMap;
+					info.forumMapInitialized = true;
+				});
+		}
 	}
 
+	// the forums in the map are never changed after it is published, so
+	// the snapshot can be read without holding any lock
+	const auto info = _info->get();
+
 	// This is s hack! The ConfigureBoardDlg called doGetForumList() in order
 	// to crawl the board, at which point the default rootId = -1. However,
 	// since some boards have a rootId = 0, we need to check it here. This
 	// seems like a bad solution but it works.
 	QString searchId(forumId);
-	if (searchId == "-1" && _rootId != searchId)
+	if (searchId == "-1" && info->rootId != searchId)
 	{
-		searchId = _rootId;
+		searchId = info->rootId;
 	}
 
-    if (_forumMap.contains(searchId))
+    if (info->forumMap.contains(searchId))
 	{
-        ForumPtr f = _forumMap[searchId];
+        ForumPtr f = info->forumMap[searchId];
 
         const auto& children = f->getChildren();
         for (const BoardItemPtr& bi : children)
@@ -284,17 +371,27 @@ QVariant Tapatalk4x::doThreadList(ForumPtr forumInfo, int)
 	uint iStart = (forumInfo->getPageNumber()-1) * forumInfo->getPerPage();
 	uint iEnd = iStart + forumInfo->getPerPage()-1;
 
-	// load the sticky threads
+	// the sticky threads
 	ParamList paramList;
 	paramList.append(TapaTalkParam(ParamType::STRING, QVariant::fromValue(forumInfo->getId())));
 	paramList.append(TapaTalkParam(ParamType::INT, QVariant::fromValue(iStart)));
 	paramList.append(TapaTalkParam(ParamType::INT, QVariant::fromValue(iEnd)));
 	paramList.append(TapaTalkParam(ParamType::STRING, QVariant::fromValue(QString("TOP"))));
 
-	QString strPostData(getRequestXml("get_topic", paramList));
+	QStringList payloads;
+	payloads.push_back(getRequestXml("get_topic", paramList));
 
-    QString data = uploadString(strPostData);
-	XRVariant responseData(data);
+	// the non-sticky threads
+	paramList.removeLast();
+	paramList.removeLast();
+	paramList.append(TapaTalkParam(ParamType::INT, QVariant::fromValue(iEnd)));
+
+	payloads.push_back(getRequestXml("get_topic", paramList));
+
+	// neither list depends on the other so both are requested at once
+	const QList<QByteArray> responses = uploadStrings(payloads);
+
+	XRVariant responseData(responses.at(0));
 
 	if (!responseData.canConvert(QVariant::Map))
 	{
@@ -328,18 +425,7 @@ QVariant Tapatalk4x::doThreadList(ForumPtr forumInfo, int)
         _logger->error(strError.toStdString());
 	}
 
-	// load the non-sticky threads
-	paramList.removeLast();
-	paramList.removeLast();
-	paramList.append(TapaTalkParam(ParamType::INT, QVariant::fromValue(iEnd)));
-
-	strPostData.clear();
-	strPostData = getRequestXml("get_topic", paramList);
-
-	data.clear();
-    data = uploadString(strPostData);
-
-	XRVariant responseData2(data);
+	XRVariant responseData2(responses.at(1));
 
 	if (!responseData2.canConvert(QVariant::Map))
 	{
@@ -402,7 +488,7 @@ QVariant Tapatalk4x::doPostList(ThreadPtr threadInfo, int)
 
 	QString strPostData(getRequestXml("get_thread_by_unread", paramList));
 
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
 	XRVariant responseData(data);
 
 	if (!responseData.canConvert(QVariant::Map))
@@ -500,7 +586,7 @@ QVariant Tapatalk4x::doPostList1(ThreadPtr threadInfo, int)
 
 	QString strPostData(getRequestXml("get_thread", paramList));
 
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
 	XRVariant responseData(data);
 
 	if (!responseData.canConvert(QVariant::Map))
@@ -575,7 +661,7 @@ QVariant Tapatalk4x::doSubmitNewThread(ThreadPtr threadInfo)
 
     QString strNewThreadData(getRequestXml("new_topic", paramList));
 
-    const QString data = uploadString(strNewThreadData);
+    const QByteArray data = uploadString(strNewThreadData);
 	XRVariant response(data);
 
 	if (!response.canConvert(QVariant::Map))
@@ -630,7 +716,7 @@ QVariant Tapatalk4x::doSubmitNewPost(PostPtr postInfo)
 	paramList.append(TapaTalkParam(ParamType::BASE64, QVariant::fromValue(strTemp)));
 
     const QString strNewPostData(getRequestXml("reply_post", paramList));
-    const QString data = uploadString(strNewPostData);
+    const QByteArray data = uploadString(strNewPostData);
 	XRVariant response(data);
 
 	if (!response.canConvert(QVariant::Map))
@@ -684,7 +770,7 @@ QVariant Tapatalk4x::doMarkForumRead(ForumPtr forumInfo)
 	}
 
     const QString strPostData(getRequestXml("mark_all_as_read", paramList));
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
 	XRVariant response(data);
 
 	if (!response.canConvert(QVariant::Map))
@@ -719,7 +805,7 @@ QVariant Tapatalk4x::doGetUnreadForums()
 	paramList.append(TapaTalkParam(ParamType::INT, QVariant::fromValue(50)));
 
     const QString strPostData(getRequestXml("get_unread_topic", paramList));
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
 	XRVariant response(data);
 
 	if (!response.canConvert(QVariant::Map))
@@ -790,7 +876,7 @@ QString Tapatalk4x::getPostQuote(PostPtr postinfo)
     paramList.append(TapaTalkParam(ParamType::STRING, QVariant::fromValue(postinfo->getId())));
 
     const QString strPostData(getRequestXml("get_quote_post", paramList));
-    const QString data = uploadString(strPostData);
+    const QByteArray data = uploadString(strPostData);
     XRVariant responseData(data);
 
     if (responseData.canConvert(QVariant::Map))
@@ -817,7 +903,7 @@ QString Tapatalk4x::getPostQuote(PostPtr postinfo)
     return retval;
 }
 
-void Tapatalk4x::walkForum( QVariant* variant )
+void Tapatalk4x::walkForum(QVariant* variant, ForumMap& forumMap)
 {
 	if (variant->canConvert(QVariant::List))
 	{
@@ -830,16 +916,16 @@ void Tapatalk4x::walkForum( QVariant* variant )
 			{
 				newForum->setDisplayOrder(++iDisplayOrder);
 	
-				_forumMap.insert(newForum->getId(), newForum);
+				forumMap.insert(newForum->getId(), newForum);
 
 				auto strParentId = fItem.toMap().value("parent_id").toString();
-				if (_forumMap.contains(strParentId))
+				if (forumMap.contains(strParentId))
 				{
-					_forumMap[strParentId]->addChild(newForum);
+					forumMap[strParentId]->addChild(newForum);
 				}
 
 				auto childVariant = fItem.toMap().value("child");
-				walkForum(&childVariant);
+				walkForum(&childVariant, forumMap);
 			}
 		}
 	}
@@ -928,17 +1014,64 @@ QString Tapatalk4x::getRequestXml(const QString& methodName, ParamList params)
     return retXml;
 }
 
-const QString Tapatalk4x::uploadString(const QString& payload)
+QByteArray Tapatalk4x::uploadString(const QString& payload)
 {
     if (_lastLogin.secsTo(QDateTime::currentDateTime()) >= Tapatalk4x::LOGINTIMEOUT)
     {
         doLogin(_loginInfo);
     }
 
-    return _webclient.UploadString(getBaseUrl(), payload,
-        WebClient::NOTIDY |
-        WebClient::NOENCRYPT |
-        WebClient::NOCACHE);
+    const uint options = WebClient::NOTIDY | WebClient::NOENCRYPT | WebClient::NOCACHE;
+    auto reply = _webclient.PostUrl(getBaseUrl(), payload, options);
+
+    // Tapatalk tells us with each response whether we're logged in, so a session restored from
+    // disk is validated by its first request and replaced with a fresh login if it has expired
+    if (_sessionRestored && reply)
+    {
+        _sessionRestored = false;
+
+        if (reply->headers().getText("mobiquo_is_login", false).trimmed().toLower() == "false")
+        {
+            _logger->debug("Restored session for '{}' has expired, logging in again", getBaseUrl().toStdString());
+
+            doLogin(_loginInfo);
+            reply = _webclient.PostUrl(getBaseUrl(), payload, options);
+        }
+    }
+
+    return reply ? toByteArray(*reply) : QByteArray();
+}
+
+QList<QByteArray> Tapatalk4x::uploadStrings(const QStringList& payloads)
+{
+    QList<QByteArray> retval;
+
+    // a restored session is only confirmed by the first response, so the
+    // rest of the batch has to wait for it, see uploadString()
+    if (_sessionRestored && !payloads.isEmpty())
+    {
+        retval.push_back(uploadString(payloads.first()));
+    }
+    else if (_lastLogin.secsTo(QDateTime::currentDateTime()) >= Tapatalk4x::LOGINTIMEOUT)
+    {
+        doLogin(_loginInfo);
+    }
+
+    const uint options = WebClient::NOTIDY | WebClient::NOENCRYPT | WebClient::NOCACHE;
+
+    std::vector<std::future<WebClient::ReplyPtr>> replies;
+    for (int i = retval.size(); i < payloads.size(); i++)
+    {
+        replies.push_back(_webclient.PostUrlAsync(getBaseUrl(), payloads.at(i), options));
+    }
+
+    for (auto& future : replies)
+    {
+        const auto reply = future.get();
+        retval.push_back(reply ? toByteArray(*reply) : QByteArray());
+    }
+
+    return retval;
 }
 
 owl::ForumPtr Tapatalk4x::makeForumObject( QVariant* variant )
@@ -1053,9 +1186,9 @@ owl::PostPtr Tapatalk4x::makePostObject( QVariant* variant )
 	return newPost;
 }
 
-void Tapatalk4x::getRootId(QString data)
+void Tapatalk4x::getRootId(const QByteArray& data, BoardInfo& info)
 {
-	if (_rootIdRealized)
+	if (info.rootIdRealized)
 	{
 		return;
 	}
@@ -1088,8 +1221,8 @@ void Tapatalk4x::getRootId(QString data)
 	auto firstChildMap = firstChild.toMap();
 	if (firstChildMap.contains("parent_id"))
 	{
-		_rootId = firstChildMap["parent_id"].toString();
-		_rootIdRealized = true;
+		info.rootId = firstChildMap["parent_id"].toString();
+		info.rootIdRealized = true;
 		return;
 	}
     else
@@ -1102,59 +1235,72 @@ void Tapatalk4x::getRootId(QString data)
 
 void Tapatalk4x::loadConfig()
 {
-	if (!_configLoaded)
+	if (_info->get()->configLoaded)
 	{
-        const QString strPostData(getRequestXml("get_config"));
-        const QString data = uploadString(strPostData);
-		XRVariant response(data);
+		return;
+	}
 
-		if (!response.canConvert(QVariant::Map))
-		{
-            OWL_THROW_EXCEPTION(Exception("Cannot convert 'get_config' response to QVariant::Map"));
-		}
+	// another clone may be loading it already, in which case this waits for it
+	const auto discovery = _info->lockDiscovery();
+	if (_info->get()->configLoaded)
+	{
+		return;
+	}
 
-		auto map = response.toMap();
+    const QString strPostData(getRequestXml("get_config"));
+    const QByteArray data = uploadString(strPostData);
+	XRVariant response(data);
 
-		if (map.contains("support_md5"))
-		{
-			_bUseMD5 = map["support_md5"].toBool();
-		}
+	if (!response.canConvert(QVariant::Map))
+	{
+        OWL_THROW_EXCEPTION(Exception("Cannot convert 'get_config' response to QVariant::Map"));
+	}
 
-		if (map.contains("support_sha1"))
-		{
-			_bUseSha1 = map["support_sha1"].toBool();
-		}
+	const auto map = response.toMap();
 
-		if (map.contains("api_level"))
+	_info->update([&map](BoardInfo& info)
 		{
-			_apiLevel = map["api_level"].toInt();
-		}
+			if (map.contains("support_md5"))
+			{
+				info.useMD5 = map["support_md5"].toBool();
+			}
 
-		if (map.contains("version"))
-		{
-			_version = map["version"].toString();
-		}
+			if (map.contains("support_sha1"))
+			{
+				info.useSha1 = map["support_sha1"].toBool();
+			}
 
-		_configLoaded = true;
-	}
+			if (map.contains("api_level"))
+			{
+				info.apiLevel = map["api_level"].toInt();
+			}
+
+			if (map.contains("version"))
+			{
+				info.version = map["version"].toString();
+			}
+
+			info.configLoaded = true;
+		});
 }
 
 QString Tapatalk4x::getForumName()
 {
-	QString retval(_forumName);
+	const auto info = _info->get();
+	QString retval(info->forumName);
 
-	if (_forumName.isEmpty())
+	if (info->forumName.isEmpty())
 	{
 		QUrl tempUrl(getBaseUrl());
 		retval = tempUrl.host();	
 	
-		if (!_version.isEmpty())
+		if (!info->version.isEmpty())
 		{
 			// get the board's native url
 			QString strtempUrl = getBaseUrl();
             strtempUrl = strtempUrl.replace(QRegularExpression("/.[^\\/]*?/mobiquo.php$"), QString());
 
-			if (_version.startsWith("vb40", Qt::CaseInsensitive))
+			if (info->version.startsWith("vb40", Qt::CaseInsensitive))
 			{
 				// we have to use a new WebClient object so that the cookies
 				// in _webClient don't get reset
@@ -1174,10 +1320,10 @@ QString Tapatalk4x::getForumName()
 					{
 						QSgmlTag* altTag = tempList.at(0);
 						if (altTag != nullptr
-							&& altTag->Attributes.contains("alt")
-							&& !altTag->Attributes.value("alt").isEmpty())
+							&& altTag->hasAttribute("alt")
+							&& !altTag->getArgValue("alt").isEmpty())
 						{
-							QString temp(altTag->Attributes.value("alt").trimmed());
+							QString temp(altTag->getArgValue("alt").trimmed());
 							retval = temp.replace(vbr, "");
 						}
 					}
@@ -1187,16 +1333,16 @@ QString Tapatalk4x::getForumName()
 			{
 				QString trimmer;
 
-				if (_version.startsWith("vb3x", Qt::CaseInsensitive))
+				if (info->version.startsWith("vb3x", Qt::CaseInsensitive))
 				{
 					trimmer = " - Powered by vBulletin";
 				}
-				else if (_version.startsWith("sm-", Qt::CaseInsensitive))
+				else if (info->version.startsWith("sm-", Qt::CaseInsensitive))
 				{
 					 trimmer = " - Index";
 				}
-				//else if (_version.startsWith("xf1", Qt::CaseInsensitive)
-				//	|| _version.startsWith("pb30", Qt::CaseInsensitive))
+				//else if (info->version.startsWith("xf1", Qt::CaseInsensitive)
+				//	|| info->version.startsWith("pb30", Qt::CaseInsensitive))
 
 				// we have to use a new WebClient object so that the cookies
 				// in _webClient don't get reset
@@ -1231,7 +1377,7 @@ QString Tapatalk4x::getForumName()
 			}
 		}
 
-		_forumName = retval;
+		_info->update([&retval](BoardInfo& info) { info.forumName = retval; });
 	}
 
 	return retval;
@@ -1,5 +1,6 @@
 #pragma once
 #include <QtCore>
+#include "../Utils/SharedSnapshot.h"
 #include "../Utils/StringMap.h"
 #include "xrvariant.h"
 #include "ParserBase.h"
@@ -75,7 +76,7 @@ public:
 
         virtual const QString getRootForumId() const  override
         {
-            return _rootId;
+            return _info->get()->rootId;
         }
 
     virtual ParserBasePtr clone(ParserBasePtr other = ParserBasePtr()) override
@@ -83,18 +84,9 @@ public:
         Tapatalk4xPtr retval = std::make_shared<Tapatalk4x>(getBaseUrl());
         ParserBase::clone(retval);
 
-        retval->_rootId = _rootId;
-        retval->_rootIdRealized = _rootIdRealized;
-        retval->_configLoaded = _configLoaded;
-
-        retval->_version = _version;
-        retval->_bUseMD5 = _bUseMD5;
-        retval->_bUseSha1 = _bUseSha1;
-        retval->_apiLevel = _apiLevel;
-
-        retval->_forumName = _forumName;
-        retval->_forumMap = _forumMap;
-        retval->_forumMapInitialized = _forumMapInitialized;
+        // clones share what has been discovered about the board, so whichever
+        // parser loads the config or the forum map first does it for all of them
+        retval->_info = _info;
 
         retval->_loginInfo = _loginInfo;
         retval->_lastLogin = _lastLogin;
@@ -111,6 +103,9 @@ public:
         return _webclient.getLastRequestUrl();
     }
 
+    virtual QByteArray saveSession() override;
+    virtual bool restoreSession(const LoginInfo& info, const QByteArray& session) override;
+
 protected:
         virtual QVariant doLogin(const LoginInfo&) override;
         virtual QVariant doLogout() override;
@@ -130,18 +125,44 @@ protected:
 	virtual QVariant doGetPostList(ThreadPtr t, PostListOptions listOption, int webOptions) override;
 
 private:
+    // what's been discovered about the board, this never changes once it is
+    // known and so is shared with the parser's clones
+    struct BoardInfo
+    {
+        QString     rootId = "-1";
+        bool        rootIdRealized = false;
+        bool        configLoaded = false;
+
+        QString     version;
+        bool        useMD5 = false;
+        bool        useSha1 = false;
+        int         apiLevel = 3;
+
+        QString     forumName;
+        ForumMap    forumMap;
+        bool        forumMapInitialized = false;
+    };
+
+    using BoardInfoPtr = std::shared_ptr<SharedSnapshot<BoardInfo>>;
+
 	void loadConfig();
 
 	QString getRequestXml(const QString&, ParamList = ParamList());
-    const QString uploadString(const QString& payload);
+    // the raw XML-RPC responses, XRVariant parses them without decoding
+    // them to a QString first
+    QByteArray uploadString(const QString& payload);
+
+    // posts independent requests concurrently and returns the responses in
+    // the same order, so the batch takes about as long as its slowest request
+    QList<QByteArray> uploadStrings(const QStringList& payloads);
 
-	void walkForum(QVariant* variant);
+	void walkForum(QVariant* variant, ForumMap& forumMap);
 
 	ForumPtr makeForumObject(QVariant* variant);
 	ThreadPtr makeThreadObject(QVariant* variant);
 	PostPtr makePostObject(QVariant* variant);
 
-	void getRootId(QString data);
+	void getRootId(const QByteArray& data, BoardInfo& info);
 	QString getForumName();	
 
 	virtual QVariant doPostList(ThreadPtr threadInfo, int options);
@@ -149,23 +170,15 @@ private:
 
     WebClient              _webclient;
 
-	QString					_rootId;
-	bool					_rootIdRealized;
-	bool					_configLoaded;
-
-    QString					_version;
-	bool					_bUseMD5;
-	bool					_bUseSha1;
-    int						_apiLevel;
-
-    QString					_forumName;	// so we don't make multiple calls
-	ForumMap				_forumMap;
-	bool					_forumMapInitialized;
+    BoardInfoPtr            _info;
 
     // Bug #117: We need to track the last login and then do a login every 15 minutes.
     LoginInfo               _loginInfo;
     QDateTime               _lastLogin;
 
+    // set when the session was restored from disk and hasn't been confirmed by the server yet
+    bool                    _sessionRestored;
+
 	QMutex					_mutex;
 
     std::shared_ptr<spdlog::logger>  _logger;
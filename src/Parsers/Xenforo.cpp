@@ -1,6 +1,7 @@
 // Owl - www.owlclient.com
 // Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
 
+#include "../Utils/HtmlScanner.h"
 #include "../Utils/OwlUtils.h"
 #include "../Utils/QSgml.h"
 #include "../Utils/QSgmlTag.h"
@@ -20,6 +21,11 @@ Q_INVOKABLE Xenforo::Xenforo(const QString &baseUrl)
     addWatcher(&_webclient);
 }
 
+Xenforo::~Xenforo()
+{
+    shutdown();
+}
+
 ParserBasePtr Xenforo::clone(ParserBasePtr other)
 {
     XenforoPtr retval = std::make_shared<Xenforo>(getBaseUrl());
@@ -27,6 +33,7 @@ ParserBasePtr Xenforo::clone(ParserBasePtr other)
 
     retval->_webclient.setCurlHandle(_webclient.getCurlHandle());
     retval->_logoutUrl = _logoutUrl;
+    retval->_loginInfo = _loginInfo;
 
     return retval;
 }
@@ -95,14 +102,14 @@ QVariant Xenforo::doGetUnreadForums()
     const QString url = QString("%1/find-new/posts")
         .arg(this->getBaseUrl());
 
-    const QString data = _webclient.DownloadString(url, WebClient::NOCACHE);
+    const QString data = downloadPage(url, WebClient::NOCACHE);
 
     QSgml doc;
     if (doc.parse(data))
     {
-        for (QSgmlTag* linode : doc.DocTag->getElementsByName("li", "class", QRegExp{"unread"}))
+        for (QSgmlTag* linode : doc.select("li.unread"))
         {
-            const auto forumlinknode = linode->getFirstElementByName("a", "class", QRegExp{"forumLink"});
+            const auto forumlinknode = doc.selectFirst(linode, "a.forumLink");
             if (forumlinknode)
             {
                 const auto forumId = forumlinknode->getArgValue("href");
@@ -132,7 +139,7 @@ QVariant Xenforo::doMarkForumRead(ForumPtr forumInfo)
     const QString url = QString("%1/forums/-/mark-read")
         .arg(this->getBaseUrl());
 
-    const QString predata = _webclient.DownloadString(url);
+    const QString predata = downloadPage(url);
 
     QSgml doc;
     if (doc.parse(predata))
@@ -183,6 +190,9 @@ QVariant Xenforo::doLogin(const LoginInfo& loginInfo)
     params.add("remember", "1");
     params.add("_xfToken", QString());
 
+    _loginInfo = loginInfo;
+    _sessionRestored = false;
+
     const QString loginUrl { this->getBaseUrl() + "/login/login" };
 
     // The problems related to the session cookie getting rest seemed to be related to passing cookies
@@ -201,7 +211,7 @@ QVariant Xenforo::doLogin(const LoginInfo& loginInfo)
         // NOTE: To confirm a successful login we look for a <a class="LogOut"> element that provides
         // us with the hash we want in order to logout, which is why we save the link in a class
         // variable.
-        const auto logoutnodes = parseDoc.getElementsByName("a", "class", QRegExp{"LogOut"});
+        const auto logoutnodes = parseDoc.select("a.LogOut");
 
         if (logoutnodes.size() > 0)
         {
@@ -220,6 +230,73 @@ QVariant Xenforo::doLogin(const LoginInfo& loginInfo)
     return QVariant::fromValue(result);
 }
 
+QByteArray Xenforo::saveSession()
+{
+    if (_logoutUrl.isEmpty())
+    {
+        return QByteArray();
+    }
+
+    QByteArray retval;
+    QDataStream stream(&retval, QIODevice::WriteOnly);
+    stream << _logoutUrl << _webclient.exportCookies();
+
+    return retval;
+}
+
+bool Xenforo::restoreSession(const LoginInfo& info, const QByteArray& session)
+{
+    QString logoutUrl;
+    QByteArray cookies;
+
+    QDataStream stream(session);
+    stream >> logoutUrl >> cookies;
+
+    if (stream.status() != QDataStream::Ok || logoutUrl.isEmpty() || cookies.isEmpty())
+    {
+        return false;
+    }
+
+    _webclient.deleteAllCookies();
+    _webclient.importCookies(cookies);
+
+    _logoutUrl = logoutUrl;
+    _loginInfo = info;
+    _sessionRestored = true;
+
+    return true;
+}
+
+WebClient::ReplyPtr Xenforo::getPage(const QString& url, uint options)
+{
+    if (!_sessionRestored)
+    {
+        return _webclient.GetUrl(url, options);
+    }
+
+    // The first page we get after restoring a session tells us whether it's still good, every
+    // page has a <a class="LogOut"> link when we're logged in. The page mustn't come out of
+    // the cache since a cached copy would say nothing about the current session.
+    _sessionRestored = false;
+
+    auto reply = _webclient.GetUrl(url, options | WebClient::NOCACHE);
+    if (!reply || reply->view().find("LogOut") == std::string_view::npos)
+    {
+        _logger->debug("Restored session for '{}' has expired, logging in again", getBaseUrl().toStdString());
+
+        doLogin(_loginInfo);
+        reply = _webclient.GetUrl(url, options | WebClient::NOCACHE);
+    }
+
+    return reply;
+}
+
+QString Xenforo::downloadPage(const QString& url, uint options)
+{
+    const auto reply = getPage(url, options);
+    return reply ? reply->text() : QString();
+}
+
 QVariant Xenforo::doLogout()
 {
     StringMap result;
@@ -314,133 +391,241 @@ QVariant Xenforo::doThreadList(ForumPtr forumInfo, int options)
         requestOptions |= WebClient::NOCACHE;
     }
 
-    const QString data = _webclient.DownloadString(url);
+    const auto reply = getPage(url, requestOptions);
 
-    QSgml doc;
-    if (doc.parse(data))
+    if (reply && !reply->view().empty())
     {
-        const auto listItems = doc.getElementsByName("li", "class", QRegExp{"discussionListItem"});
-        for (QSgmlTag* liChild : listItems)
+        // the fields of the thread whose <li> is being scanned, the first
+        // match of each one is used. The scanner keeps the page's whitespace
+        // and XenForo's templates indent the text inside the tags
+        struct ThreadItem
+        {
+            QString id;
+            QString title;
+            QString author;
+            QString lastAuthor;
+            QString epochTime;      // the data-time of the last post's <abbr>
+            QString timeStamp;      // otherwise the title or text of its <span>
+            QString iconSrc;
+            QString previewText;
+            QString replyCount;
+            bool    sticky = false;
+            bool    hasTitle = false;
+            bool    hasAuthor = false;
+            bool    hasLastPost = false;
+            bool    hasLastAuthor = false;
+            bool    hasEpochTime = false;
+            bool    hasTimeStamp = false;
+            bool    hasIcon = false;
+            bool    hasPreviewText = false;
+            bool    hasReplyCount = false;
+        };
+
+        using Element = HtmlScanner::Element;
+
+        ThreadItem item;
+        bool hasPageCount = false;
+        HtmlScanner scanner;
+
+        scanner.onStart("li.discussionListItem", [&](const Element& e)
         {
-            auto titleInfo = liChild->getFirstElementByName("a", "class", QRegExp{"PreviewTooltip"});
-            auto authorInfo = liChild->getFirstElementByName("a", "class", QRegExp{"username"});
-            QSgmlTag* lastPostDiv = liChild->getFirstElementByName("div", "class", QRegExp{"lastPost"});
+            item = ThreadItem();
+            item.sticky = e.attribute("class").contains("sticky");
+        });
 
-            if (titleInfo && authorInfo && lastPostDiv)
+        scanner.onEnd("li.discussionListItem a.PreviewTooltip", [&](const Element& e)
+        {
+            if (!item.hasTitle)
             {
-                const auto lastAuthorNode = lastPostDiv->getFirstElementByName("a", "class", QRegExp{"username"});
-                if (lastAuthorNode)
+                item.id = e.attribute("href");
+                item.title = e.text.simplified();
+                item.hasTitle = true;
+            }
+        });
+
+        scanner.onEnd("li.discussionListItem a.username", [&](const Element& e)
+        {
+            if (!item.hasAuthor)
+            {
+                item.author = e.text.trimmed();
+                item.hasAuthor = true;
+            }
+        });
+
+        scanner.onStart("li.discussionListItem div.lastPost", [&](const Element&)
+        {
+            item.hasLastPost = true;
+        });
+
+        scanner.onEnd("li.discussionListItem div.lastPost a.username", [&](const Element& e)
+        {
+            if (!item.hasLastAuthor)
+            {
+                item.lastAuthor = e.text.trimmed();
+                item.hasLastAuthor = true;
+            }
+        });
+
+        scanner.onStart("li.discussionListItem div.lastPost abbr.DateTime", [&](const Element& e)
+        {
+            if (!item.hasEpochTime)
+            {
+                item.epochTime = e.attribute("data-time");
+                item.hasEpochTime = true;
+            }
+        });
+
+        scanner.onEnd("li.discussionListItem div.lastPost span.DateTime", [&](const Element& e)
+        {
+            if (!item.hasTimeStamp)
+            {
+                item.timeStamp = e.attribute("title").trimmed();
+                if (item.timeStamp.isEmpty())
                 {
-                    bool bHasUnread = false;
+                    item.timeStamp = e.text.trimmed();
+                }
+                item.hasTimeStamp = true;
+            }
+        });
 
-                    QString strId = titleInfo->getArgValue("href");
-                    if (strId.endsWith("/unread"))
-                    {
-                        bHasUnread = true;
-                        strId = strId.replace(QRegExp{"/unread$"}, QString());
-                    }
+        scanner.onStart("li.discussionListItem div.posterAvatar img", [&](const Element& e)
+        {
+            if (!item.hasIcon && e.attributes.contains("src"))
+            {
+                item.iconSrc = e.attribute("src");
+                item.hasIcon = true;
+            }
+        });
 
-                    ThreadPtr newthread = std::make_shared<Thread>(strId);
-                    newthread->setParent(forumInfo);
-                    newthread->setTitle(doc.getText(titleInfo));
-                    newthread->setAuthor(doc.getText(authorInfo));
-                    newthread->setHasUnread(bHasUnread);
-                    newthread->setSticky(liChild->getArgValue("class").contains("sticky"));
+        scanner.onEnd("li.discussionListItem h4.subtitle", [&](const Element& e)
+        {
+            if (!item.hasPreviewText)
+            {
+                item.previewText = e.text.simplified();
+                item.hasPreviewText = true;
+            }
+        });
 
-                    PostPtr lastpost = std::make_shared<Post>("-1");
-                    lastpost->setAuthor(doc.getText(lastAuthorNode));
+        scanner.onEnd("li.discussionListItem div.stats dl.major dd", [&](const Element& e)
+        {
+            if (!item.hasReplyCount)
+            {
+                item.replyCount = e.text.trimmed();
+                item.hasReplyCount = true;
+            }
+        });
 
-                    // try to get the user's avatar
-                    QSgmlTag* avatarEl = liChild->getFirstElementByName("div","class",QRegExp{"posterAvatar"});
-                    if (avatarEl)
-                    {
-                        QSgmlTag* imgEl = avatarEl->getFirstElementByName("img","src",QRegExp{});
-                        if (imgEl)
-                        {
-                            const QString src = imgEl->getArgValue("src");
-                            if (src.startsWith("http://") || src.startsWith("https://"))
-                            {
-                                newthread->setIconUrl(src);
-                            }
-                            else
-                            {
-                                const QString iconUrl = QString("%1/%2").arg(getBaseUrl()).arg(imgEl->getArgValue("src"));
-                                newthread->setIconUrl(iconUrl);
-                            }
-                        }
-                    }
+        scanner.onEnd("li.discussionListItem", [&](const Element&)
+        {
+            if (!item.hasTitle)
+            {
+                _logger->warn("Could not find any title information for a post at url '{}'", url.toStdString());
+                return;
+            }
+            else if (!item.hasAuthor)
+            {
+                _logger->warn("Could not find any author information for a post at url '{}'", url.toStdString());
+                return;
+            }
+            else if (!item.hasLastPost)
+            {
+                _logger->warn("Could not find any last post information for a post at url '{}'", url.toStdString());
+                return;
+            }
+            else if (!item.hasLastAuthor)
+            {
+                _logger->warn("Could not find any author information for a post at url '{}'", url.toStdString());
+                return;
+            }
 
-                    QDateTime dt = owl::parseDateTime(lastPostDiv, &doc);
-                    if (dt.isValid())
-                    {
-                        lastpost->setDatelineString(dt.toString("MM-dd-yyyy hh:mm AP"));
-                        lastpost->setDateTime(dt);
-                    }
-                    else
-                    {
-                        _logger->warn("Could not extract a timestamp from thread '{}' ({}) at url '{}'",
-                            newthread->getTitle().toStdString(), newthread->getId().toStdString(), url.toStdString());
-                    }
+            bool bHasUnread = false;
 
-                    newthread->setLastPost(lastpost);
+            QString strId = item.id;
+            if (strId.endsWith("/unread"))
+            {
+                bHasUnread = true;
+                strId = strId.replace(QRegExp{"/unread$"}, QString());
+            }
 
-                    QSgmlTag* subTitle = liChild->getFirstElementByName("h4", "class", QRegExp{"subtitle"});
-                    if (subTitle)
-                    {
-                        newthread->setPreviewText(doc.getText(subTitle));
-                    }
+            ThreadPtr newthread = std::make_shared<Thread>(strId);
+            newthread->setParent(forumInfo);
+            newthread->setTitle(item.title);
+            newthread->setAuthor(item.author);
+            newthread->setHasUnread(bHasUnread);
+            newthread->setSticky(item.sticky);
 
-                    // get the number of replies
-                    const auto repliesnode = liChild->getFirstElementByName("div", "class", QRegExp{"stats"});
-                    if (repliesnode)
-                    {
-                        const auto dlclass = repliesnode->getFirstElementByName("dl", "class", QRegExp {"major"});
-                        if (dlclass && dlclass->Children.size() > 1 && dlclass->Children.at(1)->Name == "dd")
-                        {
-                            bool bok = false;
-                            const QString countText = doc.getText(dlclass->Children.at(1)).replace(",", QString());
-                            const auto replycount = countText.toUInt(&bok);
-                            if (bok)
-                            {
-                                newthread->setReplyCount(replycount);
-                            }
-                        }
-                    }
+            PostPtr lastpost = std::make_shared<Post>("-1");
+            lastpost->setAuthor(item.lastAuthor);
 
-                    retval.push_back(newthread);
+            // try to get the user's avatar
+            if (item.hasIcon)
+            {
+                if (item.iconSrc.startsWith("http://") || item.iconSrc.startsWith("https://"))
+                {
+                    newthread->setIconUrl(item.iconSrc);
                 }
                 else
                 {
-                    _logger->warn("Could not find any author information for a post at url '{}'", url.toStdString());
+                    const QString iconUrl = QString("%1/%2").arg(getBaseUrl()).arg(item.iconSrc);
+                    newthread->setIconUrl(iconUrl);
                 }
             }
+
+            QDateTime dt;
+            if (item.hasEpochTime)
+            {
+                dt = owl::parseEpochTime(item.epochTime);
+            }
+            else if (item.hasTimeStamp)
+            {
+                dt = owl::parseDateTime(item.timeStamp);
+            }
+
+            if (dt.isValid())
+            {
+                lastpost->setDatelineString(dt.toString("MM-dd-yyyy hh:mm AP"));
+                lastpost->setDateTime(dt);
+            }
             else
             {
-                if (!titleInfo)
-                {
-                    _logger->warn("Could not find any title information for a post at url '{}'", url.toStdString());
-                }
-                else if (!authorInfo)
-                {
-                    _logger->warn("Could not find any author information for a post at url '{}'", url.toStdString());
-                }
-                else if (!lastPostDiv)
+                _logger->warn("Could not extract a timestamp from thread '{}' ({}) at url '{}'",
+                    newthread->getTitle().toStdString(), newthread->getId().toStdString(), url.toStdString());
+            }
+
+            newthread->setLastPost(lastpost);
+
+            if (item.hasPreviewText)
+            {
+                newthread->setPreviewText(item.previewText);
+            }
+
+            // get the number of replies
+            if (item.hasReplyCount)
+            {
+                bool bok = false;
+                const auto replycount = QString(item.replyCount).replace(",", QString()).toUInt(&bok);
+                if (bok)
                 {
-                    _logger->warn("Could not find any last post information for a post at url '{}'", url.toStdString());
+                    newthread->setReplyCount(replycount);
                 }
             }
-        }
 
-        const auto pagenav = doc.getElementsByName("div", "class", QRegExp{"PageNav"});
-        if (pagenav.size() > 0)
+            retval.push_back(newthread);
+        });
+
+        scanner.onStart("div.PageNav", [&](const Element& e)
         {
             bool ok;
-            const auto pageCount = pagenav.at(0)->getArgValue("data-last").toUInt(&ok);
-            if (ok)
+            const auto pageCount = e.attribute("data-last").toUInt(&ok);
+            if (ok && !hasPageCount)
             {
                 forumInfo->setPageCount(pageCount);
+                hasPageCount = true;
             }
-        }
+        });
+
+        scanner.feedUtf8(reply->view());
+        scanner.finish();
     }
     else
     {
@@ -507,7 +692,7 @@ QVariant Xenforo::doGetPostList(ThreadPtr threadInfo, ParserBase::PostListOption
         requestOptions |= WebClient::NOCACHE;
     }
 
-    const QString data = _webclient.DownloadString(url);
+    const QString data = downloadPage(url, requestOptions);
 
     QSgml doc;
     if (doc.parse(data))
@@ -524,7 +709,7 @@ QVariant Xenforo::doGetPostList(ThreadPtr threadInfo, ParserBase::PostListOption
             }
         }
 
-        const auto pagenav = doc.getElementsByName("div", "class", QRegExp{"PageNav"});
+        const auto pagenav = doc.select("div.PageNav");
         if (pagenav.size() > 0)
         {
             bool ok;
@@ -561,7 +746,7 @@ QVariant Xenforo::doGetPostList(ThreadPtr threadInfo, ParserBase::PostListOption
             newpost->setAuthor(strAuthor);
             newpost->setParent(threadInfo);
 
-            const auto textnode = node->getFirstElementByName("blockquote", "class", QRegExp{"messageText"});
+            const auto textnode = doc.selectFirst(node, "blockquote.messageText");
             if (textnode)
             {
                 const auto rawtext = extractMessageText(doc.getInnerHtml(textnode));
@@ -580,22 +765,18 @@ QVariant Xenforo::doGetPostList(ThreadPtr threadInfo, ParserBase::PostListOption
                 }
 
                 // extract the user avatar
-                QSgmlTag* avatarEl = node->getFirstElementByName("div","class",QRegExp{"avatarHolder"});
-                if (avatarEl)
+                QSgmlTag* imgEl = doc.selectFirst(node, "div.avatarHolder img");
+                if (imgEl && imgEl->hasAttribute("src"))
                 {
-                    QSgmlTag* imgEl = avatarEl->getFirstElementByName("img","src",QRegExp{});
-                    if (imgEl)
+                    const QString src = imgEl->getArgValue("src");
+                    if (src.startsWith("http://") || src.startsWith("https://"))
                     {
-                        const QString src = imgEl->getArgValue("src");
-                        if (src.startsWith("http://") || src.startsWith("https://"))
-                        {
-                            newpost->setIconUrl(src);
-                        }
-                        else
-                        {
-                            const QString iconUrl = QString("%1/%2").arg(getBaseUrl()).arg(imgEl->getArgValue("src"));
-                            newpost->setIconUrl(iconUrl);
-                        }
+                        newpost->setIconUrl(src);
+                    }
+                    else
+                    {
+                        const QString iconUrl = QString("%1/%2").arg(getBaseUrl()).arg(imgEl->getArgValue("src"));
+                        newpost->setIconUrl(iconUrl);
                     }
                 }
 
@@ -628,7 +809,7 @@ QVariant Xenforo::doSubmitNewThread(ThreadPtr threadInfo)
         .arg(this->getBaseUrl())
         .arg(strId);
 
-    const QString data = _webclient.DownloadString(createurl);
+    const QString data = downloadPage(createurl);
 
     QSgml createDoc;
     if (createDoc.parse(data))
@@ -688,7 +869,7 @@ QVariant Xenforo::doSubmitNewPost(PostPtr postInfo)
         .arg(this->getBaseUrl())
         .arg(strId);
 
-    const QString data = _webclient.DownloadString(createurl);
+    const QString data = downloadPage(createurl);
 
     QSgml createDoc;
     if (createDoc.parse(data))
@@ -744,7 +925,7 @@ ForumList Xenforo::getRootForumPrivate()
     const QString url = QString("%1/forums")
         .arg(this->getBaseUrl());
 
-    const QString data = _webclient.DownloadString(url);
+    const QString data = downloadPage(url);
 
     QSgml parseDoc;
     if (!parseDoc.parse(data))
@@ -752,7 +933,7 @@ ForumList Xenforo::getRootForumPrivate()
         OWL_THROW_EXCEPTION(Exception("bad parsing"));
     }
 
-    const auto tags = parseDoc.getElementsByName("li", "class", QRegExp{"level_1"});
+    const auto tags = parseDoc.select("li.level_1");
     if (tags.size())
     {
         QString strId;
@@ -767,7 +948,7 @@ ForumList Xenforo::getRootForumPrivate()
             newforum.reset();
 
             // luckily it seems that all of xenforo's 4 types of "nodes" all are labeled with this
-            const auto nodeTitle = t->getFirstElementByName("h3", "class", QRegExp{"nodeTitle"});
+            const auto nodeTitle = parseDoc.selectFirst(t, "h3.nodeTitle");
             if (nodeTitle)
             {
                 const auto alink = nodeTitle->getFirstElementByName("a", "href", QRegExp());
@@ -822,7 +1003,7 @@ ForumList Xenforo::getForumsPrivate(const QString &id)
         .arg(this->getBaseUrl())
         .arg(idFix);
 
-    const QString data = _webclient.DownloadString(url);
+    const QString data = downloadPage(url);
 
     QSgml parseDoc;
     if (!parseDoc.parse(data))
@@ -841,7 +1022,7 @@ ForumList Xenforo::getForumsPrivate(const QString &id)
             {
                 // ok, now the <ol class="nodeList"> elementwill have all this forum's children info as
                 // direct children
-                QSgmlTag* nodelistEl = linode->getFirstElementByName("ol", "class", QRegExp{"nodeList"});
+                QSgmlTag* nodelistEl = parseDoc.selectFirst(linode, "ol.nodeList");
                 if (nodelistEl)
                 {
                     auto iDisplayOrder = 1u;
@@ -894,8 +1075,7 @@ ForumList Xenforo::getForumsPrivate(const QString &id)
     }
     else
     {
-        const QRegExp nodeListRx { "nodeList" };
-        const auto nodeList = parseDoc.getElementsByName("ol", "class", nodeListRx);
+        const auto nodeList = parseDoc.select("ol.nodeList");
 
         // NOTE: no error if the size equal 0 because that is indicative of there being no subforums
         if (nodeList.size() > 0)
@@ -1031,21 +1211,14 @@ Forum::ForumType getForumType(const QString &strClass)
 
 QDateTime parseDateTime(QSgmlTag* lastPostDiv, QSgml* doc)
 {
-    QSgmlTag* timeNode = lastPostDiv->getFirstElementByName("abbr", "class", QRegExp{"DateTime"});
+    QSgmlTag* timeNode = doc->selectFirst(lastPostDiv, "abbr.DateTime");
     if (timeNode)
     {
-        bool ok = false;
-        const QString epochTimeStr = timeNode->getArgValue("data-time");
-        const qint64 epochTime = epochTimeStr.toULong(&ok);
-
-        if (ok)
-        {
-            return QDateTime::fromTime_t(epochTime);
-        }
+        return parseEpochTime(timeNode->getArgValue("data-time"));
     }
     else
     {
-        timeNode = lastPostDiv->getFirstElementByName("span", "class", QRegExp{"DateTime"});
+        timeNode = doc->selectFirst(lastPostDiv, "span.DateTime");
         if (timeNode)
         {
             QString timeStamp = timeNode->getArgValue("title");
@@ -1055,33 +1228,53 @@ QDateTime parseDateTime(QSgmlTag* lastPostDiv, QSgml* doc)
                 timeStamp = doc->getText(timeNode);
             }
 
-            if (!timeStamp.isEmpty())
-            {
-                QDateTime dt;
+            return parseDateTime(timeStamp);
+        }
+    }
 
-                std::vector<Qt::DateFormat> formats { Qt::TextDate, Qt::ISODate, Qt::SystemLocaleShortDate,
-                    Qt::SystemLocaleLongDate, Qt::DefaultLocaleShortDate, Qt::DefaultLocaleLongDate,
-                    Qt::SystemLocaleDate, Qt::LocaleDate, Qt::LocalDate, Qt::RFC2822Date};
+    return QDateTime();
+}
 
-                for (const auto dte : formats)
-                {
-                     dt = QDateTime::fromString(timeStamp, dte);
-                     if (dt.isValid())
-                     {
-                         return dt;
-                     }
-                }
+QDateTime parseEpochTime(const QString& epochTimeStr)
+{
+    bool ok = false;
+    const qint64 epochTime = epochTimeStr.toULong(&ok);
 
-                // if we're here, there's still no valid date, so let's try a couple formats manually
-                const std::vector<QString> vformats = { "MMM d, yyyy 'at' h:mm AP",  "MMM dd, yyyy 'at' hh:mm AP", "MMM dd, yyyy" };
-                for (const auto dtf : vformats)
-                {
-                    dt = QDateTime::fromString(timeStamp, dtf);
-                    if (dt.isValid())
-                    {
-                        return dt;
-                    }
-                }
+    if (ok)
+    {
+        return QDateTime::fromTime_t(epochTime);
+    }
+
+    return QDateTime();
+}
+
+QDateTime parseDateTime(const QString& timeStamp)
+{
+    if (!timeStamp.isEmpty())
+    {
+        QDateTime dt;
+
+        std::vector<Qt::DateFormat> formats { Qt::TextDate, Qt::ISODate, Qt::SystemLocaleShortDate,
+            Qt::SystemLocaleLongDate, Qt::DefaultLocaleShortDate, Qt::DefaultLocaleLongDate,
+            Qt::SystemLocaleDate, Qt::LocaleDate, Qt::LocalDate, Qt::RFC2822Date};
+
+        for (const auto dte : formats)
+        {
+             dt = QDateTime::fromString(timeStamp, dte);
+             if (dt.isValid())
+             {
+                 return dt;
+             }
+        }
+
+        // if we're here, there's still no valid date, so let's try a couple formats manually
+        const std::vector<QString> vformats = { "MMM d, yyyy 'at' h:mm AP",  "MMM dd, yyyy 'at' hh:mm AP", "MMM dd, yyyy" };
+        for (const auto dtf : vformats)
+        {
+            dt = QDateTime::fromString(timeStamp, dtf);
+            if (dt.isValid())
+            {
+                return dt;
             }
         }
     }
@@ -28,7 +28,7 @@ class Xenforo : public ParserBase
 public:
 
     Q_INVOKABLE Xenforo(const QString& url);
-    virtual ~Xenforo() = default;
+    virtual ~Xenforo();
 
     virtual ParserBasePtr clone(ParserBasePtr other = ParserBasePtr()) override;
 
@@ -41,6 +41,9 @@ public:
         return _webclient.getLastRequestUrl();
     }
 
+    virtual QByteArray saveSession() override;
+    virtual bool restoreSession(const LoginInfo& info, const QByteArray& session) override;
+
     // See ParserBase.h for more explanation about these two methods
     virtual const std::pair<uint, bool> defaultPostsPerPage() const override { return std::make_pair(20, true); }
     virtual const std::pair<uint, bool> defaultThreadsPerPage() const override { return std::make_pair(20, true); }
@@ -68,9 +71,16 @@ private:
     ForumList   getRootForumPrivate();
     ForumList   getForumsPrivate(const QString& id);
 
+    // downloads a page that requires us to be logged in, see restoreSession()
+    WebClient::ReplyPtr getPage(const QString& url, uint options = WebClient::DEFAULT);
+    QString     downloadPage(const QString& url, uint options = WebClient::DEFAULT);
+
     WebClient               _webclient;
     QString                 _logoutUrl;
 
+    LoginInfo               _loginInfo;
+    bool                    _sessionRestored = false;
+
     std::shared_ptr<spdlog::logger>  _logger;
 };
 
@@ -78,6 +88,8 @@ QSgmlTag*           getXParentsUp(QSgmlTag* source, uint i);
 QSgmlTag*           getXChildrenDown(QSgmlTag* source, uint i);
 Forum::ForumType    getForumType(const QString& strType);
 QDateTime           parseDateTime(QSgmlTag*, QSgml* doc);
+QDateTime           parseDateTime(const QString& timeStamp);
+QDateTime           parseEpochTime(const QString& epochTime);
 QString             extractMessageText(const QString& rawtext);
 
 } // namespace
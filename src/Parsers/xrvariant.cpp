@@ -51,6 +51,26 @@ XRVariant::XRVariant( const QString& xml )
 }
 
 
+XRVariant::XRVariant( const QByteArray& xml )
+{
+	QDomDocument doc;
+	if (doc.setContent(xml))
+	{
+		QDomNodeList nodeList = doc.elementsByTagName("value");
+
+		if (nodeList.count() > 0)
+		{
+            QDomElement tempElement = nodeList.at(0).toElement();
+			fromDomElement(tempElement);
+		}
+	}
+	else
+	{
+		throw std::logic_error("Could not parse XML from XML-RPC call");
+	}
+}
+
+
 XRVariant XRVariant::arrayFromDomElement(QDomElement& qde)
 {
     QDomNode a_n = qde.firstChild();
@@ -88,6 +88,12 @@ class XRVariant : public QVariant
 
 		XRVariant(const QString& xml);
 
+	/**
+	 * read an XML-RPC response straight from the bytes on the wire,
+	 * which skips decoding it to a QString first
+	 */
+		XRVariant(const QByteArray& xml);
+
 	/**
 	 * Reinitialize the XRVariant from this dom element
 	 */
@@ -0,0 +1,132 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <thread>
+#include "CancellationToken.h"
+#include "Exception.h"
+
+namespace owl
+{
+
+static thread_local CancellationTokenPtr __currentToken;
+
+CancellationToken::CancellationToken(Milliseconds timeout, CancellationTokenPtr parent)
+    : _parent(std::move(parent))
+{
+    if (timeout > Milliseconds::zero())
+    {
+        _deadline = Clock::now() + timeout;
+        _hasDeadline = true;
+    }
+}
+
+bool CancellationToken::isCancelled() const
+{
+    for (const CancellationToken* token = this; token != nullptr; token = token->_parent.get())
+    {
+        if (token->_cancelled || (token->_hasDeadline && Clock::now() >= token->_deadline))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CancellationToken::hasDeadline() const
+{
+    for (const CancellationToken* token = this; token != nullptr; token = token->_parent.get())
+    {
+        if (token->_hasDeadline)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+CancellationToken::Clock::time_point CancellationToken::deadline() const
+{
+    Clock::time_point retval = Clock::time_point::max();
+
+    for (const CancellationToken* token = this; token != nullptr; token = token->_parent.get())
+    {
+        if (token->_hasDeadline)
+        {
+            retval = std::min(retval, token->_deadline);
+        }
+    }
+
+    return retval;
+}
+
+CancellationToken::Milliseconds CancellationToken::remaining() const
+{
+    if (!hasDeadline())
+    {
+        return Milliseconds::max();
+    }
+
+    const auto now = Clock::now();
+    const auto until = deadline();
+
+    return until > now
+        ? std::chrono::duration_cast<Milliseconds>(until - now)
+        : Milliseconds::zero();
+}
+
+bool CancellationToken::waitFor(Milliseconds duration) const
+{
+    // cancel() doesn't signal anything, so the wait is done in slices short
+    // enough that a cancelled operation lets go quickly
+    static const Milliseconds slice { 25 };
+
+    const auto until = Clock::now() + duration;
+
+    while (!isCancelled())
+    {
+        const auto now = Clock::now();
+        if (now >= until)
+        {
+            return true;
+        }
+
+        std::this_thread::sleep_for(std::min<Clock::duration>(slice, until - now));
+    }
+
+    return false;
+}
+
+void CancellationToken::throwIfCancelled() const
+{
+    if (!isCancelled())
+    {
+        return;
+    }
+
+    if (hasDeadline() && remaining() == Milliseconds::zero())
+    {
+        OWL_THROW_EXCEPTION(TimeoutException(QStringLiteral("The operation timed out")));
+    }
+
+    OWL_THROW_EXCEPTION(CancelledException(QStringLiteral("The operation was cancelled")));
+}
+
+CancellationTokenPtr CancellationToken::current()
+{
+    return __currentToken;
+}
+
+CancellationToken::Scope::Scope(CancellationTokenPtr token)
+    : _previous(std::move(__currentToken))
+{
+    __currentToken = std::move(token);
+}
+
+CancellationToken::Scope::~Scope()
+{
+    __currentToken = std::move(_previous);
+}
+
+} // namespace owl
@@ -0,0 +1,82 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <QtCore>
+
+namespace owl
+{
+
+class CancellationToken;
+using CancellationTokenPtr = std::shared_ptr<CancellationToken>;
+
+// Lets an operation be stopped from another thread, either explicitly with
+// cancel() or because its deadline passed. A token is also cancelled when
+// its parent is, so an operation that is made up of several steps can hand
+// each one a token with its own deadline that still stops with the whole.
+//
+// The token of the operation running on a thread is installed with a Scope,
+// anything further down (WebClient, the Lua hook) picks it up with current()
+// so it doesn't have to be passed through every call.
+class CancellationToken
+{
+public:
+    using Clock         = std::chrono::steady_clock;
+    using Milliseconds  = std::chrono::milliseconds;
+
+    // a timeout of zero means no deadline
+    explicit CancellationToken(Milliseconds timeout = Milliseconds::zero(),
+        CancellationTokenPtr parent = CancellationTokenPtr());
+
+    void cancel() { _cancelled = true; }
+
+    // true once cancel() was called on this token or a parent, or a deadline passed
+    bool isCancelled() const;
+
+    // true if this token or one of its parents has a deadline
+    bool hasDeadline() const;
+
+    // the earliest deadline of this token and its parents
+    Clock::time_point deadline() const;
+
+    // time left until deadline(), zero once it has passed and
+    // Milliseconds::max() if there is no deadline
+    Milliseconds remaining() const;
+
+    // sleeps for the given time or until the token is cancelled, whichever comes
+    // first, and returns false in the latter case
+    bool waitFor(Milliseconds duration) const;
+
+    // throws a CancelledException if isCancelled(), a TimeoutException if
+    // that's because a deadline passed
+    void throwIfCancelled() const;
+
+    // the token installed on the calling thread, may be null
+    static CancellationTokenPtr current();
+
+    // installs a token on the calling thread for the lifetime of the
+    // Scope, the previous one is put back afterwards
+    class Scope
+    {
+    public:
+        explicit Scope(CancellationTokenPtr token);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CancellationTokenPtr    _previous;
+    };
+
+private:
+    std::atomic<bool>       _cancelled { false };
+    Clock::time_point       _deadline;
+    bool                    _hasDeadline = false;
+    CancellationTokenPtr    _parent;
+};
+
+} // namespace owl
@@ -0,0 +1,246 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <QRandomGenerator>
+
+#include "CookieStore.h"
+
+#include <Utils/OwlLogger.h>
+
+namespace owl
+{
+
+static const QByteArray SESSION_MAGIC       = QByteArrayLiteral("OWLS");
+static const char       SESSION_VERSION     = 1;
+static const int        SESSION_NONCE_SIZE  = 16;
+static const int        SESSION_MAC_SIZE    = 32; // HMAC-SHA256
+
+static QByteArray deriveKey(const QByteArray& key, const char* purpose)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(purpose);
+    hash.addData(key);
+    return hash.result();
+}
+
+// XORs the data with a SHA-256 keystream in counter mode, which makes
+// obfuscating and restoring the same operation. This is not a vetted cipher
+// and the key is stored in plain text, see CookieStore
+static QByteArray applyKeystream(const QByteArray& key, const QByteArray& nonce, const QByteArray& data)
+{
+    QByteArray retval(data);
+    QByteArray block;
+
+    for (int i = 0; i < retval.size(); i++)
+    {
+        const int offset = i % SESSION_MAC_SIZE;
+        if (offset == 0)
+        {
+            const quint64 counter = qToBigEndian<quint64>(static_cast<quint64>(i / SESSION_MAC_SIZE));
+
+            QCryptographicHash hash(QCryptographicHash::Sha256);
+            hash.addData(key);
+            hash.addData(nonce);
+            hash.addData(reinterpret_cast<const char*>(&counter), sizeof(counter));
+            block = hash.result();
+        }
+
+        retval[i] = static_cast<char>(retval[i] ^ block[offset]);
+    }
+
+    return retval;
+}
+
+// compares without bailing out early so the time taken doesn't leak how much matched
+static bool constantTimeEquals(const QByteArray& left, const QByteArray& right)
+{
+    if (left.size() != right.size())
+    {
+        return false;
+    }
+
+    char diff = 0;
+    for (int i = 0; i < left.size(); i++)
+    {
+        diff |= left[i] ^ right[i];
+    }
+
+    return diff == 0;
+}
+
+CookieStore& CookieStore::instance()
+{
+    static CookieStore __store;
+    return __store;
+}
+
+CookieStore::CookieStore()
+    : _logger(owl::initializeLogger("CookieStore"))
+{
+}
+
+QString CookieStore::getPath() const
+{
+    Lock lock(_mutex);
+    return _path;
+}
+
+void CookieStore::setPath(const QString& path)
+{
+    Lock lock(_mutex);
+
+    if (!path.isEmpty())
+    {
+        QDir dir(path);
+        if (!dir.exists() && !dir.mkpath(QStringLiteral(".")))
+        {
+            _logger->warn("Could not create sessions folder '{}', sessions will not be saved", path.toStdString());
+            _path.clear();
+            return;
+        }
+
+        // other users can't list or read the sessions
+        if (!QFile::setPermissions(dir.absolutePath(),
+                QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner))
+        {
+            _logger->warn("Could not restrict the permissions of sessions folder '{}'", path.toStdString());
+        }
+
+        _logger->debug("Saving board sessions in '{}'", path.toStdString());
+    }
+
+    _path = path;
+}
+
+bool CookieStore::isEnabled() const
+{
+    Lock lock(_mutex);
+    return !_path.isEmpty() && !_key.isEmpty();
+}
+
+void CookieStore::setKey(const QByteArray& key)
+{
+    Lock lock(_mutex);
+    _key = key;
+}
+
+QByteArray CookieStore::generateKey()
+{
+    QByteArray retval(32, '\0');
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(retval.data()),
+        retval.size() / static_cast<int>(sizeof(quint32)));
+
+    return retval;
+}
+
+bool CookieStore::save(const QString& id, const QByteArray& session)
+{
+    Lock lock(_mutex);
+
+    if (_path.isEmpty() || _key.isEmpty())
+    {
+        return false;
+    }
+
+    QSaveFile file(filename(id));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        _logger->warn("Could not open session file '{}' for writing", file.fileName().toStdString());
+        return false;
+    }
+
+    // restrict the temporary file before anything is written to it, it
+    // replaces the session file with its permissions
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    file.write(obfuscate(_key, session));
+
+    if (!file.commit())
+    {
+        _logger->warn("Could not write session file '{}'", file.fileName().toStdString());
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray CookieStore::load(const QString& id) const
+{
+    Lock lock(_mutex);
+
+    if (_path.isEmpty() || _key.isEmpty())
+    {
+        return QByteArray();
+    }
+
+    QFile file(filename(id));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    const QByteArray retval = deobfuscate(_key, file.readAll());
+    if (retval.isEmpty())
+    {
+        _logger->warn("Ignoring session file '{}' that could not be authenticated", file.fileName().toStdString());
+    }
+
+    return retval;
+}
+
+void CookieStore::remove(const QString& id)
+{
+    Lock lock(_mutex);
+
+    if (!_path.isEmpty())
+    {
+        QFile::remove(filename(id));
+    }
+}
+
+QByteArray CookieStore::obfuscate(const QByteArray& key, const QByteArray& session)
+{
+    QByteArray nonce(SESSION_NONCE_SIZE, '\0');
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(nonce.data()),
+        SESSION_NONCE_SIZE / static_cast<int>(sizeof(quint32)));
+
+    QByteArray retval;
+    retval.append(SESSION_MAGIC);
+    retval.append(SESSION_VERSION);
+    retval.append(nonce);
+    retval.append(applyKeystream(deriveKey(key, "owl.session.encrypt"), nonce, session));
+    retval.append(QMessageAuthenticationCode::hash(retval, deriveKey(key, "owl.session.mac"), QCryptographicHash::Sha256));
+
+    return retval;
+}
+
+QByteArray CookieStore::deobfuscate(const QByteArray& key, const QByteArray& data)
+{
+    const int headerSize = SESSION_MAGIC.size() + 1 + SESSION_NONCE_SIZE;
+
+    if (data.size() < headerSize + SESSION_MAC_SIZE
+        || !data.startsWith(SESSION_MAGIC)
+        || data.at(SESSION_MAGIC.size()) != SESSION_VERSION)
+    {
+        return QByteArray();
+    }
+
+    const QByteArray signedData = data.left(data.size() - SESSION_MAC_SIZE);
+    const QByteArray mac = QMessageAuthenticationCode::hash(signedData, deriveKey(key, "owl.session.mac"), QCryptographicHash::Sha256);
+    if (!constantTimeEquals(mac, data.right(SESSION_MAC_SIZE)))
+    {
+        return QByteArray();
+    }
+
+    const QByteArray nonce = data.mid(SESSION_MAGIC.size() + 1, SESSION_NONCE_SIZE);
+    return applyKeystream(deriveKey(key, "owl.session.encrypt"), nonce, signedData.mid(headerSize));
+}
+
+QString CookieStore::filename(const QString& id) const
+{
+    const QString name = QString::fromLatin1(
+        QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha1).toHex());
+
+    return QDir(_path).absoluteFilePath(name + QStringLiteral(".session"));
+}
+
+} // namespace
@@ -0,0 +1,72 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <QtCore>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+// Keeps each board's session (cookie jar and whatever else the parser needs
+// to resume it) on disk between runs so boards don't have to log in again on
+// every start. Sessions are stored one per file that only the user can read,
+// and are authenticated with an HMAC so a file that was tampered with or
+// written with another key is ignored.
+//
+// The contents are obfuscated, not encrypted: they are XORed with a keystream
+// made from SHA-256, and the key sits in the settings file (web.sessions.key)
+// next to the sessions. That keeps cookies from showing up in a grep of the
+// disk, but anyone who can read the settings can read the sessions.
+class CookieStore
+{
+    using Mutex = std::mutex;
+    using Lock  = std::lock_guard<std::mutex>;
+
+public:
+    static CookieStore& instance();
+
+    CookieStore();
+    virtual ~CookieStore() = default;
+
+    // an empty path disables the store
+    QString getPath() const;
+    void setPath(const QString& path);
+
+    bool isEnabled() const;
+
+    // the secret both the obfuscation and the authentication keys are derived from
+    void setKey(const QByteArray& key);
+
+    // generates a new random secret suitable for setKey()
+    static QByteArray generateKey();
+
+    bool save(const QString& id, const QByteArray& session);
+
+    // returns an empty array if there is no session or if it cannot be read
+    QByteArray load(const QString& id) const;
+
+    void remove(const QString& id);
+
+    // Obfuscates/restores a session with the given secret. deobfuscate() returns
+    // an empty array if the data is malformed or fails authentication
+    static QByteArray obfuscate(const QByteArray& key, const QByteArray& session);
+    static QByteArray deobfuscate(const QByteArray& key, const QByteArray& data);
+
+private:
+    QString filename(const QString& id) const;
+
+    mutable Mutex                       _mutex;
+    QString                             _path;
+    QByteArray                          _key;
+
+    std::shared_ptr<spdlog::logger>     _logger;
+};
+
+} // namespace
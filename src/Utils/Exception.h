@@ -76,6 +76,30 @@ public:
     using Exception::Exception;
 };
 
+// thrown when an operation is stopped through its CancellationToken, either
+// because it was cancelled or because it ran past its deadline
+class CancelledException : public Exception
+{
+
+public:
+    virtual ~CancelledException() = default;
+
+    using Exception::Exception;
+};
+
+// the CancelledException of an operation that ran past its deadline, which
+// unlike being cancelled on purpose is a failure
+class TimeoutException final : public CancelledException
+{
+
+public:
+    virtual ~TimeoutException() = default;
+
+    explicit TimeoutException(const QString& msg)
+        : CancelledException(msg)
+    {}
+};
+
 class WebException : public Exception
 {
     
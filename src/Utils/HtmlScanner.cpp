@@ -0,0 +1,479 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <algorithm>
+#include "HtmlScanner.h"
+
+namespace owl
+{
+
+namespace
+{
+
+// elements that never have content and so never get an end-tag
+const QSet<QString> voidElements =
+{
+    "area", "base", "br", "col", "embed", "hr", "img", "input",
+    "link", "meta", "param", "source", "track", "wbr"
+};
+
+// elements whose content is not markup and is skipped up to their end-tag
+const QSet<QString> rawTextElements = { "script", "style" };
+
+bool isNameChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '-' || c == '_' || c == ':';
+}
+
+} // namespace
+
+bool HtmlScanner::Element::hasClass(const QString& className) const
+{
+    const QString classes = attributes.value("class");
+
+    int pos = classes.indexOf(className);
+    while (pos != -1 && !className.isEmpty())
+    {
+        const int end = pos + className.length();
+        if ((pos == 0 || classes.at(pos - 1).isSpace())
+            && (end == classes.length() || classes.at(end).isSpace()))
+        {
+            return true;
+        }
+
+        pos = classes.indexOf(className, pos + 1);
+    }
+
+    return false;
+}
+
+void HtmlScanner::onStart(const QString& selector, Callback callback)
+{
+    _startHandlers.push_back({ parseSelector(selector), std::move(callback) });
+}
+
+void HtmlScanner::onEnd(const QString& selector, Callback callback)
+{
+    _endHandlers.push_back({ parseSelector(selector), std::move(callback) });
+}
+
+void HtmlScanner::feed(const QString& chunk)
+{
+    _buffer.append(chunk);
+    scan();
+
+    // drop what has been scanned, what's left is the start of a tag that
+    // hasn't fully arrived yet
+    _buffer.remove(0, _pos);
+    _pos = 0;
+}
+
+void HtmlScanner::feedUtf8(std::string_view data)
+{
+    constexpr std::size_t pieceSize = 64 * 1024;
+
+    if (!_decoder)
+    {
+        _decoder.reset(QTextCodec::codecForName("UTF-8")->makeDecoder());
+    }
+
+    for (std::size_t pos = 0; pos < data.size(); pos += pieceSize)
+    {
+        const auto piece = data.substr(pos, pieceSize);
+        feed(_decoder->toUnicode(piece.data(), static_cast<int>(piece.size())));
+    }
+}
+
+void HtmlScanner::finish()
+{
+    _finished = true;
+    scan();
+
+    _buffer.clear();
+    _pos = 0;
+
+    while (!_frames.empty())
+    {
+        popFrame();
+    }
+}
+
+HtmlScanner::Selector HtmlScanner::parseSelector(const QString& selector)
+{
+    Selector retval;
+
+    for (const QString& part : selector.simplified().split(' ', QString::SkipEmptyParts))
+    {
+        SimpleSelector simple;
+        QChar kind;
+        int start = 0;
+
+        for (int i = 0; i <= part.length(); i++)
+        {
+            if (i < part.length() && part.at(i) != '.' && part.at(i) != '#')
+            {
+                continue;
+            }
+
+            const QString word = part.mid(start, i - start);
+            if (kind.isNull())
+            {
+                simple.name = word == "*" ? QString() : word.toLower();
+            }
+            else if (kind == '.' && !word.isEmpty())
+            {
+                simple.classes.append(word);
+            }
+            else if (kind == '#')
+            {
+                simple.id = word;
+            }
+
+            kind = i < part.length() ? part.at(i) : QChar();
+            start = i + 1;
+        }
+
+        retval.push_back(simple);
+    }
+
+    return retval;
+}
+
+bool HtmlScanner::matches(const Element& element, const SimpleSelector& simple)
+{
+    if (!simple.name.isEmpty() && element.name != simple.name)
+    {
+        return false;
+    }
+
+    if (!simple.id.isEmpty() && element.attribute("id") != simple.id)
+    {
+        return false;
+    }
+
+    for (const QString& className : simple.classes)
+    {
+        if (!element.hasClass(className))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// whether the selector matches the innermost open element
+bool HtmlScanner::matches(const Selector& selector) const
+{
+    if (selector.empty() || !matches(_frames.back().element, selector.back()))
+    {
+        return false;
+    }
+
+    return matchesAncestors(selector, static_cast<int>(selector.size()) - 2,
+        static_cast<int>(_frames.size()) - 2);
+}
+
+bool HtmlScanner::matchesAncestors(const Selector& selector, int selectorIndex, int frameIndex) const
+{
+    if (selectorIndex < 0)
+    {
+        return true;
+    }
+
+    for (int i = frameIndex; i >= 0; i--)
+    {
+        if (matches(_frames.at(i).element, selector.at(selectorIndex))
+            && matchesAncestors(selector, selectorIndex - 1, i - 1))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void HtmlScanner::scan()
+{
+    const int length = _buffer.length();
+
+    while (_pos < length)
+    {
+        if (!_rawTextEnd.isEmpty())
+        {
+            const int end = _buffer.indexOf(_rawTextEnd, _pos, Qt::CaseInsensitive);
+            if (end == -1)
+            {
+                // keep enough to find the end-tag if it's split between chunks
+                _pos = _finished ? length : std::max(_pos, length - _rawTextEnd.length());
+                return;
+            }
+
+            _pos = end;
+            _rawTextEnd.clear();
+        }
+
+        const int start = _buffer.indexOf('<', _pos);
+        if (start == -1)
+        {
+            appendText(_pos, length);
+            _pos = length;
+            return;
+        }
+
+        appendText(_pos, start);
+        _pos = start;
+
+        if (start + 1 >= length)
+        {
+            break;
+        }
+
+        const QChar next = _buffer.at(start + 1);
+        if (_buffer.midRef(start, 4) == QLatin1String("<!--"))
+        {
+            const int end = _buffer.indexOf(QLatin1String("-->"), start + 4);
+            if (end == -1)
+            {
+                break;
+            }
+
+            _pos = end + 3;
+        }
+        else if (next == '!' || next == '?' || next == '/' || next.isLetter())
+        {
+            const int end = findTagEnd(start + 1);
+            if (end == -1)
+            {
+                break;
+            }
+
+            if (next == '/')
+            {
+                int nameEnd = start + 2;
+                while (nameEnd < end && isNameChar(_buffer.at(nameEnd)))
+                {
+                    nameEnd++;
+                }
+
+                endElement(_buffer.mid(start + 2, nameEnd - start - 2).toLower());
+            }
+            else if (next.isLetter())
+            {
+                startElement(start + 1, end);
+            }
+
+            _pos = end + 1;
+        }
+        else
+        {
+            // a '<' that doesn't start a tag is text
+            appendText(start, start + 1);
+            _pos = start + 1;
+        }
+    }
+
+    if (_finished)
+    {
+        // a tag that never ended
+        _pos = length;
+    }
+}
+
+void HtmlScanner::appendText(int start, int end)
+{
+    if (_collecting > 0 && end > start)
+    {
+        _text.append(_buffer.midRef(start, end - start));
+    }
+}
+
+// the position of the '>' that ends the tag, skipping over quoted values
+int HtmlScanner::findTagEnd(int start) const
+{
+    QChar quote;
+    QChar previous;     // the last character that wasn't whitespace
+
+    for (int i = start; i < _buffer.length(); i++)
+    {
+        const QChar c = _buffer.at(i);
+        if (!quote.isNull())
+        {
+            if (c == quote)
+            {
+                quote = QChar();
+            }
+        }
+        else if ((c == '"' || c == '\'') && previous == '=')
+        {
+            quote = c;
+        }
+        else if (c == '>')
+        {
+            return i;
+        }
+
+        if (!c.isSpace())
+        {
+            previous = c;
+        }
+    }
+
+    return -1;
+}
+
+// parses the tag between start and end, which excludes the angle brackets
+void HtmlScanner::startElement(int start, int end)
+{
+    Frame frame;
+
+    int i = start;
+    while (i < end && isNameChar(_buffer.at(i)))
+    {
+        i++;
+    }
+    frame.element.name = _buffer.mid(start, i - start).toLower();
+
+    bool selfClosing = false;
+    while (i < end)
+    {
+        const QChar c = _buffer.at(i);
+        if (c.isSpace())
+        {
+            i++;
+            continue;
+        }
+
+        if (c == '/')
+        {
+            selfClosing = true;
+            i++;
+            continue;
+        }
+
+        selfClosing = false;
+
+        const int keyStart = i;
+        while (i < end && !_buffer.at(i).isSpace() && _buffer.at(i) != '=' && _buffer.at(i) != '/')
+        {
+            i++;
+        }
+        const QString key = _buffer.mid(keyStart, i - keyStart).toLower();
+
+        while (i < end && _buffer.at(i).isSpace())
+        {
+            i++;
+        }
+
+        QString value;
+        if (i < end && _buffer.at(i) == '=')
+        {
+            i++;
+            while (i < end && _buffer.at(i).isSpace())
+            {
+                i++;
+            }
+
+            if (i < end && (_buffer.at(i) == '"' || _buffer.at(i) == '\''))
+            {
+                const QChar quote = _buffer.at(i);
+                const int valueStart = ++i;
+                while (i < end && _buffer.at(i) != quote)
+                {
+                    i++;
+                }
+                value = _buffer.mid(valueStart, i - valueStart);
+                i++;
+            }
+            else
+            {
+                const int valueStart = i;
+                while (i < end && !_buffer.at(i).isSpace())
+                {
+                    i++;
+                }
+                value = _buffer.mid(valueStart, i - valueStart);
+            }
+        }
+
+        if (!key.isEmpty() && !frame.element.attributes.contains(key))
+        {
+            frame.element.attributes.insert(key, value);
+        }
+    }
+
+    _frames.push_back(std::move(frame));
+    Frame& current = _frames.back();
+
+    for (const auto& handler : _startHandlers)
+    {
+        if (matches(handler.selector))
+        {
+            handler.callback(current.element);
+        }
+    }
+
+    for (std::size_t h = 0; h < _endHandlers.size(); h++)
+    {
+        if (matches(_endHandlers.at(h).selector))
+        {
+            current.endHandlers.push_back(static_cast<int>(h));
+        }
+    }
+
+    if (!current.endHandlers.empty())
+    {
+        current.textStart = _text.length();
+        _collecting++;
+    }
+
+    const QString name = current.element.name;
+    if (selfClosing || voidElements.contains(name))
+    {
+        popFrame();
+    }
+    else if (rawTextElements.contains(name))
+    {
+        _rawTextEnd = "</" + name;
+    }
+}
+
+// closes the element and the ones inside it that weren't closed, an end-tag
+// without an open element is ignored
+void HtmlScanner::endElement(const QString& name)
+{
+    for (auto i = _frames.size(); i > 0; i--)
+    {
+        if (_frames.at(i - 1).element.name == name)
+        {
+            while (_frames.size() >= i)
+            {
+                popFrame();
+            }
+            return;
+        }
+    }
+}
+
+void HtmlScanner::popFrame()
+{
+    Frame& frame = _frames.back();
+
+    if (!frame.endHandlers.empty())
+    {
+        frame.element.text = _text.mid(frame.textStart);
+        for (const auto h : frame.endHandlers)
+        {
+            _endHandlers.at(static_cast<std::size_t>(h)).callback(frame.element);
+        }
+
+        if (--_collecting == 0)
+        {
+            _text.clear();
+        }
+    }
+
+    _frames.pop_back();
+}
+
+} // namespace
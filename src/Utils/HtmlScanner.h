@@ -0,0 +1,100 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <QtCore>
+
+namespace owl
+{
+
+// Pulls fields out of an HTML page without building a QSgml tree. A parser
+// registers the elements it cares about with selectors in the syntax that
+// QSgml::select() takes, like "li.discussionListItem a.username", and is
+// called back at their start-tags with their attributes and at their end-tags
+// with their text as well. The scanner only keeps the chain of open elements,
+// and the text of the page only while an element that wants it is open.
+//
+// The page can be fed in chunks as it arrives. A tag that is cut off at the
+// end of a chunk is held back until the rest of it comes in, and finish()
+// closes whatever elements are still open at the end.
+class HtmlScanner
+{
+public:
+    struct Element
+    {
+        QString                 name;           // lowercase
+        QHash<QString, QString> attributes;     // lowercase keys
+        QString                 text;           // only set for end-tag callbacks
+
+        QString attribute(const QString& key) const { return attributes.value(key); }
+        bool hasClass(const QString& className) const;
+    };
+
+    using Callback = std::function<void(const Element&)>;
+
+    // callbacks have to be registered before the first call to feed()
+    void onStart(const QString& selector, Callback callback);
+    void onEnd(const QString& selector, Callback callback);
+
+    void feed(const QString& chunk);
+
+    // decodes the UTF-8 bytes a piece at a time and feeds them, so a page
+    // never has to be converted to a QString all at once
+    void feedUtf8(std::string_view data);
+
+    void finish();
+
+private:
+    struct SimpleSelector
+    {
+        QString     name;
+        QString     id;
+        QStringList classes;
+    };
+    using Selector = std::vector<SimpleSelector>;
+
+    struct Handler
+    {
+        Selector    selector;
+        Callback    callback;
+    };
+
+    struct Frame
+    {
+        Element             element;
+        std::vector<int>    endHandlers;    // indices into _endHandlers
+        int                 textStart = 0;  // where the element's text starts in _text
+    };
+
+    static Selector parseSelector(const QString& selector);
+    static bool matches(const Element& element, const SimpleSelector& simple);
+    bool matches(const Selector& selector) const;
+    bool matchesAncestors(const Selector& selector, int selectorIndex, int frameIndex) const;
+
+    // scans _buffer from _pos and returns when it runs into an incomplete tag
+    void scan();
+    void appendText(int start, int end);
+    int findTagEnd(int start) const;
+    void startElement(int start, int end);
+    void endElement(const QString& name);
+    void popFrame();
+
+    std::vector<Handler>    _startHandlers;
+    std::vector<Handler>    _endHandlers;
+
+    std::vector<Frame>      _frames;
+    int                     _collecting = 0;    // open frames that want their text
+
+    QString                 _buffer;            // the part of the page not scanned yet
+    int                     _pos = 0;
+    QString                 _text;              // text since the first collecting frame opened
+    QString                 _rawTextEnd;        // the end-tag of the script or style we're in
+    std::unique_ptr<QTextDecoder> _decoder;     // holds a character split between feedUtf8() calls
+    bool                    _finished = false;
+};
+
+} // namespace
@@ -153,4 +153,37 @@ QString previewText(const QString &original)
     return previewText(original, 128);
 }
 
+QDateTime parseHttpDate(const QString& value)
+{
+    // servers are required to send the IMF-fixdate format but the obsolete
+    // RFC 850 and asctime() formats must still be accepted
+    static const QStringList formats =
+    {
+        QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'"),
+        QStringLiteral("dddd, dd-MMM-yy hh:mm:ss 'GMT'"),
+        QStringLiteral("ddd MMM d hh:mm:ss yyyy")
+    };
+
+    const QString trimmed = value.simplified();
+    const QLocale locale = QLocale::c();
+
+    for (const auto& format : formats)
+    {
+        QDateTime dt = locale.toDateTime(trimmed, format);
+        if (dt.isValid())
+        {
+            // two digit years are relative to 1900 in Qt
+            if (dt.date().year() < 1970)
+            {
+                dt = dt.addYears(100);
+            }
+
+            dt.setTimeSpec(Qt::UTC);
+            return dt;
+        }
+    }
+
+    return QDateTime();
+}
+
 } // owl namespace
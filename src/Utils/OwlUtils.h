@@ -20,6 +20,9 @@ int randomInteger(int low, int high);
 QString previewText(const QString &original);
 QString previewText(const QString& original, uint maxLen);
 
+// Parses an HTTP-date (RFC 7231), returns an invalid QDateTime on failure
+QDateTime parseHttpDate(const QString& value);
+
 template <typename T>
 bool numericEquals(T x, T y)
 {
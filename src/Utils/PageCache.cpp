@@ -0,0 +1,108 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "PageCache.h"
+
+namespace owl
+{
+
+PageCache::PageCache(Milliseconds ttl, int capacity)
+    : _ttl(ttl),
+      _capacity(std::max(1, capacity))
+{
+}
+
+PageCache::Milliseconds PageCache::getTtl() const
+{
+    Lock lock(_mutex);
+    return _ttl;
+}
+
+void PageCache::setTtl(Milliseconds ttl)
+{
+    Lock lock(_mutex);
+    _ttl = ttl;
+}
+
+QString PageCache::makeKey(const QString& type, const QString& itemId, int page, int perPage, int options)
+{
+    return QString("%1/%2/%3/%4/%5").arg(type).arg(itemId).arg(page).arg(perPage).arg(options);
+}
+
+void PageCache::put(const QString& key, const QVariant& value)
+{
+    Lock lock(_mutex);
+
+    const auto now = Clock::now();
+    purge(now);
+
+    if (!_entries.contains(key))
+    {
+        while (_entries.size() >= _capacity)
+        {
+            auto oldest = _entries.begin();
+            for (auto it = _entries.begin(); it != _entries.end(); ++it)
+            {
+                if (it->stored < oldest->stored)
+                {
+                    oldest = it;
+                }
+            }
+
+            _entries.erase(oldest);
+        }
+    }
+
+    _entries.insert(key, Entry { now, value });
+}
+
+QVariant PageCache::take(const QString& key)
+{
+    Lock lock(_mutex);
+    purge(Clock::now());
+
+    return _entries.take(key).value;
+}
+
+bool PageCache::contains(const QString& key) const
+{
+    Lock lock(_mutex);
+
+    auto it = _entries.find(key);
+    return it != _entries.end() && Clock::now() - it->stored < _ttl;
+}
+
+void PageCache::remove(const QString& key)
+{
+    Lock lock(_mutex);
+    _entries.remove(key);
+}
+
+void PageCache::clear()
+{
+    Lock lock(_mutex);
+    _entries.clear();
+}
+
+int PageCache::size() const
+{
+    Lock lock(_mutex);
+    return _entries.size();
+}
+
+void PageCache::purge(Clock::time_point now)
+{
+    for (auto it = _entries.begin(); it != _entries.end();)
+    {
+        if (now - it->stored >= _ttl)
+        {
+            it = _entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+} // namespace owl
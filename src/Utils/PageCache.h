@@ -0,0 +1,62 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <QtCore>
+
+namespace owl
+{
+
+// In-memory cache of pages that were fetched and parsed ahead of the user,
+// e.g. the next page of the thread they're reading. Entries expire after
+// the cache's time-to-live and are handed out once, so asking for the same
+// page a second time goes back to the board. When the cache is full the
+// oldest entry makes room for the new one.
+class PageCache
+{
+    using Mutex = std::mutex;
+    using Lock  = std::lock_guard<std::mutex>;
+
+public:
+    using Clock         = std::chrono::steady_clock;
+    using Milliseconds  = std::chrono::milliseconds;
+
+    explicit PageCache(Milliseconds ttl = std::chrono::seconds(60), int capacity = 16);
+    virtual ~PageCache() = default;
+
+    Milliseconds getTtl() const;
+    void setTtl(Milliseconds ttl);
+
+    // identifies a page of an item, e.g. ("posts", threadId, 2, 25)
+    static QString makeKey(const QString& type, const QString& itemId, int page, int perPage, int options = 0);
+
+    void put(const QString& key, const QVariant& value);
+
+    // removes and returns the entry, or an invalid QVariant if there's no fresh entry
+    QVariant take(const QString& key);
+
+    bool contains(const QString& key) const;
+    void remove(const QString& key);
+    void clear();
+
+    int size() const;
+
+private:
+    struct Entry
+    {
+        Clock::time_point   stored;
+        QVariant            value;
+    };
+
+    // must be called with the lock held
+    void purge(Clock::time_point now);
+
+    mutable Mutex               _mutex;
+    Milliseconds                _ttl;
+    const int                   _capacity;
+    QHash<QString, Entry>       _entries;
+};
+
+} // namespace
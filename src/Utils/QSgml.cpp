@@ -21,41 +21,96 @@ This is free software, and you are welcome to redistribute it
 under certain conditions.
 ------------------------------------------------------------------------------------------*/ 
  
+#include <algorithm>
+#include <QPair>
+#include <QSet>
 #include "QSgml.h"
 
+namespace
+{
+
+// elements that never have content, they are made standalone-tags right away
+// instead of collecting the rest of their parent as children until its end-tag
+const QSet<QString> voidElements =
+{
+   "area", "base", "br", "col", "embed", "hr", "img", "input",
+   "link", "meta", "param", "source", "track", "wbr"
+};
+
+// the character at iPos or a null character past the end of the string
+inline QChar charAt(const QString &HtmlString,int iPos)
+{
+   return iPos<HtmlString.length() ? HtmlString.at(iPos) : QChar();
+}
+
+// tags that selectors can match
+inline bool isElement(const QSgmlTag *pTag)
+{
+   return (pTag->Type==QSgmlTag::eStartTag)||(pTag->Type==QSgmlTag::eStandalone)||(pTag->Type==QSgmlTag::eStartEmpty);
+}
+
+// whether Class is one of the whitespace separated words of Classes
+bool hasClass(const QString &Classes,const QString &Class)
+{
+   int iPos = Classes.indexOf(Class);
+   while( iPos!=-1 )
+   {
+      const int iEnd = iPos+Class.length();
+      if( ((iPos==0)||Classes.at(iPos-1).isSpace())&&((iEnd==Classes.length())||Classes.at(iEnd).isSpace()) )
+      {
+         return(true);
+      }
+      iPos = Classes.indexOf(Class,iPos+1);
+   }
+   return(false);
+}
+
+} // namespace
+
 // find the start of a tag
 void QSgml::FindStart(const QString &HtmlString,int &iPos)
 {
-   iPos=HtmlString.indexOf("<",iPos);
+   iPos=HtmlString.indexOf(QLatin1Char('<'),iPos);
 }
 
 // find the end of a tag
 // make sure the '>' is not in a quote
+// a tag that is never closed runs to the end of the string
 void QSgml::FindEnd(const QString &HtmlString,int &iPos)
 {
-   for( ; iPos<HtmlString.length() ; iPos++ )
+   const int iLength = HtmlString.length();
+   const QChar *pData = HtmlString.constData();
+
+   for( ; iPos<iLength ; iPos++ )
    {
+      const QChar c = pData[iPos];
+
       // Its a tag end
-      if( HtmlString.at(iPos)=='>' )
+      if( c=='>' )
       {
          return;
       }
-      if( HtmlString.at(iPos)=='\'' )
-      {
-         iPos=HtmlString.indexOf("\'",iPos+1);
-      }
-      if( HtmlString.at(iPos)=='\"' )
+      if( (c=='\'')||(c=='\"') )
       {
-         iPos=HtmlString.indexOf("\"",iPos+1);
+         iPos=HtmlString.indexOf(c,iPos+1);
+         if( iPos==-1 )
+         {
+            break;
+         }
       }
    }
-   iPos = -1;
+   iPos = iLength;
 }
 
 // find and of a comment
+// a comment that is never closed runs to the end of the string
 void QSgml::FindEndComment(const QString &HtmlString,int &iPos)
 {
-   iPos = HtmlString.indexOf("-->",iPos);
+   iPos = HtmlString.indexOf(QLatin1String("-->"),iPos);
+   if( iPos==-1 )
+   {
+      iPos = HtmlString.length();
+   }
 }
 
 // create a html-file as string with default optimization
@@ -83,7 +138,7 @@ void QSgml::ExportString(QSgmlTag* pTag, QString *HtmlString,char Optimze,int Ta
    QString sSpc;
    QString sTab="";
    QString sWrap="";
-   QHash<QString,QString>::iterator i;
+   QHash<QString,QString>::const_iterator i;
 
    // set new-line and tab
    if( Optimze>0 )
@@ -123,29 +178,26 @@ void QSgml::ExportString(QSgmlTag* pTag, QString *HtmlString,char Optimze,int Ta
             break;
          case QSgmlTag::eStandalone:
             sAtr="";
-            for( i=pTag->Attributes.begin() ; i!=pTag->Attributes.end() ; ++i )
+            for( i=pTag->getAttributes().begin() ; i!=pTag->getAttributes().end() ; ++i )
             {
-               QString sKey = i.key();
-               sAtr += " "+sKey+"=\""+pTag->Attributes.value(sKey)+ "\"";
+               sAtr += " "+i.key()+"=\""+i.value()+ "\"";
             }
             HtmlString->append(sSpc+"<"+pTag->Name+sAtr+"/>");
             break;
          case QSgmlTag::eStartTag:
             sAtr="";
-            for( i=pTag->Attributes.begin() ; i != pTag->Attributes.end() ; ++i )
+            for( i=pTag->getAttributes().begin() ; i!=pTag->getAttributes().end() ; ++i )
             {
-               QString sKey = i.key();
-               sAtr += " "+sKey+"=\""+pTag->Attributes.value(sKey)+ "\"";
+               sAtr += " "+i.key()+"=\""+i.value()+ "\"";
             }
             HtmlString->append(sSpc+"<"+pTag->Name+sAtr+">");
             StartTags.append(pTag);
             break;
          case QSgmlTag::eStartEmpty:
             sAtr="";
-            for( i=pTag->Attributes.begin() ; i != pTag->Attributes.end() ; ++i )
+            for( i=pTag->getAttributes().begin() ; i!=pTag->getAttributes().end() ; ++i )
             {
-               QString sKey = i.key();
-               sAtr += " "+sKey+"=\""+pTag->Attributes.value(sKey)+ "\"";
+               sAtr += " "+i.key()+"=\""+i.value()+ "\"";
             }
             HtmlString->append(sSpc+"<"+pTag->Name+sAtr+"></"+pTag->Name+">");
             break;
@@ -210,33 +262,29 @@ QString QSgml::getText(QSgmlTag *pTag)
 // move all children (with children) to an other parent
 void QSgml::MoveChildren(QSgmlTag *Source, QSgmlTag *Dest)
 {
-    int i;
-   int iCount = Source->Children.count();
-
-   for( i=0 ; i<iCount ; i++ )
+   for( QSgmlTag *pChild : Source->Children )
    {
-      Source->Children[0]->Parent = Dest;
-      //Source->Children[0]->Level = Dest->Level+1;  // ToDo: Level von allen Kindern auch decrementieren!
-      Dest->resetLevel();
-      Dest->Children.append( Source->Children[0] );
-      Source->Children.removeFirst();
+      pChild->Parent = Dest;
+      pChild->resetLevel();
    }
+
+   Dest->Children.append( Source->Children );
+   Source->Children.clear();
 }
 
 // include a CDATA in to the QSgml-class
-void QSgml::HandleCdata(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
+void QSgml::HandleCdata(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
 {
-   QString sDummy;
-   QRegExp qNoWhitSpace("(\\S)");
    QSgmlTag *pTag;
 
    iStart = iEnd+1;
    iEnd = iPos;
-   sDummy = SgmlString.mid(iStart,iEnd-iStart).trimmed();
-   // set tag
-   if( sDummy.contains(qNoWhitSpace)  )
+
+   // text that is only whitespace doesn't get a tag
+   const QStringRef sText = SgmlString.midRef(iStart,iEnd-iStart).trimmed();
+   if( !sText.isEmpty() )
    {
-      pTag = new QSgmlTag(sDummy,QSgmlTag::eCdata,pLastTag);
+      pTag = tagArena.create(sText.toString(),QSgmlTag::eCdata,pLastTag);
       pTag->StartTagPos = iStart;
       pTag->StartTagLength = iEnd-iStart;
       pTag->EndTagPos = iStart;
@@ -246,9 +294,8 @@ void QSgml::HandleCdata(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &
 }
 
 // include a comment in to the QSgml-class
-void QSgml::HandleComment(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
+void QSgml::HandleComment(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
 {
-   QString sDummy;
    QSgmlTag *pTag;
 
    iPos+=4;
@@ -256,8 +303,7 @@ void QSgml::HandleComment(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int
    FindEndComment(SgmlString,iPos);
    iEnd = iPos;
 
-   sDummy = SgmlString.mid(iStart,iEnd-iStart).trimmed();
-   pTag = new QSgmlTag(sDummy,QSgmlTag::eComment,pLastTag);
+   pTag = tagArena.create(SgmlString.midRef(iStart,iEnd-iStart).trimmed().toString(),QSgmlTag::eComment,pLastTag);
    pTag->StartTagPos = iStart-4;
    pTag->StartTagLength = iEnd-iStart+7;
    pTag->EndTagPos = iStart-4;
@@ -268,17 +314,15 @@ void QSgml::HandleComment(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int
 }
 
 // include a doctype in to the QSgml-class
-void QSgml::HandleDoctype(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
+void QSgml::HandleDoctype(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
 {
-   QString sDummy;
    QSgmlTag *pTag;
 
    iStart = iPos;
    FindEnd(SgmlString,iPos);
    iEnd = iPos;
-   sDummy = SgmlString.mid(iStart+2,iEnd-iStart-2).trimmed();
 
-   pTag = new QSgmlTag(sDummy,QSgmlTag::eDoctype,pLastTag);
+   pTag = tagArena.create(SgmlString.midRef(iStart+2,iEnd-iStart-2).trimmed().toString(),QSgmlTag::eDoctype,pLastTag);
    pTag->StartTagPos = iStart;
    pTag->StartTagLength = iEnd-iStart+1;
    pTag->EndTagPos = iStart;
@@ -288,26 +332,29 @@ void QSgml::HandleDoctype(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int
 }
 
 // include a endtag in to the QSgml-class
-void QSgml::HandleEndTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
+void QSgml::HandleEndTag(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
 {
-   QString sDummy;
-   QSgmlTag *pTag;
    QSgmlTag *pDummyTag;
 
    iStart = iPos;
    FindEnd(SgmlString,iPos);
    iEnd = iPos;
-   sDummy = SgmlString.mid(iStart+1,iEnd-iStart-1).trimmed();
 
-   pTag = new QSgmlTag(sDummy,QSgmlTag::eEndTag,pLastTag);
+   // the name is all that's needed of an end-tag, it's compared in place
+   int iNameStart = iStart+2;
+   while( (iNameStart<iEnd)&&(SgmlString.at(iNameStart).isSpace()) )
+   {  iNameStart++;  }
+   int iNameEnd = iNameStart;
+   while( (iNameEnd<iEnd)&&(!SgmlString.at(iNameEnd).isSpace()) )
+   {  iNameEnd++;  }
+   const QStringRef sName = SgmlString.midRef(iNameStart,iNameEnd-iNameStart);
 
    // find a fitting start-tag
    pDummyTag = pLastTag;
-   while( (pDummyTag->Name!=pTag->Name)&&(pDummyTag->Parent!=nullptr) )
+   while( (pDummyTag->Name.compare(sName,Qt::CaseInsensitive)!=0)&&(pDummyTag->Parent!=nullptr) )
    {
       pDummyTag = pDummyTag->Parent;
    }
-   delete pTag;
 
    if( pDummyTag->Parent!=nullptr )
    {  // start-tag found
@@ -325,6 +372,9 @@ void QSgml::HandleEndTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int
       {  pLastTag->Type = QSgmlTag::eStartEmpty;  }
       pLastTag = pLastTag->Parent;
    }
+   else if( voidElements.contains(sName.toString().toLower()) )
+   {  // e.g. </br>, void elements were never start-tags so there is nothing to close
+   }
    else
    {  // no start-tag -> end
       pLastTag->Children.append( EndTag );
@@ -333,21 +383,18 @@ void QSgml::HandleEndTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int
 }
 
 // include a start-tag in to the QSgml-class
-void QSgml::HandleStartTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
+void QSgml::HandleStartTag(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos)
 {
-   QString sDummy;
    QSgmlTag *pTag;
 
    iStart = iPos;
    FindEnd(SgmlString,iPos);
    iEnd = iPos;
-   sDummy = SgmlString.mid(iStart+1,iEnd-iStart-1).trimmed();
 
    if( SgmlString.at(iEnd-1)=='/' )
    {
       // this is a standalone-tag
-      sDummy = sDummy.left( sDummy.count()-1 );
-      pTag = new QSgmlTag(sDummy,QSgmlTag::eStandalone,pLastTag);
+      pTag = tagArena.create(SgmlString.midRef(iStart+1,iEnd-iStart-2),QSgmlTag::eStandalone,pLastTag);
       pTag->StartTagPos = iStart;
       pTag->StartTagLength = iEnd-iStart+1;
       pTag->EndTagPos = iStart;
@@ -357,13 +404,21 @@ void QSgml::HandleStartTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,in
    else
    {
       // this is a start-tag
-      pTag = new QSgmlTag(sDummy,QSgmlTag::eStartTag,pLastTag);
+      pTag = tagArena.create(SgmlString.midRef(iStart+1,iEnd-iStart-1),QSgmlTag::eStartTag,pLastTag);
       pTag->StartTagPos = iStart;
       pTag->StartTagLength = iEnd-iStart+1;
       pTag->EndTagPos = iStart;
       pTag->EndTagLength = iEnd-iStart+1;
       pLastTag->Children.append( pTag );
-      pLastTag=pTag;
+
+      if( voidElements.contains(pTag->Name) )
+      {
+         pTag->Type = QSgmlTag::eStandalone;
+      }
+      else
+      {
+         pLastTag=pTag;
+      }
    }
 }
 
@@ -407,7 +462,7 @@ void QSgml::getElementsByName(QString Name,QString AtrName,QString AtrValue,QLis
    Elements->clear();
    while( Tag->Type!=QSgmlTag::eVirtualEndTag )
    {
-      if( (Tag->Name==Name)&&(Tag->hasAttribute(AtrName)==true)&&(Tag->Attributes.value(AtrName)==AtrValue) )
+      if( (Tag->Name==Name)&&(Tag->hasAttribute(AtrName)==true)&&(Tag->getArgValue(AtrName)==AtrValue) )
       {
          Elements->append(Tag);
       }
@@ -423,7 +478,7 @@ void QSgml::getElementsByName(QString Name,QString AtrName, const QRegExp& atrEx
    while( Tag->Type!=QSgmlTag::eVirtualEndTag )
    {
       if((Tag->Name==Name) && (Tag->hasAttribute(AtrName) ==true ) &&
-		  (atrExp.indexIn(Tag->Attributes.value(AtrName)) != -1))
+		  (atrExp.indexIn(Tag->getArgValue(AtrName)) != -1))
       {
          Elements->append(Tag);
       }
@@ -467,7 +522,7 @@ void QSgml::getElementsByAtribute(QString AtrName,QList<QSgmlTag*> *Elements)
     Elements->clear();
     while( Tag->Type!=QSgmlTag::eVirtualEndTag )
    {
-      if( Tag->Attributes.find(AtrName)!=Tag->Attributes.end() )
+      if( Tag->hasAttribute(AtrName) )
       {
          Elements->append( Tag );
       }
@@ -483,9 +538,9 @@ void QSgml::getElementsByAtribute(QString AtrName,QString AtrValue,QList<QSgmlTa
    Elements->clear();
    while( Tag->Type!=QSgmlTag::eVirtualEndTag )
    {
-      if( Tag->Attributes.find(AtrName)!=Tag->Attributes.end() )
+      if( Tag->hasAttribute(AtrName) )
       {
-         if( Tag->Attributes[AtrName]==AtrValue )
+         if( Tag->getArgValue(AtrName)==AtrValue )
          {
             Elements->append( Tag );
          }
@@ -501,11 +556,10 @@ bool QSgml::load(QString sFileName)
    bool qExists=fileText.exists();
 
    // delete old elements
-   delete DocTag;
-   //delete EndTag;
+   tagArena.clear();
    // create new doc-tag
-   DocTag = new QSgmlTag("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
-   EndTag = new QSgmlTag("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
+   DocTag = tagArena.create("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
+   EndTag = tagArena.create("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
    // set EndTag as only Child of DocTag
    DocTag->Children.append(EndTag);
 
@@ -527,11 +581,10 @@ bool QSgml::load(QString sFileName)
 bool QSgml::parse(const QString& html)
 {
 	// delete old elements
-	delete DocTag;
-	//delete EndTag;
+	tagArena.clear();
 	// create new doc-tag
-	DocTag = new QSgmlTag("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
-	EndTag = new QSgmlTag("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
+	DocTag = tagArena.create("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
+	EndTag = tagArena.create("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
 	// set EndTag as only Child of DocTag
 	DocTag->Children.append(EndTag);
 
@@ -559,12 +612,276 @@ QString QSgml::getOuterHtml(QSgmlTag* tag)
 	return sSgmlString.mid(iStart, iEnd - iStart);
 }
 
+QList<QSgmlTag*> QSgml::select(const QString& Selector)
+{
+   QList<QSgmlTag*> retval;
+   Select(nullptr,Selector,false,&retval);
+   return retval;
+}
+
+QList<QSgmlTag*> QSgml::select(QSgmlTag* Scope,const QString& Selector)
+{
+   QList<QSgmlTag*> retval;
+   Select(Scope,Selector,false,&retval);
+   return retval;
+}
+
+QSgmlTag* QSgml::selectFirst(const QString& Selector)
+{
+   QList<QSgmlTag*> retval;
+   Select(nullptr,Selector,true,&retval);
+   return retval.isEmpty() ? nullptr : retval.first();
+}
+
+QSgmlTag* QSgml::selectFirst(QSgmlTag* Scope,const QString& Selector)
+{
+   QList<QSgmlTag*> retval;
+   Select(Scope,Selector,true,&retval);
+   return retval.isEmpty() ? nullptr : retval.first();
+}
+
+void QSgml::Select(QSgmlTag *Scope,const QString &Selector,bool qFirstOnly,QList<QSgmlTag*> *Elements)
+{
+   Elements->clear();
+
+   const QSgmlSelector Parsed = ParseSelector(Selector);
+   if( Parsed.isEmpty() )
+   {
+      return;
+   }
+
+   if( !selectorIndex.Built )
+   {
+      BuildSelectorIndex();
+   }
+
+   // only the elements the last simple selector can match are looked at, the
+   // rest of the selector is checked against their ancestors
+   const SimpleSelector &Last = Parsed.last();
+   const QSgmlTagVector &Tags = Candidates(Last);
+   auto it = Tags.cbegin();
+   auto itEnd = Tags.cend();
+
+   if( Scope!=nullptr )
+   {
+      // the descendants of Scope are the tags that come after it up to and
+      // including its last descendant
+      const auto byOrder = [](const QSgmlTag *pTag,int iOrder) { return pTag->Order<iOrder; };
+      it = std::lower_bound(it,itEnd,Scope->Order+1,byOrder);
+      itEnd = std::lower_bound(it,itEnd,Scope->LastOrder+1,byOrder);
+   }
+
+   for( ;it!=itEnd;++it )
+   {
+      if( Matches(*it,Last)&&MatchesAncestors(*it,Parsed,Parsed.size()-2,Scope) )
+      {
+         Elements->append(*it);
+         if( qFirstOnly )
+         {
+            break;
+         }
+      }
+   }
+}
+
+// number the tags in document order and index the elements
+void QSgml::BuildSelectorIndex(void)
+{
+   selectorIndex = SelectorIndex();
+
+   // the tree is walked with an explicit stack since documents can nest
+   // deeper than the call stack likes
+   QVector<QPair<QSgmlTag*,int>> Stack;
+   int iOrder = 0;
+
+   DocTag->Order = iOrder++;
+   Stack.append(qMakePair(DocTag,0));
+   while( !Stack.isEmpty() )
+   {
+      QSgmlTag *pTag = Stack.last().first;
+      const int iChild = Stack.last().second;
+
+      if( iChild==pTag->Children.size() )
+      {
+         pTag->LastOrder = iOrder-1;
+         Stack.removeLast();
+         continue;
+      }
+
+      Stack.last().second++;
+
+      QSgmlTag *pChild = pTag->Children.at(iChild);
+      pChild->Order = iOrder++;
+      Stack.append(qMakePair(pChild,0));
+
+      if( !isElement(pChild) )
+      {
+         continue;
+      }
+
+      selectorIndex.Elements.append(pChild);
+      selectorIndex.ByName[pChild->Name].append(pChild);
+
+      const QString sId = pChild->getArgValue("id");
+      if( !sId.isEmpty() )
+      {
+         selectorIndex.ById[sId].append(pChild);
+      }
+
+      for( const QString &sClass : pChild->getArgValue("class").simplified().split(' ',QString::SkipEmptyParts) )
+      {
+         QSgmlTagVector &Tags = selectorIndex.ByClass[sClass];
+         // a class can be repeated in the attribute
+         if( Tags.isEmpty()||(Tags.last()!=pChild) )
+         {
+            Tags.append(pChild);
+         }
+      }
+   }
+
+   selectorIndex.Built = true;
+}
+
+// the smallest index that holds every element matching Simple
+const QSgml::QSgmlTagVector& QSgml::Candidates(const SimpleSelector &Simple)
+{
+   static const QSgmlTagVector NoTags;
+
+   const QHash<QString,QSgmlTagVector> *pIndex = nullptr;
+   QStringList Keys;
+   if( !Simple.Id.isEmpty() )
+   {
+      pIndex = &selectorIndex.ById;
+      Keys.append(Simple.Id);
+   }
+   else if( !Simple.Classes.isEmpty() )
+   {
+      pIndex = &selectorIndex.ByClass;
+      Keys = Simple.Classes;
+   }
+   else if( !Simple.Name.isEmpty() )
+   {
+      pIndex = &selectorIndex.ByName;
+      Keys.append(Simple.Name);
+   }
+   else
+   {
+      return selectorIndex.Elements;
+   }
+
+   const QSgmlTagVector *pSmallest = nullptr;
+   for( const QString &sKey : Keys )
+   {
+      const auto it = pIndex->constFind(sKey);
+      if( it==pIndex->constEnd() )
+      {
+         return NoTags;
+      }
+      if( (pSmallest==nullptr)||(it->size()<pSmallest->size()) )
+      {
+         pSmallest = &it.value();
+      }
+   }
+
+   return *pSmallest;
+}
+
+// split a selector into its simple selectors, "div.a.b#c" has the name "div",
+// the classes "a" and "b" and the id "c"
+QSgml::QSgmlSelector QSgml::ParseSelector(const QString &Selector)
+{
+   QSgmlSelector Parsed;
+
+   for( const QString &sPart : Selector.simplified().split(' ',QString::SkipEmptyParts) )
+   {
+      SimpleSelector Simple;
+      QChar cKind;
+      int iStart = 0;
+
+      for( int i=0;i<=sPart.length();i++ )
+      {
+         if( (i<sPart.length())&&(sPart.at(i)!='.')&&(sPart.at(i)!='#') )
+         {
+            continue;
+         }
+
+         const QString sWord = sPart.mid(iStart,i-iStart);
+         if( cKind.isNull() )
+         {
+            Simple.Name = (sWord=="*") ? QString() : sWord.toLower();
+         }
+         else if( (cKind=='.')&&!sWord.isEmpty() )
+         {
+            Simple.Classes.append(sWord);
+         }
+         else if( cKind=='#' )
+         {
+            Simple.Id = sWord;
+         }
+
+         cKind = charAt(sPart,i);
+         iStart = i+1;
+      }
+
+      Parsed.append(Simple);
+   }
+
+   return Parsed;
+}
+
+bool QSgml::Matches(QSgmlTag *Tag,const SimpleSelector &Simple)
+{
+   if( !isElement(Tag) )
+   {
+      return(false);
+   }
+   if( !Simple.Name.isEmpty()&&(Tag->Name!=Simple.Name) )
+   {
+      return(false);
+   }
+   if( !Simple.Id.isEmpty()&&(Tag->getArgValue("id")!=Simple.Id) )
+   {
+      return(false);
+   }
+   if( !Simple.Classes.isEmpty() )
+   {
+      const QString sClasses = Tag->getArgValue("class");
+      for( const QString &sClass : Simple.Classes )
+      {
+         if( !hasClass(sClasses,sClass) )
+         {
+            return(false);
+         }
+      }
+   }
+   return(true);
+}
+
+// whether the simple selectors up to iIndex match ancestors of Tag below Scope
+bool QSgml::MatchesAncestors(QSgmlTag *Tag,const QSgmlSelector &Selector,int iIndex,QSgmlTag *Scope)
+{
+   if( iIndex<0 )
+   {
+      return(true);
+   }
+
+   for( QSgmlTag *pAncestor=Tag->Parent;(pAncestor!=nullptr)&&(pAncestor!=Scope);pAncestor=pAncestor->Parent )
+   {
+      if( Matches(pAncestor,Selector.at(iIndex))&&MatchesAncestors(pAncestor,Selector,iIndex-1,Scope) )
+      {
+         return(true);
+      }
+   }
+
+   return(false);
+}
+
 // Constructor
 QSgml::QSgml(void)
 {
    // create DocTag and EndTag
-   DocTag = new QSgmlTag("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
-   EndTag = new QSgmlTag("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
+   DocTag = tagArena.create("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
+   EndTag = tagArena.create("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
    // set EndTag as only Child of DocTag
    DocTag->Children.append(EndTag);
    // Set Path to Default-Path
@@ -579,8 +896,8 @@ QSgml::QSgml(void)
 QSgml::QSgml(const QString SgmlString)
 {
    // create DocTag and EndTag
-   DocTag = new QSgmlTag("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
-   EndTag = new QSgmlTag("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
+   DocTag = tagArena.create("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
+   EndTag = tagArena.create("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
    // set EndTag as only Child of DocTag
    DocTag->Children.append(EndTag);
    // Set Path to Default-Path
@@ -598,8 +915,8 @@ QSgml::QSgml(const QString SgmlString)
 QSgml::QSgml(QFile &SgmlFile)
 {
    // create DocTag and EndTag
-   DocTag = new QSgmlTag("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
-   EndTag = new QSgmlTag("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
+   DocTag = tagArena.create("DocTag",QSgmlTag::eVirtualBeginTag,nullptr);
+   EndTag = tagArena.create("EndTag",QSgmlTag::eVirtualEndTag,DocTag);
    // set EndTag as only Child of DocTag
    DocTag->Children.append(EndTag);
    // Set Path to Path
@@ -621,34 +938,33 @@ QSgml::QSgml(QFile &SgmlFile)
 }
 
 // convert a String to QSgml
-void QSgml::String2Sgml(const QString SgmlString)
+void QSgml::String2Sgml(const QString &NewSgmlString)
 {
    QSgmlTag *LastTag;
-   QSgmlTag *Tag;
-   QString sDummy;
    int iPos = 0;
    int iStart = 0;
    int iEnd = 0;
-   QList<QString>::iterator i;
 
-   sSgmlString=SgmlString;
+   sSgmlString=NewSgmlString;
+
+   // the tags keep references into the string for their attributes, so
+   // the document's own copy is the one that is parsed
+   const QString &SgmlString = sSgmlString;
+
+   // the selector index is built again for the new tags on the next query
+   selectorIndex = SelectorIndex();
 
    DocTag->Children.clear();
 
-   Tag=DocTag;
    LastTag=DocTag;
 
    do
    {
-      // Handle exception-tags
-      for( i=tagExeption.begin() ; i!=tagExeption.end() ; ++i )
+      // Handle exception-tags, their content is skipped up to their end-tag
+      if( tagExeption.contains(LastTag->Name) )
       {
-         QString sName=*i;
-         if( LastTag->Name.toLower()==sName )
-         {  // its an exception-tag
-            iPos = SgmlString.toLower().indexOf("</"+sName,iPos);
-            iPos--;
-         }
+         iPos = SgmlString.indexOf(QLatin1String("</")+LastTag->Name,iPos,Qt::CaseInsensitive);
+         iPos = (iPos==-1) ? SgmlString.length() : iPos-1;
       }
 
       FindStart(SgmlString,iPos);
@@ -666,7 +982,7 @@ void QSgml::String2Sgml(const QString SgmlString)
       }
 
       // this is a comment
-      if( (SgmlString.at(iPos+1)=='!')&&(SgmlString.at(iPos+2)=='-')&&(SgmlString.at(iPos+3)=='-') )
+      if( (charAt(SgmlString,iPos+1)=='!')&&(charAt(SgmlString,iPos+2)=='-')&&(charAt(SgmlString,iPos+3)=='-') )
       {
          HandleComment(SgmlString,LastTag,iStart,iEnd,iPos);
       }
@@ -676,12 +992,12 @@ void QSgml::String2Sgml(const QString SgmlString)
 //         HandleDoctype(SgmlString,LastTag,iStart,iEnd,iPos);
 //      }
       // this is a Doctype
-      else if( SgmlString.at(iPos+1)=='!' )
+      else if( charAt(SgmlString,iPos+1)=='!' )
       {
          HandleDoctype(SgmlString,LastTag,iStart,iEnd,iPos);
       }
       // this is an Endtag
-      else if( SgmlString.at(iPos+1)=='/' )
+      else if( charAt(SgmlString,iPos+1)=='/' )
       {
          HandleEndTag(SgmlString,LastTag,iStart,iEnd,iPos);
       }
@@ -694,8 +1010,8 @@ void QSgml::String2Sgml(const QString SgmlString)
 }
 
 // destructor
+// the tags are destroyed with tagArena
 QSgml::~QSgml(void)
 {
-   delete DocTag;
 }
 
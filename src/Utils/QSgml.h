@@ -27,6 +27,9 @@ under certain conditions.
 #include <QString>
 #include <QRegExp>
 #include <QList>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
 #include <QFile>
 #include <QDir>
 #include "QSgmlTag.h"
@@ -38,6 +41,7 @@ public:
 
    QSgmlTag *DocTag;
    QSgmlTag *EndTag;
+   // the parsed document, the tags' positions and unparsed attributes refer to it
    QString sSgmlString;
    QSgmlStringlist tagExeption;
 
@@ -87,7 +91,7 @@ public:
    void ExportString(QString *HtmlString);
    void ExportString(QString *HtmlString,char Optimze,int Tabsize);
    void ExportString(QSgmlTag* pTag, QString *HtmlString,char Optimze,int Tabsize);
-   void String2Sgml(const QString SgmlString);
+   void String2Sgml(const QString &SgmlString);
 
    void getText(QSgmlTag* pTag, QString* html);
    QString getText(QSgmlTag* pTag);
@@ -95,19 +99,65 @@ public:
    QString getInnerHtml(QSgmlTag* tag);
    QString getOuterHtml(QSgmlTag* tag);
 
+   // find elements with a selector like "div.stats dl.major" or "li#post-12",
+   // a list of simple selectors separated by whitespace where each one has to
+   // match an ancestor of the element matching the next. A simple selector is
+   // an optional tag-name followed by any number of .class and #id parts, a
+   // class matches one of the whitespace separated words of the attribute.
+   // The elements are returned in document order, the overloads with a Scope
+   // only look at the descendants of Scope.
+   // The first query indexes the document by tag-name, class and id so that
+   // a query only looks at the elements its last simple selector can match.
+   // The index is built again after the next parse, tags added to the tree
+   // with addChild in between aren't found.
+   QList<QSgmlTag*> select(const QString& Selector);
+   QList<QSgmlTag*> select(QSgmlTag* Scope,const QString& Selector);
+   QSgmlTag* selectFirst(const QString& Selector);
+   QSgmlTag* selectFirst(QSgmlTag* Scope,const QString& Selector);
+
 protected:
    QDir dirPath;
 
+   // owns every tag of the document, DocTag and EndTag included
+   QSgmlArena tagArena;
+
    void MoveChildren(QSgmlTag *Source, QSgmlTag *Dest);
    void FindStart(const QString &HtmlString,int &iPos);
    void FindEnd(const QString &HtmlString,int &iPos);
    void FindEndComment(const QString &HtmlString,int &iPos);
-   void HandleCdata(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
-   void HandleComment(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+   void HandleCdata(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+   void HandleComment(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+
+   void HandleDoctype(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+   void HandleEndTag(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+   void HandleStartTag(const QString &SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+
+   struct SimpleSelector
+   {
+      QString Name;
+      QString Id;
+      QStringList Classes;
+   };
+   typedef QVector<SimpleSelector>  QSgmlSelector;
+   typedef QVector<QSgmlTag*>       QSgmlTagVector;
 
-   void HandleDoctype(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
-   void HandleEndTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
-   void HandleStartTag(QString SgmlString,QSgmlTag* &pLastTag,int &iStart,int &iEnd,int &iPos);
+   // elements in document order, all of them and by tag-name, class and id
+   struct SelectorIndex
+   {
+      bool Built = false;
+      QSgmlTagVector Elements;
+      QHash<QString,QSgmlTagVector> ByName;
+      QHash<QString,QSgmlTagVector> ByClass;
+      QHash<QString,QSgmlTagVector> ById;
+   };
+   SelectorIndex selectorIndex;
+
+   void BuildSelectorIndex(void);
+   const QSgmlTagVector& Candidates(const SimpleSelector &Simple);
+   void Select(QSgmlTag *Scope,const QString &Selector,bool qFirstOnly,QList<QSgmlTag*> *Elements);
+   static QSgmlSelector ParseSelector(const QString &Selector);
+   static bool Matches(QSgmlTag *Tag,const SimpleSelector &Simple);
+   static bool MatchesAncestors(QSgmlTag *Tag,const QSgmlSelector &Selector,int iIndex,QSgmlTag *Scope);
 };
 
 #endif // QSGML_H
@@ -21,6 +21,7 @@ This is free software, and you are welcome to redistribute it
 under certain conditions.
 ------------------------------------------------------------------------------------------*/ 
 
+#include <algorithm>
 #include <QtCore>
 #include "QSgmlTag.h"
 
@@ -50,91 +51,186 @@ void QSgmlTag::SetType(const QString &InnerTag)
    }
 }
 
-// set the names and attributes of this tag
-void QSgmlTag::SetNameAttributes(const QString &InnerTag)
+// set the name of this tag
+// only the name is copied out of the tag, the rest of it is kept as the span
+// its attributes are parsed from when they are asked for
+void QSgmlTag::SetNameAttributes(const QStringRef &InnerTag)
 {
-   QString AllAtr;
-   QString AtrString;
-   QString NameString;
-   QString AttrName;
-   QString sDummy;
-   QString Atribute;
-   int PosQot;
-   int StartName;
-   int EndName;
-
-   // Prepareation
-   sDummy = InnerTag.trimmed();
+   const int iLength = InnerTag.length();
+   int i = 0;
 
    // --- find name of tag ---
-   EndName = sDummy.indexOf(" ");
-   Name = sDummy.left(EndName).trimmed().toLower();
-   if( (Name.at(0)=='!')||(Name.at(0)=='/') )
+   while( (i<iLength)&&(InnerTag.at(i).isSpace()) )
+   {  i++;  }
+   if( (i<iLength)&&((InnerTag.at(i)=='!')||(InnerTag.at(i)=='/')) )
+   {  i++;  }
+
+   const int iNameStart = i;
+   while( (i<iLength)&&(!InnerTag.at(i).isSpace())&&(InnerTag.at(i)!='/') )
+   {  i++;  }
+   Name = InnerTag.mid(iNameStart,i-iNameStart).toString().toLower();
+
+   // --- keep the attributes ---
+   AttributeSpan = InnerTag.mid(i);
+   Attributes.clear();
+   AttributesParsed = false;
+   ClassIdScanned = false;
+}
+
+// read the attribute at i and move i past it, returns false when there are
+// no more attributes
+bool QSgmlTag::NextAttribute(const QStringRef &Span,int &i,QStringRef &AtrName,QStringRef &AtrValue)
+{
+   const int iLength = Span.length();
+
+   // skip the space in between and any stray '/'
+   while( (i<iLength)&&((Span.at(i).isSpace())||(Span.at(i)=='/')) )
+   {  i++;  }
+   if( i>=iLength )
+   {  return(false);  }
+
+   // the attribute's name
+   const int iAtrStart = i;
+   while( (i<iLength)&&(!Span.at(i).isSpace())&&(Span.at(i)!='=')&&(Span.at(i)!='/') )
+   {  i++;  }
+   AtrName = Span.mid(iAtrStart,i-iAtrStart);
+
+   int j = i;
+   while( (j<iLength)&&(Span.at(j).isSpace()) )
+   {  j++;  }
+
+   // an attribute without '=' has an empty value
+   AtrValue = Span.mid(i,0);
+   if( (j<iLength)&&(Span.at(j)=='=') )
    {
-      Name = Name.mid(1);
+      j++;
+      while( (j<iLength)&&(Span.at(j).isSpace()) )
+      {  j++;  }
+
+      if( (j<iLength)&&((Span.at(j)=='\"')||(Span.at(j)=='\'')) )
+      {  // quoted value, ignore the quotes
+         int iQuote = Span.indexOf(Span.at(j),j+1);
+         if( iQuote==-1 )
+         {  iQuote = iLength;  }
+         AtrValue = Span.mid(j+1,iQuote-j-1);
+         i = qMin(iQuote+1,iLength);
+      }
+      else
+      {  // unquoted value, up to the next space
+         int iValueEnd = j;
+         while( (iValueEnd<iLength)&&(!Span.at(iValueEnd).isSpace()) )
+         {  iValueEnd++;  }
+         AtrValue = Span.mid(j,iValueEnd-j);
+         i = iValueEnd;
+      }
    }
 
-   // --- find attributes ---
-   AllAtr = sDummy.trimmed().mid(EndName).trimmed();
+   return(true);
+}
 
-   // First get the attr-name
-   EndName = AllAtr.indexOf("=");
-   AttrName = AllAtr.left(EndName).trimmed();
-   AllAtr = AllAtr.mid(EndName+1).trimmed();
+// parse all attributes into the attribute hash
+void QSgmlTag::ParseAttributes(void)
+{
+   if( AttributesParsed )
+   {  return;  }
 
-   // if there is a atr-name get atr-value and next atr-name
-   while( EndName!=-1 )
+   QStringRef AtrName;
+   QStringRef AtrValue;
+   int i = 0;
+   while( NextAttribute(AttributeSpan,i,AtrName,AtrValue) )
    {
-      EndName = AllAtr.indexOf("=");
-      PosQot = AllAtr.indexOf("\"");
+      // set attribute hash
+      if( !AtrName.isEmpty() )
+      {
+         Attributes[AtrName.toString().toLower()] = AtrValue.toString();
+      }
+   }
 
-      // Save Name of Attribute
-      NameString = AttrName.toLower();
+   AttributeSpan = QStringRef();
+   AttributesParsed = true;
+}
 
-      if( PosQot<EndName )
-      {  // find end of quote and "=" afterwards
-         int iDummy = AllAtr.indexOf("\"",PosQot+1);
-         EndName = AllAtr.indexOf("=",iDummy+1);
-      }
-      if( EndName==-1 )
-      {  // no "=" -> all attributes
-         AtrString = AllAtr;
-      }
-      else
-      {
-         sDummy = AllAtr.left(EndName);
+// find the value of an attribute in the span without parsing the others, a
+// null reference if the tag doesn't have it
+QStringRef QSgmlTag::FindAttribute(const QString &AtrName) const
+{
+   QStringRef Found;
+   QStringRef Key;
+   QStringRef Value;
+   int i = 0;
+   while( NextAttribute(AttributeSpan,i,Key,Value) )
+   {
+      // the last one wins like it does in the attribute hash
+      if( !Key.isEmpty()&&(Key.compare(AtrName,Qt::CaseInsensitive)==0) )
+      {  Found = Value;  }
+   }
+   return(Found);
+}
 
-         StartName = sDummy.lastIndexOf(QRegExp("[ \r\n\t]"));
-         AtrString = AllAtr.left(StartName);
+// the selectors look at the class and id of nearly every element, both are
+// found in a single pass and kept
+void QSgmlTag::ScanClassId(void)
+{
+   if( ClassIdScanned )
+   {  return;  }
 
-         AttrName = AllAtr.mid(StartName,EndName-StartName).trimmed();
-         AllAtr = AllAtr.mid(EndName+1).trimmed();
-      }
+   ClassValue = QStringRef();
+   IdValue = QStringRef();
 
-      // set attribute hash; ignore " if exist
-      AtrString=AtrString.trimmed();
-      if( (AtrString.at(0)=='\"')||(AtrString.at(AtrString.count()-1)=='\"') )
-      {
-         QString sDummy=AtrString.mid(1,AtrString.count()-2);
-         Attributes[NameString] = sDummy;
-      }
-      else if( (AtrString.at(0)=='\'')||(AtrString.at(AtrString.count()-1)=='\'') )
-      {
-         QString sDummy=AtrString.mid(1,AtrString.count()-2);
-         Attributes[NameString] = sDummy;
-      }
-      else
-      {
-         Attributes[NameString] = AtrString;
-      }
+   QStringRef Key;
+   QStringRef Value;
+   int i = 0;
+   while( NextAttribute(AttributeSpan,i,Key,Value) )
+   {
+      if( Key.compare(QLatin1String("class"),Qt::CaseInsensitive)==0 )
+      {  ClassValue = Value;  }
+      else if( Key.compare(QLatin1String("id"),Qt::CaseInsensitive)==0 )
+      {  IdValue = Value;  }
+   }
+   ClassIdScanned = true;
+}
+
+// the value of an attribute, a null reference if the tag doesn't have it
+QStringRef QSgmlTag::LookupAttribute(const QString &AtrName)
+{
+   if( AttributesParsed )
+   {
+      // a value that was set to a null string still has to count as there
+      static const QString EmptyValue(QLatin1String(""));
+
+      const auto it = Attributes.constFind(AtrName);
+      if( it==Attributes.constEnd() )
+      {  return(QStringRef());  }
+      return it.value().isNull() ? QStringRef(&EmptyValue) : QStringRef(&it.value());
    }
+
+   if( (AtrName==QLatin1String("class"))||(AtrName==QLatin1String("id")) )
+   {
+      ScanClassId();
+      return (AtrName==QLatin1String("class")) ? ClassValue : IdValue;
+   }
+
+   return(FindAttribute(AtrName));
+}
+
+// all attributes of the tag
+const QSgmlTag::QSgmlAtrHash& QSgmlTag::getAttributes(void)
+{
+   ParseAttributes();
+   return(Attributes);
+}
+
+// set the value of an attribute
+void QSgmlTag::setAttribute(QString AtrName,QString AtrValue)
+{
+   ParseAttributes();
+   Attributes[AtrName] = AtrValue;
 }
 
 // check if attribute has the value
 bool QSgmlTag::checkAttribute(QString AtrName,QString AtrValue)
 {
-   QString sValue=Attributes.value(AtrName);
-   if( sValue==AtrValue )
+   if( LookupAttribute(AtrName)==AtrValue )
    {  return true;  }
    else
    {  return false;  }
@@ -254,7 +350,7 @@ QSgmlTag& QSgmlTag::getPreviousElement(void)
 // get the value of an argument
 QString QSgmlTag::getArgValue(QString Key)
 {
-   return( Attributes.value(Key) );
+   return( LookupAttribute(Key).toString() );
 }
 
 void QSgmlTag::getElementsByName(const QString& Name, 
@@ -268,7 +364,7 @@ void QSgmlTag::getElementsByName(const QString& Name,
    while( Tag->Type!=QSgmlTag::eVirtualEndTag )
    {
       if((Tag->Name==Name) && (Tag->hasAttribute(AtrName) ==true ) &&
-		  (atrExp.indexIn(Tag->Attributes.value(AtrName)) != -1))
+		  (atrExp.indexIn(Tag->getArgValue(AtrName)) != -1))
       {
          Elements->append(Tag);
       }
@@ -320,13 +416,14 @@ void QSgmlTag::resetLevel(void)
 // returns true if the tag has an Atribute "AtrName"
 bool QSgmlTag::hasAttribute(QString AtrName)
 {
-   return Attributes.contains(AtrName);
+   return !LookupAttribute(AtrName).isNull();
 }
 
 // add a child of this element
 QSgmlTag* QSgmlTag::addChild(QString InnerTag, TagType eType)
 {
-   QSgmlTag * pnewTag = new QSgmlTag;
+   Q_ASSERT(Arena!=nullptr);
+   QSgmlTag * pnewTag = Arena->create();
    QSgmlTag * tagRet = pnewTag;
 
    // don't add childs to that eDoctype
@@ -356,7 +453,8 @@ QSgmlTag* QSgmlTag::addChild(QString InnerTag, TagType eType)
       case eDoctype:
       case eStartEmpty:
          pnewTag->SetType(InnerTag);
-         pnewTag->SetNameAttributes(InnerTag);
+         pnewTag->SetNameAttributes(QStringRef(&InnerTag));
+         pnewTag->ParseAttributes();
          break;
       case eCdata:
       case eComment:
@@ -392,7 +490,8 @@ QSgmlTag::QSgmlTag(void)
 QSgmlTag::QSgmlTag(const QString &InnerTag)
 {
 	SetType(InnerTag);
-	SetNameAttributes(InnerTag);
+	SetNameAttributes(QStringRef(&InnerTag));
+	ParseAttributes();
 }
 
 // constructor
@@ -409,8 +508,9 @@ QSgmlTag::QSgmlTag(const QString &InnerTag,TagType eType,QSgmlTag *tParent)
 
 	if( (eType!=eDoctype)&&(eType!=eCdata)&&(eType!=eComment) )
 	{
-		SetNameAttributes(InnerTag);
-		Value = "";
+		// InnerTag doesn't outlive the constructor
+		SetNameAttributes(QStringRef(&InnerTag));
+		ParseAttributes();
 	}
 	else
 	{
@@ -418,13 +518,74 @@ QSgmlTag::QSgmlTag(const QString &InnerTag,TagType eType,QSgmlTag *tParent)
 	}
 }
 
+// constructor
+// used by the parser for tags that only have a name and attributes, so
+// the tag doesn't have to be copied out of the document first, InnerTag
+// has to stay valid as long as the tag's attributes haven't been parsed
+QSgmlTag::QSgmlTag(const QStringRef &InnerTag,TagType eType,QSgmlTag *tParent)
+{
+	Type = eType;
+	Parent = tParent;
+
+	if( tParent==nullptr )
+	{  Level = 0;  }
+	else
+	{  Level = tParent->Level+1;  }
+
+	SetNameAttributes(InnerTag);
+}
+
 // destructor
+// the children belong to the document's QSgmlArena, which destroys them
 QSgmlTag::~QSgmlTag(void)
 {
-	for (int i = 0; i < Children.count(); i++)
-	{
-		delete Children[i];
-	}
+}
 
-	Children.clear();
+namespace
+{
+
+// tags in the first block of an arena, blocks double up to the largest size
+const std::size_t MinBlockSize = 256;
+const std::size_t MaxBlockSize = 16384;
+
+} // namespace
+
+void QSgmlArena::addBlock()
+{
+   const std::size_t size = _blocks.empty()
+      ? MinBlockSize
+      : std::min(_blocks.back().size*2,MaxBlockSize);
+
+   _blocks.push_back(Block { std::unique_ptr<Storage[]>(new Storage[size]), size });
+   _used = 0;
+}
+
+void QSgmlArena::clear()
+{
+   for( std::size_t i=0 ; i<_blocks.size() ; i++ )
+   {
+      Block& block = _blocks[i];
+      const std::size_t count = (i==_blocks.size()-1) ? _used : block.size;
+
+      for( std::size_t j=0 ; j<count ; j++ )
+      {
+         reinterpret_cast<QSgmlTag*>(&block.tags[j])->~QSgmlTag();
+      }
+   }
+
+   if( _blocks.size()>1 )
+   {
+      _blocks.erase(_blocks.begin()+1,_blocks.end());
+   }
+   _used = 0;
+}
+
+std::size_t QSgmlArena::size() const
+{
+   std::size_t retval = _used;
+   for( std::size_t i=0 ; i+1<_blocks.size() ; i++ )
+   {
+      retval += _blocks[i].size;
+   }
+   return retval;
 }
@@ -24,7 +24,14 @@ under certain conditions.
 #ifndef QSGMLTAG_CPP
 #define QSGMLTAG_CPP
 
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
 #include <QHash>
+#include <QString>
+
+class QSgmlArena;
 
 class QSgmlTag
 {
@@ -48,10 +55,12 @@ public:
 
    int Level;
 
+   // the arena of the document the tag belongs to, children are created in it
+   QSgmlArena* Arena = nullptr;
+
    QSgmlTag* Parent;
    QSgmlTaglist Children;
 
-   QSgmlAtrHash Attributes;
    QString Name;
    QString Value;
    TagType Type;
@@ -60,9 +69,15 @@ public:
    int EndTagPos;
    int EndTagLength;
 
+   // position of the tag in document order and of its last descendant, set
+   // when the document builds its selector index
+   int Order = -1;
+   int LastOrder = -1;
+
    QSgmlTag(void);
    QSgmlTag(const QString &InnerTag);
    QSgmlTag(const QString &InnerTag,TagType eType,QSgmlTag *tParent);
+   QSgmlTag(const QStringRef &InnerTag,TagType eType,QSgmlTag *tParent);
    ~QSgmlTag(void);
 
    bool checkAttribute(QString AtrName,QString AtrValue);
@@ -97,12 +112,82 @@ public:
 
    QSgmlTag* addChild(QString InnerTag, TagType eType);
 
+   // all attributes of the tag, getArgValue() and hasAttribute() read a
+   // single attribute without parsing the others
+   const QSgmlAtrHash& getAttributes(void);
+   void setAttribute(QString AtrName,QString AtrValue);
+
 private:
+   // the attributes are parsed out of the rest of the tag on first use,
+   // AttributeSpan points into the document's string until then
+   QStringRef AttributeSpan;
+   QSgmlAtrHash Attributes;
+   bool AttributesParsed = false;
+
+   // class and id, scanned for once when the tag hasn't been parsed
+   QStringRef ClassValue;
+   QStringRef IdValue;
+   bool ClassIdScanned = false;
+
    void SetType(const QString &InnerTag);
-   void SetNameAttributes(const QString &InnerTag);
+   void SetNameAttributes(const QStringRef &InnerTag);
+   void ParseAttributes(void);
+   void ScanClassId(void);
+   QStringRef FindAttribute(const QString &AtrName) const;
+   QStringRef LookupAttribute(const QString &AtrName);
+   static bool NextAttribute(const QStringRef &Span,int &i,QStringRef &AtrName,QStringRef &AtrValue);
 };
 
 extern QSgmlTag NoTag;
 
+// Owns the tags of a document. Tags are constructed in blocks that grow as the
+// document does, so a page takes a few dozen allocations for its tags instead
+// of one per tag, and they are destroyed in one pass over the blocks rather
+// than by each tag recursively deleting its children.
+class QSgmlArena
+{
+public:
+   QSgmlArena() = default;
+   ~QSgmlArena() { clear(); }
+
+   QSgmlArena(const QSgmlArena&) = delete;
+   QSgmlArena& operator=(const QSgmlArena&) = delete;
+
+   template<typename... Args>
+   QSgmlTag* create(Args&&... args)
+   {
+      if( _blocks.empty()||(_used==_blocks.back().size) )
+      {
+         addBlock();
+      }
+
+      QSgmlTag* pTag = new (&_blocks.back().tags[_used]) QSgmlTag(std::forward<Args>(args)...);
+      pTag->Arena = this;
+      _used++;
+
+      return pTag;
+   }
+
+   // destroys every tag, the first block is kept for the next document
+   void clear();
+
+   // number of tags currently in the arena
+   std::size_t size() const;
+
+private:
+   using Storage = std::aligned_storage<sizeof(QSgmlTag),alignof(QSgmlTag)>::type;
+
+   struct Block
+   {
+      std::unique_ptr<Storage[]>   tags;
+      std::size_t                  size;
+   };
+
+   void addBlock();
+
+   std::vector<Block>   _blocks;
+   std::size_t          _used = 0;     // tags constructed in the last block
+};
+
 #endif // QSGMLTAG_CPP
 
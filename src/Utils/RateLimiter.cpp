@@ -0,0 +1,161 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <cmath>
+#include <random>
+
+#include "OwlUtils.h"
+#include "RateLimiter.h"
+
+#include <Utils/OwlLogger.h>
+
+namespace owl
+{
+
+RateLimiter& RateLimiter::instance()
+{
+    static RateLimiter __limiter;
+    return __limiter;
+}
+
+RateLimiter::RateLimiter()
+    : RateLimiter(Config())
+{
+}
+
+RateLimiter::RateLimiter(const Config& config)
+    : _config(config),
+      _logger(owl::initializeLogger("RateLimiter"))
+{
+}
+
+RateLimiter::Milliseconds RateLimiter::acquire(const QString& host)
+{
+    Lock lock(_mutex);
+
+    auto& state = getState(host);
+    const auto now = Clock::now();
+
+    // refill the bucket for the time that has passed
+    const std::chrono::duration<double> elapsed = now - state.lastRefill;
+    state.tokens = std::min(_config.burst, state.tokens + elapsed.count() * state.rate);
+    state.lastRefill = now;
+
+    // taking the token even when the bucket is empty leaves it negative, which
+    // lines up every caller that is waiting behind the ones already queued
+    state.tokens -= 1.0;
+
+    auto wait = Milliseconds::zero();
+    if (state.tokens < 0)
+    {
+        wait = Milliseconds(static_cast<Milliseconds::rep>(std::ceil(-state.tokens / state.rate * 1000.0)));
+    }
+
+    if (state.blockedUntil > now)
+    {
+        wait = std::max(wait, std::chrono::duration_cast<Milliseconds>(state.blockedUntil - now));
+    }
+
+    return wait;
+}
+
+void RateLimiter::update(const QString& host, long status, const QString& retryAfter)
+{
+    Lock lock(_mutex);
+
+    auto& state = getState(host);
+
+    if (!isThrottled(status))
+    {
+        if (status > 0)
+        {
+            state.failures = 0;
+            state.rate = std::min(_config.maxRate, state.rate + _config.increase);
+        }
+
+        return;
+    }
+
+    state.failures++;
+    state.rate = std::max(_config.minRate, state.rate / 2.0);
+
+    // any burst allowance is gone as well
+    state.tokens = std::min(state.tokens, 0.0);
+
+    Milliseconds delay = parseRetryAfter(retryAfter, QDateTime::currentDateTimeUtc());
+    if (delay.count() < 0)
+    {
+        static thread_local std::mt19937 generator { std::random_device{}() };
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+        delay = backoffDelay(state.failures, _config.backoffBase, _config.backoffMax, distribution(generator));
+    }
+
+    // a server asking for hours (or a date far off) would otherwise stall
+    // every request to the host, including the user's
+    delay = std::min(delay, _config.backoffMax);
+
+    state.blockedUntil = std::max(state.blockedUntil, Clock::now() + delay);
+
+    _logger->info("Host '{}' is throttling requests (HTTP {}), backing off for {} ms, rate is now {:.2f}/s",
+        host.toStdString(), status, delay.count(), state.rate);
+}
+
+double RateLimiter::getRate(const QString& host) const
+{
+    Lock lock(_mutex);
+
+    auto it = _hosts.find(host.toLower());
+    return it != _hosts.end() ? it->second.rate : _config.initialRate;
+}
+
+RateLimiter::Milliseconds RateLimiter::parseRetryAfter(const QString& value, const QDateTime& now)
+{
+    const QString trimmed = value.trimmed();
+    if (trimmed.isEmpty())
+    {
+        return Milliseconds(-1);
+    }
+
+    bool ok = false;
+    const qint64 seconds = trimmed.toLongLong(&ok);
+    if (ok)
+    {
+        return seconds >= 0 ? Milliseconds(seconds * 1000) : Milliseconds(-1);
+    }
+
+    const QDateTime date = parseHttpDate(trimmed);
+    if (date.isValid())
+    {
+        return Milliseconds(std::max<qint64>(now.msecsTo(date), 0));
+    }
+
+    return Milliseconds(-1);
+}
+
+RateLimiter::Milliseconds RateLimiter::backoffDelay(uint attempt, Milliseconds base, Milliseconds max, double jitter)
+{
+    // cap the exponent so the shift can't overflow
+    const uint exponent = std::min<uint>(attempt > 0 ? attempt - 1 : 0, 20);
+    const auto delay = std::min<Milliseconds::rep>(base.count() << exponent, max.count());
+
+    jitter = std::max(0.0, std::min(1.0, jitter));
+    return Milliseconds(static_cast<Milliseconds::rep>(delay * (0.5 + jitter / 2.0)));
+}
+
+RateLimiter::HostState& RateLimiter::getState(const QString& host)
+{
+    auto result = _hosts.emplace(host.toLower(), HostState());
+
+    if (result.second)
+    {
+        auto& state = result.first->second;
+        state.tokens = _config.burst;
+        state.rate = _config.initialRate;
+        state.lastRefill = Clock::now();
+    }
+
+    return result.first->second;
+}
+
+} // namespace
@@ -0,0 +1,93 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <QtCore>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+// Paces requests per host with a token bucket whose rate adapts to how the
+// server responds: every successful response nudges the rate up a little
+// (additive increase) and a 429/503 halves it (multiplicative decrease). A
+// throttled host is also blocked for the time given in its Retry-After
+// header or, without one, for an exponential backoff with jitter. Either
+// way the block never lasts longer than Config::backoffMax.
+class RateLimiter
+{
+    using Mutex     = std::mutex;
+    using Lock      = std::lock_guard<std::mutex>;
+    using Clock     = std::chrono::steady_clock;
+
+public:
+    using Milliseconds = std::chrono::milliseconds;
+
+    struct Config
+    {
+        double          initialRate = 4.0;      // requests per second
+        double          minRate     = 0.2;
+        double          maxRate     = 20.0;
+        double          burst       = 8.0;      // requests that can go out back to back
+        double          increase    = 0.25;     // added to the rate after each success
+        Milliseconds    backoffBase { 1000 };
+        Milliseconds    backoffMax { 60000 };
+    };
+
+    static RateLimiter& instance();
+
+    RateLimiter();
+    explicit RateLimiter(const Config& config);
+    virtual ~RateLimiter() = default;
+
+    // Reserves a slot for the next request to the host and returns how long the
+    // caller has to wait before sending it, zero if it can go right away
+    Milliseconds acquire(const QString& host);
+
+    // Feeds a response back into the host's pacing. retryAfter is the raw
+    // value of the response's Retry-After header, if any
+    void update(const QString& host, long status, const QString& retryAfter = QString());
+
+    // current request rate of the host in requests per second
+    double getRate(const QString& host) const;
+
+    // 429 Too Many Requests and 503 Service Unavailable mean "slow down"
+    static bool isThrottled(long status) { return status == 429 || status == 503; }
+
+    // Parses a Retry-After value which is either a number of seconds or an
+    // HTTP-date, returns a negative duration if it can't be parsed
+    static Milliseconds parseRetryAfter(const QString& value, const QDateTime& now);
+
+    // Exponential backoff for the given attempt (starting at 1), capped at max and
+    // with "equal jitter" applied: jitter is a number in [0,1] that scales the delay
+    // between half and all of its value
+    static Milliseconds backoffDelay(uint attempt, Milliseconds base, Milliseconds max, double jitter);
+
+private:
+    struct HostState
+    {
+        double              tokens = 0;
+        double              rate = 0;
+        Clock::time_point   lastRefill;
+        Clock::time_point   blockedUntil;
+        uint                failures = 0;
+    };
+
+    HostState& getState(const QString& host);
+
+    const Config                        _config;
+
+    mutable Mutex                       _mutex;
+    std::map<QString, HostState>        _hosts;
+
+    std::shared_ptr<spdlog::logger>     _logger;
+};
+
+} // namespace
@@ -0,0 +1,78 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "RateLimiter.h"
+#include "RefreshPolicy.h"
+
+namespace owl
+{
+
+RefreshPolicy::RefreshPolicy()
+    : RefreshPolicy(Config())
+{
+}
+
+RefreshPolicy::RefreshPolicy(const Config& config)
+    : _config(config)
+{
+    _activity.fill(0.0);
+    _interval = clamp(_config.initialInterval);
+}
+
+void RefreshPolicy::setConfig(const Config& config)
+{
+    _config = config;
+    _interval = clamp(_interval);
+}
+
+RefreshPolicy::Seconds RefreshPolicy::update(Outcome outcome, const QDateTime& when, double jitter)
+{
+    if (outcome == Outcome::FAILED)
+    {
+        _errors++;
+
+        const auto delay = RateLimiter::backoffDelay(_errors,
+            std::chrono::duration_cast<RateLimiter::Milliseconds>(_config.errorBase),
+            std::chrono::duration_cast<RateLimiter::Milliseconds>(_config.errorMax),
+            jitter);
+
+        return std::max(Seconds(1), std::chrono::duration_cast<Seconds>(delay));
+    }
+
+    _errors = 0;
+
+    const bool bChanged = outcome == Outcome::CHANGED;
+    const int hour = when.time().hour();
+
+    double& activity = _activity[static_cast<std::size_t>(hour)];
+    activity = activity * (1.0 - _config.activitySmoothing) + (bChanged ? _config.activitySmoothing : 0.0);
+
+    const double factor = bChanged ? _config.tighten : _config.relax;
+    _interval = clamp(Seconds(static_cast<Seconds::rep>(static_cast<double>(_interval.count()) * factor)));
+
+    // look at the hour the next refresh falls in
+    const int nextHour = when.addSecs(_interval.count()).time().hour();
+    const double scale = 1.0 - _config.activityWeight * getActivity(nextHour);
+
+    return clamp(Seconds(static_cast<Seconds::rep>(static_cast<double>(_interval.count()) * scale)));
+}
+
+double RefreshPolicy::getActivity(int hour) const
+{
+    if (hour < 0 || hour >= static_cast<int>(_activity.size()))
+    {
+        return 0.0;
+    }
+
+    return _activity[static_cast<std::size_t>(hour)];
+}
+
+RefreshPolicy::Seconds RefreshPolicy::clamp(Seconds interval) const
+{
+    const Seconds lower = std::max(Seconds(1), _config.minInterval);
+    const Seconds upper = std::max(lower, _config.maxInterval);
+
+    return std::min(upper, std::max(lower, interval));
+}
+
+} // namespace owl
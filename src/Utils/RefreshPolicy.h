@@ -0,0 +1,76 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <QtCore>
+
+namespace owl
+{
+
+// Works out how long to wait before refreshing a board again from what the
+// previous refreshes found. The interval shrinks when a refresh finds new
+// unread content and grows when it doesn't, always staying between the
+// configured bounds. How often each hour of the day turned up something new
+// is remembered too, so a board that is busy in the evening gets polled more
+// often in the evening than at night. Failed refreshes back off
+// exponentially until one succeeds again.
+class RefreshPolicy
+{
+public:
+    using Seconds = std::chrono::seconds;
+
+    struct Config
+    {
+        Seconds     minInterval { 60 };
+        Seconds     maxInterval { 60 * 60 };
+        Seconds     initialInterval { 5 * 60 };
+        double      tighten = 0.5;          // the interval is multiplied by this after a change
+        double      relax = 1.5;            // and by this after a refresh that found nothing
+        double      activityWeight = 0.5;   // how much a busy hour can shorten the interval
+        double      activitySmoothing = 0.2;// weight of the newest refresh in an hour's activity
+        Seconds     errorBase { 60 };
+        Seconds     errorMax { 2 * 60 * 60 };
+    };
+
+    enum class Outcome
+    {
+        CHANGED,        // the unread state of the board changed
+        UNCHANGED,
+        FAILED
+    };
+
+    RefreshPolicy();
+    explicit RefreshPolicy(const Config& config);
+    virtual ~RefreshPolicy() = default;
+
+    const Config& getConfig() const { return _config; }
+
+    // the learned interval and activity are kept, the interval is clamped to the new bounds
+    void setConfig(const Config& config);
+
+    // Records a refresh that finished at `when` and returns how long to wait before
+    // the next one. jitter is a number in [0,1] that spreads out the error backoff,
+    // see RateLimiter::backoffDelay()
+    Seconds update(Outcome outcome, const QDateTime& when, double jitter = 1.0);
+
+    // the interval learned from the refreshes so far, before the time of day is applied
+    Seconds getInterval() const { return _interval; }
+
+    // consecutive failed refreshes
+    uint getErrorCount() const { return _errors; }
+
+    // how likely a refresh during the given hour (0-23) is to find something, from 0 to 1
+    double getActivity(int hour) const;
+
+private:
+    Seconds clamp(Seconds interval) const;
+
+    Config                      _config;
+    Seconds                     _interval;
+    uint                        _errors = 0;
+    std::array<double, 24>      _activity;
+};
+
+} // namespace
@@ -0,0 +1,64 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <memory>
+#include <mutex>
+
+namespace owl
+{
+
+// Holds a value that is read far more often than it changes, like what a
+// parser has discovered about its board, and that is shared between a parser
+// and its clones. Readers get an immutable snapshot from get() without
+// locking and can keep it as long as they like, update() copies the current
+// value, changes the copy and publishes it.
+//
+// Working a value out usually means a request to the board, which shouldn't
+// be done once per clone. Callers check get(), take lockDiscovery() and check
+// again before doing the work, so whoever comes second waits and then finds
+// the result. The lock is re-entrant because discovering one thing can need
+// another (e.g. a login that happens in the middle of a request).
+template<typename T>
+class SharedSnapshot
+{
+public:
+    using Ptr = std::shared_ptr<const T>;
+
+    SharedSnapshot()
+        : _current(std::make_shared<const T>())
+    {
+    }
+
+    Ptr get() const
+    {
+        return std::atomic_load(&_current);
+    }
+
+    // `fn` is called with a copy of the current value and must not block
+    template<typename Fn>
+    Ptr update(Fn&& fn)
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+
+        auto copy = std::make_shared<T>(*get());
+        fn(*copy);
+
+        Ptr retval = std::move(copy);
+        std::atomic_store(&_current, retval);
+
+        return retval;
+    }
+
+    std::unique_lock<std::recursive_mutex> lockDiscovery()
+    {
+        return std::unique_lock<std::recursive_mutex>(_discoveryMutex);
+    }
+
+private:
+    Ptr                     _current;
+    std::mutex              _writeMutex;
+    std::recursive_mutex    _discoveryMutex;
+};
+
+} // namespace
@@ -0,0 +1,77 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace owl
+{
+
+// Coalesces concurrent calls that share the same key. The first caller for a
+// key runs the function, anyone calling with the same key while it is still
+// running waits for and receives that same result (or exception) instead of
+// doing the work a second time. Once the call finishes the key is forgotten,
+// so this never returns stale results.
+template<typename Key, typename Result>
+class SingleFlight
+{
+    using Mutex = std::mutex;
+    using Lock  = std::lock_guard<std::mutex>;
+
+public:
+    template<typename Fn>
+    Result run(const Key& key, Fn&& fn)
+    {
+        std::promise<Result> promise;
+        std::shared_future<Result> future;
+        bool bLeader = false;
+
+        {
+            Lock lock(_mutex);
+
+            auto it = _calls.find(key);
+            if (it != _calls.end())
+            {
+                future = it->second;
+            }
+            else
+            {
+                future = promise.get_future().share();
+                _calls.emplace(key, future);
+                bLeader = true;
+            }
+        }
+
+        if (bLeader)
+        {
+            try
+            {
+                promise.set_value(fn());
+            }
+            catch (...)
+            {
+                promise.set_exception(std::current_exception());
+            }
+
+            Lock lock(_mutex);
+            _calls.erase(key);
+        }
+
+        return future.get();
+    }
+
+    // number of distinct keys currently in flight
+    std::size_t size() const
+    {
+        Lock lock(_mutex);
+        return _calls.size();
+    }
+
+private:
+    mutable Mutex                           _mutex;
+    std::map<Key, std::shared_future<Result>>   _calls;
+};
+
+} // namespace
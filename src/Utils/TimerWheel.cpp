@@ -0,0 +1,67 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "TimerWheel.h"
+
+namespace owl
+{
+
+TimerWheel::TimerWheel(std::size_t slots)
+    : _slots(std::max<std::size_t>(1, slots))
+{
+}
+
+void TimerWheel::schedule(Key key, quint64 ticks)
+{
+    cancel(key);
+
+    ticks = std::max<quint64>(1, ticks);
+
+    const std::size_t slot = (_cursor + ticks) % _slots.size();
+    const quint64 rounds = (ticks - 1) / _slots.size();
+
+    Slot& timers = _slots[slot];
+    timers.push_back(Timer { key, rounds });
+    _timers[key] = std::make_pair(slot, std::prev(timers.end()));
+}
+
+bool TimerWheel::cancel(Key key)
+{
+    auto it = _timers.find(key);
+    if (it == _timers.end())
+    {
+        return false;
+    }
+
+    _slots[it->second.first].erase(it->second.second);
+    _timers.erase(it);
+
+    return true;
+}
+
+std::vector<TimerWheel::Key> TimerWheel::advance()
+{
+    std::vector<Key> due;
+
+    _cursor = (_cursor + 1) % _slots.size();
+
+    Slot& timers = _slots[_cursor];
+    for (auto it = timers.begin(); it != timers.end();)
+    {
+        if (it->rounds == 0)
+        {
+            due.push_back(it->key);
+            _timers.erase(it->key);
+            it = timers.erase(it);
+        }
+        else
+        {
+            it->rounds--;
+            ++it;
+        }
+    }
+
+    return due;
+}
+
+} // namespace owl
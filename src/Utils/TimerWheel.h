@@ -0,0 +1,58 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <QtCore>
+
+namespace owl
+{
+
+// Hashed timing wheel. schedule() files a key in the slot that many ticks
+// ahead of the cursor, along with how many full turns of the wheel it still
+// has to wait, and advance() moves the cursor one slot and returns the keys
+// that became due. Scheduling and cancelling cost the same no matter how
+// many keys are waiting, and a tick only looks at one slot.
+//
+// The wheel doesn't keep time itself, the owner calls advance() once per
+// tick. It is not thread safe.
+class TimerWheel
+{
+public:
+    using Key = quint64;
+
+    explicit TimerWheel(std::size_t slots = 60);
+    virtual ~TimerWheel() = default;
+
+    // the key becomes due after `ticks` calls to advance(), a key that is
+    // already scheduled is moved. Zero is treated as one tick
+    void schedule(Key key, quint64 ticks);
+
+    // returns false if the key wasn't scheduled
+    bool cancel(Key key);
+
+    bool contains(Key key) const { return _timers.find(key) != _timers.end(); }
+    std::size_t size() const { return _timers.size(); }
+
+    // moves the wheel one tick forward and returns what became due, in the
+    // order it was scheduled
+    std::vector<Key> advance();
+
+private:
+    struct Timer
+    {
+        Key         key;
+        quint64     rounds;     // full turns left before it's due
+    };
+
+    using Slot = std::list<Timer>;
+
+    std::vector<Slot>       _slots;
+    std::size_t             _cursor = 0;
+
+    std::unordered_map<Key, std::pair<std::size_t, Slot::iterator>>   _timers;
+};
+
+} // namespace
@@ -0,0 +1,316 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "WebCache.h"
+#include "OwlUtils.h"
+
+#include <Utils/OwlLogger.h>
+
+namespace owl
+{
+
+static const quint32    CACHE_MAGIC     = 0x4f574c43; // "OWLC"
+static const qint32     CACHE_VERSION   = 1;
+
+bool WebCache::Entry::isFresh() const
+{
+    return expires.isValid() && QDateTime::currentDateTimeUtc() < expires;
+}
+
+WebCache& WebCache::instance()
+{
+    static WebCache __cache;
+    return __cache;
+}
+
+WebCache::WebCache()
+    : _logger(owl::initializeLogger("WebCache"))
+{
+}
+
+QString WebCache::getPath() const
+{
+    Lock lock(_mutex);
+    return _path;
+}
+
+void WebCache::setPath(const QString& path)
+{
+    Lock lock(_mutex);
+
+    if (!path.isEmpty())
+    {
+        QDir dir(path);
+        if (!dir.exists() && !dir.mkpath(QStringLiteral(".")))
+        {
+            _logger->warn("Could not create cache folder '{}', caching is disabled", path.toStdString());
+            _path.clear();
+            return;
+        }
+
+        _logger->debug("Caching web responses in '{}'", path.toStdString());
+    }
+
+    _path = path;
+    _size = -1;
+    evict();
+}
+
+qint64 WebCache::getMaxSize() const
+{
+    Lock lock(_mutex);
+    return _maxSize;
+}
+
+void WebCache::setMaxSize(qint64 bytes)
+{
+    Lock lock(_mutex);
+    _maxSize = std::max<qint64>(bytes, 0);
+    evict();
+}
+
+bool WebCache::isEnabled() const
+{
+    Lock lock(_mutex);
+    return !_path.isEmpty();
+}
+
+QString WebCache::makeKey(const QString& method, const QString& url, const QString& payload,
+                          const QString& identity /*= QString()*/)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(method.toUpper().toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(url.toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(payload.toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(identity.toUtf8());
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool WebCache::isStorable(const QString& cacheControl, bool bPrivate)
+{
+    const auto directives = cacheControl.split(',', QString::SkipEmptyParts);
+    for (const auto& item : directives)
+    {
+        const QString directive = item.trimmed().toLower();
+
+        if (directive == QStringLiteral("no-store"))
+        {
+            return false;
+        }
+        else if (directive == QStringLiteral("private") && !bPrivate)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool WebCache::expiresFromHeaders(const QString& cacheControl,
+                                  const QString& expires,
+                                  const QDateTime& now,
+                                  QDateTime& result)
+{
+    // with no freshness information a response can still be stored, it just
+    // has to be revalidated every time it is used
+    result = now;
+    bool bHasMaxAge = false;
+
+    const auto directives = cacheControl.split(',', QString::SkipEmptyParts);
+    for (const auto& item : directives)
+    {
+        const QString directive = item.trimmed().toLower();
+
+        if (directive == QStringLiteral("no-store"))
+        {
+            return false;
+        }
+        else if (directive == QStringLiteral("no-cache"))
+        {
+            result = now;
+            bHasMaxAge = true;
+        }
+        else if (directive.startsWith(QStringLiteral("max-age=")) && !bHasMaxAge)
+        {
+            bool ok = false;
+            const qint64 seconds = directive.mid(8).remove('"').toLongLong(&ok);
+            if (ok)
+            {
+                result = now.addSecs(std::max<qint64>(seconds, 0));
+                bHasMaxAge = true;
+            }
+        }
+    }
+
+    // max-age takes priority over the Expires header
+    if (!bHasMaxAge && !expires.isEmpty())
+    {
+        const QDateTime expiresDate = parseHttpDate(expires);
+
+        // an invalid date (like "0" or "-1") means the response is already expired
+        result = expiresDate.isValid() ? std::max(expiresDate, now) : now;
+    }
+
+    return true;
+}
+
+WebCache::EntryPtr WebCache::find(const QString& key) const
+{
+    Lock lock(_mutex);
+
+    if (_path.isEmpty())
+    {
+        return nullptr;
+    }
+
+    QFile file(filename(key));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return nullptr;
+    }
+
+    QDataStream stream(&file);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    stream >> magic >> version;
+
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION)
+    {
+        return nullptr;
+    }
+
+    QByteArray finalUrl;
+    QByteArray data;
+
+    auto entry = std::make_shared<Entry>();
+    stream >> entry->expires >> entry->etag >> entry->lastModified >> finalUrl >> data;
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        _logger->debug("Discarding corrupt cache entry '{}'", key.toStdString());
+        return nullptr;
+    }
+
+    entry->finalUrl = finalUrl.toStdString();
+    entry->data.assign(data.constData(), static_cast<std::size_t>(data.size()));
+
+    // the modification time doubles as the last use for eviction
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    return entry;
+}
+
+void WebCache::store(const QString& key, const Entry& entry, std::string_view data)
+{
+    Lock lock(_mutex);
+
+    if (_path.isEmpty())
+    {
+        return;
+    }
+
+    const QFileInfo previous(filename(key));
+    const qint64 previousSize = previous.exists() ? previous.size() : 0;
+
+    // write to a temporary file first so that a concurrent reader never
+    // sees a half written entry
+    QSaveFile file(filename(key));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        _logger->warn("Could not write cache entry '{}'", file.fileName().toStdString());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION
+           << entry.expires << entry.etag << entry.lastModified
+           << QByteArray::fromStdString(entry.finalUrl)
+           << QByteArray::fromRawData(data.data(), static_cast<int>(data.size()));
+
+    if (!file.commit())
+    {
+        _logger->warn("Could not write cache entry '{}'", file.fileName().toStdString());
+        return;
+    }
+
+    if (_size >= 0)
+    {
+        _size += QFileInfo(file.fileName()).size() - previousSize;
+    }
+
+    evict();
+}
+
+void WebCache::remove(const QString& key)
+{
+    Lock lock(_mutex);
+
+    if (!_path.isEmpty())
+    {
+        const QFileInfo info(filename(key));
+        if (info.exists() && QFile::remove(info.absoluteFilePath()) && _size >= 0)
+        {
+            _size -= info.size();
+        }
+    }
+}
+
+void WebCache::clear()
+{
+    Lock lock(_mutex);
+
+    if (!_path.isEmpty())
+    {
+        QDir dir(_path);
+        for (const auto& file : dir.entryList({ QStringLiteral("*.cache") }, QDir::Files))
+        {
+            dir.remove(file);
+        }
+
+        _size = 0;
+    }
+}
+
+QString WebCache::filename(const QString& key) const
+{
+    return QDir(_path).absoluteFilePath(key + QStringLiteral(".cache"));
+}
+
+void WebCache::evict()
+{
+    if (_path.isEmpty() || _maxSize <= 0 || (_size >= 0 && _size <= _maxSize))
+    {
+        return;
+    }
+
+    // oldest modification time (least recently used) first
+    const QDir dir(_path);
+    const auto files = dir.entryInfoList({ QStringLiteral("*.cache") }, QDir::Files, QDir::Time | QDir::Reversed);
+
+    _size = 0;
+    for (const auto& info : files)
+    {
+        _size += info.size();
+    }
+
+    for (const auto& info : files)
+    {
+        if (_size <= _maxSize)
+        {
+            break;
+        }
+
+        if (QFile::remove(info.absoluteFilePath()))
+        {
+            _logger->trace("Evicted cache entry '{}'", info.fileName().toStdString());
+            _size -= info.size();
+        }
+    }
+}
+
+} // namespace
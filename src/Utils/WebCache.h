@@ -0,0 +1,99 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <QtCore>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+// On-disk cache of HTTP responses. Entries are stored one per file and are
+// keyed by a hash of the method, url and payload of the request along with
+// the identity (board and user) it was made as. Freshness follows the
+// response's Cache-Control/Expires headers and stale entries are revalidated
+// with the response's ETag/Last-Modified validators. Because the key is
+// scoped to the identity this is a private cache, and when it grows past its
+// maximum size the least recently used entries are evicted first.
+class WebCache
+{
+    using Mutex = std::mutex;
+    using Lock  = std::lock_guard<std::mutex>;
+
+public:
+    struct Entry
+    {
+        QDateTime       expires;        // entry can be served without revalidation until this time
+        QString         etag;
+        QString         lastModified;
+        std::string     finalUrl;
+        std::string     data;
+
+        bool isFresh() const;
+        bool hasValidator() const { return !etag.isEmpty() || !lastModified.isEmpty(); }
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    static WebCache& instance();
+
+    WebCache();
+    virtual ~WebCache() = default;
+
+    // an empty path disables the cache
+    QString getPath() const;
+    void setPath(const QString& path);
+
+    bool isEnabled() const;
+
+    // maximum number of bytes the entries may take up on disk, 0 is unlimited
+    qint64 getMaxSize() const;
+    void setMaxSize(qint64 bytes);
+
+    // the identity keeps one account's pages from being served to another
+    static QString makeKey(const QString& method, const QString& url, const QString& payload,
+                           const QString& identity = QString());
+
+    // Whether a response may be stored at all. Only no-store responses are
+    // refused, private ones are stored when the key is scoped to an identity
+    static bool isStorable(const QString& cacheControl, bool bPrivate);
+
+    // Calculates when a response expires from its Cache-Control and Expires
+    // headers. Returns false if the response must not be stored at all
+    static bool expiresFromHeaders(const QString& cacheControl,
+                                   const QString& expires,
+                                   const QDateTime& now,
+                                   QDateTime& result);
+
+    // returns nullptr if there is no entry or if it cannot be read
+    EntryPtr find(const QString& key) const;
+
+    void store(const QString& key, const Entry& entry) { store(key, entry, entry.data); }
+
+    // stores the entry with the given body, Entry::data is ignored
+    void store(const QString& key, const Entry& entry, std::string_view data);
+    void remove(const QString& key);
+    void clear();
+
+private:
+    QString filename(const QString& key) const;
+
+    // removes the least recently used entries until the cache fits in
+    // _maxSize, must be called with _mutex held
+    void evict();
+
+    mutable Mutex                       _mutex;
+    QString                             _path;
+    qint64                              _maxSize = 256 * 1024 * 1024;
+    qint64                              _size = -1;     // bytes on disk, -1 until counted
+
+    std::shared_ptr<spdlog::logger>     _logger;
+};
+
+} // namespace
@@ -1,26 +1,272 @@
 // Owl - www.owlclient.com
 // Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
 
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <set>
+
+#include <QtConcurrent>
+
 #include <tidy.h>
 #include <tidybuffio.h>
+#include "CancellationToken.h"
+#include "RateLimiter.h"
+#include "WebCache.h"
 #include "WebClient.h"
+#include "WebRequestEngine.h"
 
 #include <Utils/OwlLogger.h>
 
 namespace owl
 {
 
-static size_t CURLwriter(char *data, size_t size, size_t nmemb, std::string *writerData)
+// how many times a request that was throttled (429/503) is retried
+const uint MAX_THROTTLE_RETRIES = 3;
+
+// upper bound on how much we'll reserve up front based on a server's Content-Length
+const std::size_t MAX_RESERVE_SIZE = 16 * 1024 * 1024;
+
+// a request that can't connect within this many seconds, or that receives
+// nothing for LOW_SPEED_TIME seconds, fails even if it has no deadline
+const long CONNECT_TIMEOUT = 30;
+const long LOW_SPEED_TIME = 60;
+
+// where curl writes the body and headers of a response, the body ends up
+// being moved into the Reply so it is never copied
+struct ResponseSink
+{
+    std::string             body;
+    WebClient::HeaderMap    headers;
+};
+
+static size_t CURLwriter(char *data, size_t size, size_t nmemb, ResponseSink *sink)
 {
-    if (writerData == nullptr)
+    if (sink == nullptr)
     {
         return 0;
     }
 
-    writerData->append(data, size*nmemb);
+    sink->body.append(data, size*nmemb);
     return size * nmemb;
 }
 
+static size_t CURLheader(char *data, size_t size, size_t nitems, ResponseSink *sink)
+{
+    const size_t length = size * nitems;
+
+    if (sink != nullptr)
+    {
+        const QString line = QString::fromLatin1(data, static_cast<int>(length)).trimmed();
+
+        if (line.startsWith(QStringLiteral("HTTP/")))
+        {
+            // every response in a redirect chain starts with a status line,
+            // we only care about the headers of the last one
+            sink->headers.clear();
+        }
+        else if (line.isEmpty())
+        {
+            // end of the headers, size the body buffer so it doesn't have to
+            // keep reallocating as the data comes in
+            bool ok = false;
+            std::size_t contentLength = sink->headers.getText("content-length", false).toULongLong(&ok);
+            if (ok && contentLength > 0)
+            {
+                // Content-Length is the encoded size, a compressed page will
+                // still grow past this but it saves the first several reallocations
+                if (sink->headers.has("content-encoding"))
+                {
+                    contentLength *= 4;
+                }
+
+                sink->body.reserve(std::min(contentLength, MAX_RESERVE_SIZE));
+            }
+        }
+        else if (const int colon = line.indexOf(':'); colon > 0)
+        {
+            const QString key = line.left(colon).trimmed().toLower();
+            sink->headers.setOrAdd(key, line.mid(colon + 1).trimmed());
+        }
+    }
+
+    return length;
+}
+
+// Process-wide share handle so that every WebClient, and every clone of one,
+// reuses DNS lookups and TLS sessions for the same host. Cookies are
+// deliberately NOT shared since each board has its own session. Neither is the
+// connection cache: libcurl doesn't support sharing it between handles that
+// run transfers on different threads at the same time, so connections are
+// reused by each client's own handle and by the WebRequestEngine's multi handle.
+class CurlShare
+{
+public:
+    static CURLSH* handle()
+    {
+        static CurlShare __share;
+        return __share._share;
+    }
+
+private:
+    CurlShare()
+    {
+        _share = curl_share_init();
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, &CurlShare::lock);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, &CurlShare::unlock);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    ~CurlShare()
+    {
+        curl_share_cleanup(_share);
+    }
+
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr)
+    {
+        static_cast<CurlShare*>(userptr)->_mutexes.at(data).lock();
+    }
+
+    static void unlock(CURL*, curl_lock_data data, void* userptr)
+    {
+        static_cast<CurlShare*>(userptr)->_mutexes.at(data).unlock();
+    }
+
+    CURLSH*                                     _share = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> _mutexes;
+};
+
+// every cookie known by the handle, one Netscape cookie file line each
+static std::vector<std::string> cookieLines(CURL* curl)
+{
+    std::vector<std::string> retval;
+
+    struct curl_slist *cookies = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_COOKIELIST, &cookies);
+
+    for (struct curl_slist* nc = cookies; nc != nullptr; nc = nc->next)
+    {
+        retval.emplace_back(nc->data);
+    }
+
+    curl_slist_free_all(cookies);
+    return retval;
+}
+
+// cookies with the same name/domain/path are replaced
+static void setCookies(CURL* dest, const std::vector<std::string>& lines)
+{
+    for (const auto& line : lines)
+    {
+        curl_easy_setopt(dest, CURLOPT_COOKIELIST, line.c_str());
+    }
+}
+
+// copies every cookie known by the source handle into the destination handle
+static void copyCookies(CURL* source, CURL* dest)
+{
+    setCookies(dest, cookieLines(source));
+}
+
+// called by curl while a transfer is running, returning non-zero aborts
+// it with CURLE_ABORTED_BY_CALLBACK
+static int CURLxferinfo(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    const auto token = static_cast<const CancellationToken*>(clientp);
+    return token != nullptr && token->isCancelled() ? 1 : 0;
+}
+
+// hooks the token up to the handle, or unhooks whatever was there when token is null
+static void bindCancellation(CURL* curl, const CancellationToken* token)
+{
+    if (token != nullptr)
+    {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CURLxferinfo);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, token);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+        if (token->hasDeadline())
+        {
+            // curl treats zero as "no timeout"
+            const auto remaining = std::max<long long>(token->remaining().count(), 1);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(std::min<long long>(remaining, LONG_MAX)));
+        }
+        else
+        {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 0L);
+        }
+    }
+    else
+    {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, nullptr);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 0L);
+    }
+}
+
+static QString effectiveUrl(CURL* curl)
+{
+    char *finalUrl = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &finalUrl);
+    return QString::fromLatin1(finalUrl);
+}
+
+// state for a single request, shared by the blocking and the async paths
+struct WebClient::Transfer
+{
+    CURL*                   handle = nullptr;
+    curl_slist*             headers = nullptr;
+    ResponseSink            response;
+    char                    errbuf[CURL_ERROR_SIZE] = { 0 };
+
+    QString                 url;
+    QString                 host;           // the key used by the RateLimiter
+    Method                  method = Method::GET;
+    CancellationTokenPtr    token;          // the caller's, may be null
+    uint                    attempts = 0;   // retries after being throttled
+    uint                    options = Options::DEFAULT;
+    bool                    throwOnFail = true;
+    bool                    tidy = true;    // whether 200 responses get run through tidyHTML()
+    QElapsedTimer           timer;
+    qint64                  networkTime = 0;
+    std::size_t             wireSize = 0;   // body bytes as received, before content decoding
+
+    QString                 cacheKey;       // empty if the response should not be cached
+    bool                    privateCache = false;   // the key is scoped to an identity
+    WebCache::EntryPtr      cached;         // stale cache entry that is being revalidated
+};
+
+// a request running on the WebRequestEngine, each one owns a handle
+// duplicated from the client's handle
+struct WebClient::AsyncRequest : public WebClient::Transfer
+{
+    std::promise<ReplyPtr>      promise;
+    std::vector<std::string>    sentCookies;    // the client's cookies when the request was submitted
+};
+
+static void bindTransfer(CURL* curl, ResponseSink* sink, char* errbuf)
+{
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, sink);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, sink);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
+}
+
+// Tidying is CPU bound and can take longer than the request itself on large
+// pages, so async replies are tidied here instead of on the event loop thread
+static QThreadPool* tidyPool()
+{
+    static QThreadPool* __pool = []()
+    {
+        auto pool = new QThreadPool();
+        pool->setMaxThreadCount(std::max(QThread::idealThreadCount(), 2));
+        return pool;
+    }();
+
+    return __pool;
+}
+
 //int trace(CURL *handle, curl_infotype type, unsigned char *data, size_t size, void *userp)
 //{
 //    std::cout << data << std::endl;
@@ -55,6 +301,12 @@ WebClient::WebClient()
 
 WebClient::~WebClient()
 {
+    {
+        // in-flight async requests call back into this object
+        UniqueLock lock(_asyncMutex);
+        _asyncCondition.wait(lock, [this]() { return _asyncCount == 0; });
+    }
+
     curl_easy_cleanup(_curl);
 }
 
@@ -123,16 +375,61 @@ void WebClient::printCookies()
 void WebClient::deleteAllCookies()
 {
     Lock lock(_curlMutex);
+
+    {
+        Lock stateLock(_stateMutex);
+        _pendingCookies.clear();
+    }
+
     curl_easy_setopt(_curl, CURLOPT_COOKIELIST, "ALL");
 }
 
+QByteArray WebClient::exportCookies() const
+{
+    Lock lock(_curlMutex);
+    applyPendingCookies();
+
+    QByteArray retval;
+    struct curl_slist* cookies = nullptr;
+    curl_easy_getinfo(_curl, CURLINFO_COOKIELIST, &cookies);
+
+    for (struct curl_slist* nc = cookies; nc != nullptr; nc = nc->next)
+    {
+        retval.append(nc->data);
+        retval.append('\n');
+    }
+
+    curl_slist_free_all(cookies);
+    return retval;
+}
+
+void WebClient::importCookies(const QByteArray& cookies)
+{
+    Lock lock(_curlMutex);
+    applyPendingCookies();
+
+    for (const QByteArray& line : cookies.split('\n'))
+    {
+        if (!line.trimmed().isEmpty())
+        {
+            curl_easy_setopt(_curl, CURLOPT_COOKIELIST, line.constData());
+        }
+    }
+}
+
 void WebClient::setCurlHandle(CURL *curl)
 {
     Lock lock(_curlMutex);
 
-    // release the existing instance
+    // release the existing instance, along with the cookies that were
+    // waiting to be merged into it
     curl_easy_cleanup(_curl);
 
+    {
+        Lock stateLock(_stateMutex);
+        _pendingCookies.clear();
+    }
+
     // make a duplicate of the handle
     _curl = curl_easy_duphandle(curl);
 
@@ -140,24 +437,33 @@ void WebClient::setCurlHandle(CURL *curl)
     initCurlSettings();
 
     // copy the cookies
-    struct curl_slist *cookies;
-    curl_easy_getinfo(curl, CURLINFO_COOKIELIST, &cookies);
-    struct curl_slist* nc = cookies;
-
-    while (nc)
-    {
-        curl_easy_setopt(_curl, CURLOPT_COOKIELIST, nc->data);
-        nc = nc->next;
-    }
-
-    curl_slist_free_all(cookies);
+    copyCookies(curl, _curl);
 }
 
 const QString WebClient::getLastRequestUrl() const
 {
+    Lock lock(_stateMutex);
     return _lastUrl;
 }
 
+void WebClient::setLastRequestUrl(const QString& url)
+{
+    Lock lock(_stateMutex);
+    _lastUrl = url;
+}
+
+void WebClient::applyPendingCookies() const
+{
+    std::vector<std::string> cookies;
+
+    {
+        Lock lock(_stateMutex);
+        cookies.swap(_pendingCookies);
+    }
+
+    setCookies(_curl, cookies);
+}
+
 void WebClient::setConfig(const WebClientConfig &config)
 {
     Lock lock(_curlMutex);
@@ -165,6 +471,10 @@ void WebClient::setConfig(const WebClientConfig &config)
     _useEncryption = config.useEncryption;
     _strEncryptionSeed = config.encryptSeed;
     _strEncyrptionKey = config.encryptKey;
+    _useTidy = config.useTidy;
+    _useHttp2 = config.useHttp2 && isHttp2Available();
+    _cacheIdentity = config.cacheIdentity;
+    applyHttpVersion();
 
     // use the actual call instead of setUserAgent() to avoid deadlock and having to
     // use a recursive mutex
@@ -185,7 +495,28 @@ QString WebClient::DownloadString(const QString &url, uint options /*=Options::D
 
 WebClient::ReplyPtr WebClient::GetUrl(const QString &url, uint options)
 {
-    return doRequest(url, QString(), Method::GET, options);
+    const QString key = QString("%1 %2").arg(options).arg(url);
+
+    try
+    {
+        return _getFlights.run(key, [&]()
+        {
+            return doRequest(url, QString(), Method::GET, options);
+        });
+    }
+    catch (const CancelledException&)
+    {
+        // a coalesced request gets the leader's result, if it was the leader
+        // that got cancelled and we weren't then make the request ourselves
+        const auto token = CancellationToken::current();
+        if (token && token->isCancelled())
+        {
+            throw;
+        }
+
+        _logger->trace("Shared request for '{}' was cancelled, running it again", url.toStdString());
+        return doRequest(url, QString(), Method::GET, options);
+    }
 }
 
 QString WebClient::UploadString(const QString& url, const QString &payload, uint options)
@@ -205,19 +536,459 @@ WebClient::ReplyPtr WebClient::PostUrl(const QString& url, const QString &payloa
     return doRequest(url, payload, Method::POST, options);
 }
 
+std::future<WebClient::ReplyPtr> WebClient::GetUrlAsync(const QString& url, uint options)
+{
+    return doRequestAsync(url, QString(), Method::GET, options);
+}
+
+std::future<WebClient::ReplyPtr> WebClient::PostUrlAsync(const QString& url, const QString& payload, uint options)
+{
+    return doRequestAsync(url, payload, Method::POST, options);
+}
+
 WebClient::ReplyPtr WebClient::doRequest(const QString& url,
                                    const QString& payload /*= QString()*/,
                                    Method method /*= Method::GET*/,
                                    uint options /*= Options::DEFAULT*/)
 {
-    Lock lock(_curlMutex);
+    Transfer transfer;
+    transfer.url = url;
+    transfer.host = QUrl(url).host();
+    transfer.method = method;
+    transfer.options = options;
+    transfer.throwOnFail = getThrowOnFail();
+    transfer.token = CancellationToken::current();
+    transfer.timer.start();
+
+    ReplyPtr reply;
+    bool bCached = false;
+
+    {
+        Lock lock(_curlMutex);
+        transfer.tidy = _useTidy;
+
+        reply = checkCache(transfer, method, payload);
+        if (reply)
+        {
+            setLastRequestUrl(QString::fromStdString(reply->finalUrl()));
+            bCached = true;
+        }
+    }
+
+    while (!bCached)
+    {
+        // wait for our turn with the host without holding the lock
+        const auto delay = RateLimiter::instance().acquire(transfer.host);
+        if (delay.count() > 0)
+        {
+            _logger->trace("Delaying request to '{}' by {} ms", transfer.host.toStdString(), delay.count());
+            if (transfer.token)
+            {
+                // cancelling the operation (or its deadline) cuts the wait short
+                transfer.token->waitFor(delay);
+            }
+            else
+            {
+                std::this_thread::sleep_for(delay);
+            }
+        }
+
+        if (transfer.token)
+        {
+            transfer.token->throwIfCancelled();
+        }
+
+        Lock lock(_curlMutex);
+        transfer.handle = _curl;
+
+        applyPendingCookies();
+        prepareRequest(_curl, url, payload, method);
+
+        transfer.headers = setHeaders(_curl, transfer.cached.get());
+        bindTransfer(_curl, &transfer.response, transfer.errbuf);
+        bindCancellation(_curl, transfer.token.get());
+
+        CURLcode result = curl_easy_perform(_curl);
+
+        bindCancellation(_curl, nullptr);
+        bindTransfer(_curl, nullptr, nullptr);
+        unsetHeaders(transfer.headers);
+        transfer.headers = nullptr;
+
+        checkCancelled(transfer, result);
+
+        if (retryThrottled(transfer, result))
+        {
+            continue;
+        }
+
+        if (result == CURLE_OK)
+        {
+            setLastRequestUrl(effectiveUrl(_curl));
+        }
+
+        reply = processResult(transfer, result);
+        break;
+    }
+
+    // the network lock is released so the next request on this client
+    // can start while this thread is busy tidying
+    tidyReply(reply, transfer);
+    return reply;
+}
+
+std::future<WebClient::ReplyPtr> WebClient::doRequestAsync(const QString& url,
+                                   const QString& payload,
+                                   Method method,
+                                   uint options)
+{
+    auto request = std::make_shared<AsyncRequest>();
+    request->url = url;
+    request->host = QUrl(url).host();
+    request->method = method;
+    request->options = options;
+    request->throwOnFail = getThrowOnFail();
+    request->token = CancellationToken::current();
+    request->timer.start();
+
+    if (request->token)
+    {
+        request->token->throwIfCancelled();
+    }
+
+    auto future = request->promise.get_future();
+
+    ReplyPtr cachedReply;
+
+    {
+        Lock lock(_curlMutex);
+        request->tidy = _useTidy;
+
+        cachedReply = checkCache(*request, method, payload);
+        if (cachedReply)
+        {
+            setLastRequestUrl(QString::fromStdString(cachedReply->finalUrl()));
+        }
+    }
+
+    if (cachedReply)
+    {
+        tidyReply(cachedReply, *request);
+        request->promise.set_value(cachedReply);
+        return future;
+    }
+
+    {
+        Lock lock(_curlMutex);
+
+        // every in-flight request gets its own handle so that the user agent,
+        // send cookies and the rest of our settings carry over to it
+        request->handle = curl_easy_duphandle(_curl);
+        if (!request->handle)
+        {
+            OWL_THROW_EXCEPTION(Exception("Could not duplicate CURL instance"));
+        }
+
+        // remember what was sent so that only the cookies the server sets
+        // are merged back when the request finishes
+        applyPendingCookies();
+        request->sentCookies = cookieLines(_curl);
+        setCookies(request->handle, request->sentCookies);
+
+        prepareRequest(request->handle, url, payload, method);
+        request->headers = setHeaders(request->handle, request->cached.get());
+    }
+
+    // the duplicated handle does not inherit the share handle
+    bindTransfer(request->handle, &request->response, request->errbuf);
+    bindCancellation(request->handle, request->token.get());
+    curl_easy_setopt(request->handle, CURLOPT_SHARE, CurlShare::handle());
+
+    {
+        Lock lock(_asyncMutex);
+        _asyncCount++;
+    }
+
+    try
+    {
+        // rate limited requests wait in the engine rather than blocking the caller
+        const auto delay = RateLimiter::instance().acquire(request->host);
+
+        WebRequestEngine::instance().submit(request->handle,
+            [this, request](CURL*, CURLcode result)
+            {
+                completeAsyncRequest(request, result);
+            },
+            WebRequestEngine::Clock::now() + delay);
+    }
+    catch (...)
+    {
+        unsetHeaders(request->headers);
+        curl_easy_cleanup(request->handle);
+
+        Lock lock(_asyncMutex);
+        _asyncCount--;
+        _asyncCondition.notify_all();
+        throw;
+    }
+
+    return future;
+}
+
+void WebClient::completeAsyncRequest(AsyncRequestPtr request, CURLcode result)
+{
+    const bool bCancelled = request->token && request->token->isCancelled();
+
+    if (!bCancelled && retryThrottled(*request, result))
+    {
+        try
+        {
+            const auto delay = RateLimiter::instance().acquire(request->host);
+
+            // refresh the timeout with whatever is left of the deadline
+            bindCancellation(request->handle, request->token.get());
+
+            WebRequestEngine::instance().submit(request->handle,
+                [this, request](CURL*, CURLcode result)
+                {
+                    completeAsyncRequest(request, result);
+                },
+                WebRequestEngine::Clock::now() + delay);
+
+            return;
+        }
+        catch (...)
+        {
+            // the engine is shutting down, report the throttled response as is
+        }
+    }
+
+    // The rest runs on the tidy pool. The engine's thread only drives transfers:
+    // processing a reply can touch the WebCache on disk, and it must never wait
+    // on _curlMutex, which a blocking request holds for as long as it runs
+    QtConcurrent::run(tidyPool(), [this, request, result]()
+    {
+        finishAsyncRequest(request, result);
+    });
+}
+
+void WebClient::finishAsyncRequest(AsyncRequestPtr request, CURLcode result)
+{
+    ReplyPtr reply;
+    bool bFailed = false;
+
+    try
+    {
+        checkCancelled(*request, result);
+        reply = processResult(*request, result);
+    }
+    catch (...)
+    {
+        request->promise.set_exception(std::current_exception());
+        bFailed = true;
+    }
+
+    if (result == CURLE_OK)
+    {
+        setLastRequestUrl(effectiveUrl(request->handle));
+    }
+
+    // cookies the server set (e.g. a new session id) are merged into our own
+    // handle before its next request. The rest of the request's jar is the
+    // snapshot taken when it was submitted and may be older than ours by now
+    {
+        const std::set<std::string> sent(request->sentCookies.begin(), request->sentCookies.end());
+
+        std::vector<std::string> received;
+        for (auto& line : cookieLines(request->handle))
+        {
+            if (sent.find(line) == sent.end())
+            {
+                received.push_back(std::move(line));
+            }
+        }
+
+        if (!received.empty())
+        {
+            Lock lock(_stateMutex);
+            _pendingCookies.insert(_pendingCookies.end(),
+                std::make_move_iterator(received.begin()), std::make_move_iterator(received.end()));
+        }
+    }
+
+    unsetHeaders(request->headers);
+    curl_easy_cleanup(request->handle);
+    request->handle = nullptr;
+
+    if (!bFailed)
+    {
+        tidyReply(reply, *request);
+        request->promise.set_value(reply);
+    }
+
+    Lock lock(_asyncMutex);
+    _asyncCount--;
+    _asyncCondition.notify_all();
+}
+
+bool WebClient::retryThrottled(Transfer& transfer, CURLcode result)
+{
+    long status = 0;
+    if (result == CURLE_OK)
+    {
+        curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &status);
+    }
+
+    RateLimiter::instance().update(transfer.host, status,
+        transfer.response.headers.getText("retry-after", false));
+
+    if (!RateLimiter::isThrottled(status) || transfer.attempts >= MAX_THROTTLE_RETRIES)
+    {
+        return false;
+    }
+
+    // a POST may already have been acted on (a reply posted, a login counted),
+    // so the caller gets the throttled reply rather than sending it twice
+    if (transfer.method != Method::GET)
+    {
+        return false;
+    }
+
+    transfer.attempts++;
+    _logger->debug("Request to '{}' was throttled with HTTP {}, retry {} of {}",
+        transfer.url.toStdString(), status, transfer.attempts, MAX_THROTTLE_RETRIES);
+
+    transfer.response.body.clear();
+    transfer.response.headers.clear();
+    transfer.errbuf[0] = 0;
+
+    return true;
+}
+
+void WebClient::checkCancelled(const Transfer& transfer, CURLcode result)
+{
+    // a transfer that finished before its token was cancelled still counts
+    if (!transfer.token
+        || (result != CURLE_ABORTED_BY_CALLBACK && result != CURLE_OPERATION_TIMEDOUT)
+        || !transfer.token->isCancelled())
+    {
+        return;
+    }
+
+    _logger->debug("Request to '{}' was stopped after {} ms because its operation was cancelled or timed out",
+        transfer.url.toStdString(), transfer.timer.elapsed());
+
+    transfer.token->throwIfCancelled();
+}
+
+void WebClient::tidyReply(ReplyPtr reply, const Transfer& transfer)
+{
+    if (!reply)
+    {
+        return;
+    }
+
     QElapsedTimer timer;
     timer.start();
 
-    bool bThrowOnFail = getThrowOnFail();
+    if (reply->status() == 200 && transfer.tidy && !(transfer.options & Options::NOTIDY))
+    {
+        std::string temp{ owl::tidyHTML(reply->data()) };
+        reply->swapData(temp);
+    }
+
+    reply->setTimings(transfer.networkTime, timer.elapsed());
+
+    if (reply->status() == 200)
+    {
+        _logger->trace("HTTP Response from '{}' with length of '{}' ({} bytes transferred) took {} milliseconds ({} ms network, {} ms tidy)",
+            reply->finalUrl(), reply->contentSize(), reply->wireSize(),
+            reply->networkTime() + reply->tidyTime(), reply->networkTime(), reply->tidyTime());
+    }
+}
+
+WebClient::ReplyPtr WebClient::checkCache(Transfer& transfer, Method method, const QString& payload)
+{
+    auto& cache = WebCache::instance();
+
+    // only GET responses are safe to replay, POSTs (logins, XML-RPC calls
+    // and so on) always go to the server
+    if (method != Method::GET
+        || (transfer.options & Options::NOCACHE)
+        || !cache.isEnabled())
+    {
+        return nullptr;
+    }
+
+    transfer.cacheKey = WebCache::makeKey(QStringLiteral("GET"), transfer.url, payload, _cacheIdentity);
+    transfer.privateCache = !_cacheIdentity.isEmpty();
+    transfer.cached = cache.find(transfer.cacheKey);
+
+    if (transfer.cached && transfer.cached->isFresh())
+    {
+        _logger->trace("Serving '{}' from the cache", transfer.url.toStdString());
+        return makeReply(transfer, 200, transfer.cached->finalUrl, std::move(transfer.cached->data));
+    }
+
+    if (transfer.cached && !transfer.cached->hasValidator())
+    {
+        transfer.cached.reset();
+    }
+
+    return nullptr;
+}
 
+void WebClient::updateCache(const Transfer& transfer, const std::string& finalUrl, const std::string& data)
+{
+    QString cacheControl = transfer.response.headers.getText("cache-control", false);
+    const QString expires = transfer.response.headers.getText("expires", false);
+
+    // no-cache and max-age=0 responses are kept too, they are revalidated
+    // with their ETag/Last-Modified before every use
+    if (!WebCache::isStorable(cacheControl, transfer.privateCache))
+    {
+        WebCache::instance().remove(transfer.cacheKey);
+        return;
+    }
+
+    // HTTP/1.0 servers say no-cache with Pragma
+    if (cacheControl.isEmpty()
+        && transfer.response.headers.getText("pragma", false).contains(QStringLiteral("no-cache"), Qt::CaseInsensitive))
+    {
+        cacheControl = QStringLiteral("no-cache");
+    }
+
+    WebCache::Entry entry;
+    if (!WebCache::expiresFromHeaders(cacheControl, expires, QDateTime::currentDateTimeUtc(), entry.expires))
+    {
+        WebCache::instance().remove(transfer.cacheKey);
+        return;
+    }
+
+    // a 304 doesn't have to repeat the validators
+    entry.etag = transfer.response.headers.getText("etag", false);
+    entry.lastModified = transfer.response.headers.getText("last-modified", false);
+    if (transfer.cached)
+    {
+        if (entry.etag.isEmpty()) entry.etag = transfer.cached->etag;
+        if (entry.lastModified.isEmpty()) entry.lastModified = transfer.cached->lastModified;
+    }
+
+    // an entry that is already stale and that can't be revalidated is useless
+    if (!entry.isFresh() && !entry.hasValidator())
+    {
+        WebCache::instance().remove(transfer.cacheKey);
+        return;
+    }
+
+    entry.finalUrl = finalUrl;
+    WebCache::instance().store(transfer.cacheKey, entry, data);
+}
+
+void WebClient::prepareRequest(CURL* curl, const QString& url, const QString& payload, Method method)
+{
     // set the URL we're getting
-    curl_easy_setopt(_curl, CURLOPT_URL, url.toLatin1().data());
+    curl_easy_setopt(curl, CURLOPT_URL, url.toLatin1().data());
 
     // set up a GET or POST, if not a GET assume a POST
     if (method == Method::GET)
@@ -228,8 +999,8 @@ WebClient::ReplyPtr WebClient::doRequest(const QString& url,
             urlObj.scheme().toUpper().toStdString(),
             url.toStdString());
 
-        curl_easy_setopt(_curl, CURLOPT_HTTPGET, 1L);
-        curl_easy_setopt(_curl, CURLOPT_POST, 0L);
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl, CURLOPT_POST, 0L);
     }
     else if (method == Method::POST)
     {
@@ -240,44 +1011,42 @@ WebClient::ReplyPtr WebClient::doRequest(const QString& url,
             url.toStdString(),
             payload.size());
 
-        curl_easy_setopt(_curl, CURLOPT_HTTPGET, 0L);
-        curl_easy_setopt(_curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 0L);
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
 
         if (payload.size() > 0)
         {
-            curl_easy_setopt(_curl, CURLOPT_POSTFIELDSIZE, payload.size());
-            curl_easy_setopt(_curl, CURLOPT_COPYPOSTFIELDS, payload.toLocal8Bit().data());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, payload.size());
+            curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, payload.toLocal8Bit().data());
         }
         else
         {
-            curl_easy_setopt(_curl, CURLOPT_POSTFIELDSIZE, 0L);
-            curl_easy_setopt(_curl, CURLOPT_POSTFIELDS, nullptr);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
         }
     }
     else
     {
         OWL_THROW_EXCEPTION(owl::WebException("Unsupported HTTP method"));
     }
+}
 
-    auto headers = setHeaders();
-
-    _buffer.clear();
-    CURLcode result = curl_easy_perform(_curl);
-
-    unsetHeaders(headers);
+WebClient::ReplyPtr WebClient::processResult(Transfer& transfer, CURLcode result)
+{
+    transfer.networkTime = transfer.timer.elapsed();
 
     long status = 0;
-    curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &status);
 
     if (result != CURLE_OK)
     {
         QString errorText;
 
-        size_t len = strlen(_errbuf);
+        size_t len = strlen(transfer.errbuf);
         if (len > 0)
         {
             errorText = QString("Request error: %1")
-                .arg(_errbuf);
+                .arg(transfer.errbuf);
         }
         else
         {
@@ -286,58 +1055,71 @@ WebClient::ReplyPtr WebClient::doRequest(const QString& url,
         }
 
         _logger->warn(errorText.toStdString());
-        if (bThrowOnFail)
+        if (transfer.throwOnFail)
         {
             // TODO: Add more details to this exception, like below:
-            OWL_THROW_EXCEPTION(owl::WebException(errorText, url, status));
+            OWL_THROW_EXCEPTION(owl::WebException(errorText, transfer.url, status));
         }
 
         return nullptr;
     }
 
     char *finalUrl;
-    curl_easy_getinfo(_curl, CURLINFO_EFFECTIVE_URL, &finalUrl);
+    curl_easy_getinfo(transfer.handle, CURLINFO_EFFECTIVE_URL, &finalUrl);
 
-    _lastUrl = QString::fromLatin1(finalUrl);
+    curl_off_t wireSize = 0;
+    curl_easy_getinfo(transfer.handle, CURLINFO_SIZE_DOWNLOAD_T, &wireSize);
+    transfer.wireSize = static_cast<std::size_t>(wireSize);
 
+    if (status == 304 && transfer.cached)
+    {
+        _logger->trace("Revalidated cached response for '{}'", transfer.url.toStdString());
+
+        updateCache(transfer, transfer.cached->finalUrl, transfer.cached->data);
+        return makeReply(transfer, 200, transfer.cached->finalUrl, std::move(transfer.cached->data));
+    }
+    else if (status == 200 && !transfer.cacheKey.isEmpty())
+    {
+        updateCache(transfer, finalUrl, transfer.response.body);
+    }
+
+    return makeReply(transfer, status, finalUrl, std::move(transfer.response.body));
+}
+
+WebClient::ReplyPtr WebClient::makeReply(const Transfer& transfer, long status,
+                                         const std::string& finalUrl, std::string&& buffer)
+{
     auto retval = std::make_shared<Reply>(status);
     retval->setFinalUrl(finalUrl);
+    retval->setHeaders(transfer.response.headers);
+    retval->setTransferSize(transfer.wireSize, transfer.wireSize > 0 ? buffer.size() : 0);
 
     if (status == 200)
     {
-        if (!(options & Options::NOTIDY))
-        {
-            std::string temp{ owl::tidyHTML(_buffer.c_str()) };
-            retval->setData(temp, temp.size());
-        }
-        else
-        {
-            retval->setData(_buffer, _buffer.size());
-        }
-
-        _logger->trace("HTTP Response from '{}' with length of '{}' took {} milliseconds",
-            finalUrl, _buffer.size(), timer.elapsed());
+        // tidying, if any, is done by tidyReply() once the network lock is released
+        retval->swapData(buffer);
     }
     else
     {
-        QString errorText = QString("Unhandled HTTP response code '%1' from %2 took %3 milliseconds").arg(status).arg(finalUrl).arg(timer.elapsed());
+        QString errorText = QString("Unhandled HTTP response code '%1' from %2 took %3 milliseconds")
+            .arg(status).arg(QString::fromStdString(finalUrl)).arg(transfer.timer.elapsed());
         _logger->debug(errorText.toStdString());
-        if (bThrowOnFail)
+        if (transfer.throwOnFail)
         {
-            OWL_THROW_EXCEPTION(owl::WebException(errorText, url, status));
+            OWL_THROW_EXCEPTION(owl::WebException(errorText, transfer.url, status));
         }
         else
         {
             // sometimes the data is still needed even if we don't get
             // a 200 result, but we can safely NOT tidy it
-            retval->setData(_buffer, _buffer.size());
+            retval->swapData(buffer);
         }
     }
 
     return retval;
 }
 
-curl_slist* WebClient::setHeaders()
+curl_slist* WebClient::setHeaders(CURL* curl, const WebCache::Entry* cached)
 {
 	curl_slist* headers = nullptr;
 
@@ -354,8 +1136,24 @@ curl_slist* WebClient::setHeaders()
         headers = curl_slist_append(headers, header.toLatin1().data());
     }
 
+    // make the request conditional if we're revalidating a cached response
+    if (cached != nullptr)
+    {
+        if (!cached->etag.isEmpty())
+        {
+            headers = curl_slist_append(headers,
+                QString("If-None-Match: %1").arg(cached->etag).toLatin1().data());
+        }
+
+        if (!cached->lastModified.isEmpty())
+        {
+            headers = curl_slist_append(headers,
+                QString("If-Modified-Since: %1").arg(cached->lastModified).toLatin1().data());
+        }
+    }
+
     /* pass our list of custom made headers */
-    curl_easy_setopt(_curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
     return headers;
 }
@@ -374,25 +1172,30 @@ void WebClient::initCurlSettings()
         OWL_THROW_EXCEPTION(Exception("CURL SSL support is required but not enabled"));
     }
 
-    // set up our writer
+    // set up our writers, the buffers are bound for each request
     curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, CURLwriter);
-    curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &_buffer);
-    curl_easy_setopt(_curl, CURLOPT_ERRORBUFFER, _errbuf);
+    curl_easy_setopt(_curl, CURLOPT_HEADERFUNCTION, CURLheader);
 
     // set the redirects and the max number
     curl_easy_setopt(_curl, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(_curl, CURLOPT_MAXREDIRS, DEFAULT_MAX_REDIRECTS);
 
+    // advertise every encoding (gzip, deflate and brotli if libcurl was built
+    // with it) that libcurl supports, responses are decoded as they stream in
+    curl_easy_setopt(_curl, CURLOPT_ACCEPT_ENCODING, "");
+
     // start cookie engine
     curl_easy_setopt(_curl, CURLOPT_COOKIEFILE, "");
 
+    // reuse DNS lookups and TLS sessions across all instances
+    curl_easy_setopt(_curl, CURLOPT_SHARE, CurlShare::handle());
+
     // <SSL CONFIG>
     // since PEM is default, we needn't set it for PEM
     curl_easy_setopt(_curl, CURLOPT_SSL_VERIFYPEER, 0L);
     //curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
 
-    // need to disable this otherwise SSL does not work on Windows 7
-    curl_easy_setopt(_curl, CURLOPT_SSL_ENABLE_ALPN, 0);
+    applyHttpVersion();
 
     // tell libcurl to redirect a post with a post after a 301, 302 or 303
     curl_easy_setopt(_curl, CURLOPT_POSTREDIR, CURL_REDIR_POST_ALL);
@@ -400,12 +1203,62 @@ void WebClient::initCurlSettings()
     // disable all curl's signal handling
     curl_easy_setopt(_curl, CURLOPT_NOSIGNAL, 1L);
 
+    // give up on servers that never answer or stall mid response, callers
+    // that need a tighter bound use a CancellationToken with a deadline
+    curl_easy_setopt(_curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT);
+    curl_easy_setopt(_curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(_curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME);
+
 //#ifdef _DEBUG
 //    curl_easy_setopt(_curl, CURLOPT_VERBOSE, 1);
 //    curl_easy_setopt(_curl, CURLOPT_DEBUGFUNCTION, trace);
 //#endif
 }
 
+bool WebClient::isHttp2Available()
+{
+    static const bool bAvailable = []()
+    {
+        const curl_version_info_data* vinfo = curl_version_info(CURLVERSION_NOW);
+        if (!(vinfo->features & CURL_VERSION_HTTP2))
+        {
+            return false;
+        }
+
+#ifdef Q_OS_WIN
+        // SSL does not work on Windows 7 with ALPN enabled
+        if (QOperatingSystemVersion::current() < QOperatingSystemVersion::Windows8)
+        {
+            return false;
+        }
+#endif
+
+        return true;
+    }();
+
+    return bAvailable;
+}
+
+void WebClient::applyHttpVersion()
+{
+    if (_useHttp2)
+    {
+        // HTTP/2 is negotiated through ALPN on https connections and plain http
+        // stays on HTTP/1.1. Transfers started while a connection to the same host
+        // is still being set up wait for it so they can be multiplexed over it
+        // rather than opening connections of their own
+        curl_easy_setopt(_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(_curl, CURLOPT_SSL_ENABLE_ALPN, 1L);
+        curl_easy_setopt(_curl, CURLOPT_PIPEWAIT, 1L);
+    }
+    else
+    {
+        curl_easy_setopt(_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(_curl, CURLOPT_SSL_ENABLE_ALPN, 0L);
+        curl_easy_setopt(_curl, CURLOPT_PIPEWAIT, 0L);
+    }
+}
+
 const std::string tidyHTML(const std::string& html)
 {
     // see:http://tidy.sourceforge.net/libintro.html
@@ -423,8 +1276,14 @@ const std::string tidyHTML(const std::string& html)
     if (ok)
         rc = tidySetErrorBuffer( tdoc, &errbuf );      // Capture diagnostics (required!)
 
+    // parse straight out of the caller's buffer rather than making a NUL
+    // terminated copy of it
+    TidyBuffer input = {0};
+    tidyBufAttach(&input, reinterpret_cast<byte*>(const_cast<char*>(html.data())),
+        static_cast<uint>(html.size()));
+
     if ( rc >= 0 )
-        rc = tidyParseString( tdoc, html.data() );           // Parse the input
+        rc = tidyParseBuffer( tdoc, &input );           // Parse the input
 
     if ( rc >= 0 )
         rc = tidyCleanAndRepair( tdoc );               // Tidy it up!
@@ -451,6 +1310,7 @@ const std::string tidyHTML(const std::string& html)
         retStr = html;
     }
 
+    tidyBufDetach(&input);
     tidyBufFree(&output);
     tidyBufFree(&errbuf);
     tidyRelease(tdoc);
@@ -2,8 +2,16 @@
 // Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
 
 #pragma once
+#include <condition_variable>
+#include <future>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "SingleFlight.h"
 #include "StringMap.h"
+#include "WebCache.h"
 
 #include <curl/curl.h>
 
@@ -25,6 +33,16 @@ struct WebClientConfig
     bool    useEncryption;
     QString encryptKey;
     QString encryptSeed;
+
+    // parsers whose DOM layer copes with malformed markup can skip tidying
+    bool    useTidy = true;
+
+    // negotiate HTTP/2 (through ALPN) when the server supports it
+    bool    useHttp2 = true;
+
+    // who the requests are made as (the board and user), part of every
+    // cache key so accounts never see each other's cached pages
+    QString cacheIdentity;
 };
 
 class WebClient :  public QObject
@@ -50,19 +68,63 @@ public:
             long status() const { return _status; }
             void setStatus(long status) { _status = status; }
 
-            QString text() const { return QString::fromStdString(_data); }
+            QString text() const { return QString::fromUtf8(_data.data(), static_cast<int>(_data.size())); }
+
+            // the raw response body, these do not copy and are only valid
+            // for the lifetime of the Reply
+            const std::string& data() const { return _data; }
+            std::string_view view() const { return _data; }
+            QByteArray byteArray() const
+            {
+                return QByteArray::fromRawData(_data.data(), static_cast<int>(_data.size()));
+            }
 
-            std::string const data() { return _data; }
             void setData(const std::string& data, std::size_t size) 
             { 
                 _data.append(data.data(), size); 
             }
 
+            // takes the buffer curl wrote into without copying it
+            void swapData(std::string& data) { _data.swap(data); }
+
             std::string finalUrl() const { return _finalUrl; }
             void setFinalUrl(const std::string& finalUrl) { _finalUrl = finalUrl; }
+
+            // the response's headers with lowercase keys, empty for cached replies
+            const StringMap& headers() const { return _headers; }
+            void setHeaders(const StringMap& headers) { _headers = headers; }
+
+            // bytes received over the wire (compressed) versus the size
+            // of the decoded response body, both zero for cached replies
+            std::size_t wireSize() const { return _wireSize; }
+            std::size_t contentSize() const { return _contentSize; }
+            void setTransferSize(std::size_t wireSize, std::size_t contentSize)
+            {
+                _wireSize = wireSize;
+                _contentSize = contentSize;
+            }
+
+            // milliseconds spent on the request itself and on tidying the response
+            qint64 networkTime() const { return _networkTime; }
+            qint64 tidyTime() const { return _tidyTime; }
+            void setTimings(qint64 networkTime, qint64 tidyTime)
+            {
+                _networkTime = networkTime;
+                _tidyTime = tidyTime;
+            }
+
+        private:
+            StringMap       _headers;
+            std::size_t     _wireSize = 0;
+            std::size_t     _contentSize = 0;
+            qint64          _networkTime = 0;
+            qint64          _tidyTime = 0;
     };
     using ReplyPtr = std::shared_ptr<Reply>;
 
+    // response headers, keys are lowercase
+    using HeaderMap = StringMap;
+
     enum Method
     {
         GET     = 1,
@@ -105,10 +167,24 @@ public:
     void printCookies();
     void deleteAllCookies();
 
+    // Whether this build of libcurl can speak HTTP/2 and the platform's TLS stack copes
+    // with ALPN, which it doesn't on Windows 7
+    static bool isHttp2Available();
+
+    // The cookie jar in Netscape cookie file format, one cookie per line, which
+    // can be handed back to importCookies() to resume the session later
+    QByteArray exportCookies() const;
+    void importCookies(const QByteArray& cookies);
+
+    // Requests pick up the CancellationToken installed on the calling thread (see
+    // CancellationToken::Scope). A request whose token is cancelled or runs past its
+    // deadline is aborted and throws a CancelledException, even if throwOnFail is off
+
     // Submits an HTTP GET and returns the webpage contents or an empty string
     QString DownloadString(const QString& url, uint options = Options::DEFAULT);
 
-    // Submits an HTTP GET and returns a reply object or nullptr
+    // Submits an HTTP GET and returns a reply object or nullptr. Identical GETs that are
+    // already in flight on this client share that request's reply
     ReplyPtr GetUrl(const QString& url, uint options = Options::DEFAULT);
 
     // Submits an HTTP POST and returns the result's string or an empty string
@@ -117,7 +193,18 @@ public:
     // Submits an HTTP POST and returns a reply object or nullptr
     ReplyPtr PostUrl(const QString& url, const QString& payload, uint options = Options::DEFAULT);
 
+    // Submits an HTTP GET to the shared WebRequestEngine and returns immediately. The
+    // future yields the same result GetUrl() would have returned or rethrows its exception
+    std::future<ReplyPtr> GetUrlAsync(const QString& url, uint options = Options::DEFAULT);
+
+    // Submits an HTTP POST to the shared WebRequestEngine and returns immediately
+    std::future<ReplyPtr> PostUrlAsync(const QString& url, const QString& payload, uint options = Options::DEFAULT);
+
 private:
+    struct Transfer;
+    struct AsyncRequest;
+    using AsyncRequestPtr = std::shared_ptr<AsyncRequest>;
+
     // If successful, will return a new object and release ownership to the caller
     // If unsucessful, throw an error OR return null if throwOnFail=false
     ReplyPtr doRequest(const QString& url,
@@ -125,21 +212,75 @@ private:
                            Method method = Method::GET,
                            uint options = Options::DEFAULT);
 
-    curl_slist* setHeaders();
+    std::future<ReplyPtr> doRequestAsync(const QString& url,
+                           const QString& payload,
+                           Method method,
+                           uint options);
+
+    // sets the url, method and payload on the given handle
+    void prepareRequest(CURL* curl, const QString& url, const QString& payload, Method method);
+
+    // builds the Reply from a finished transfer, shared by the blocking and async paths
+    ReplyPtr processResult(Transfer& transfer, CURLcode result);
+    ReplyPtr makeReply(const Transfer& transfer, long status,
+                       const std::string& finalUrl, std::string&& buffer);
+
+    // called on the WebRequestEngine's thread, retries a throttled request or
+    // hands it to finishAsyncRequest() on the tidy pool
+    void completeAsyncRequest(AsyncRequestPtr request, CURLcode result);
+    void finishAsyncRequest(AsyncRequestPtr request, CURLcode result);
+
+    void setLastRequestUrl(const QString& url);
+
+    // merges the cookies async requests received into _curl, must be called
+    // while holding _curlMutex
+    void applyPendingCookies() const;
+
+    // reports the response to the RateLimiter and returns true if the request was
+    // a throttled GET that should be sent again, in which case the transfer is reset
+    bool retryThrottled(Transfer& transfer, CURLcode result);
+
+    // throws a CancelledException if the transfer was aborted because the
+    // caller's CancellationToken was cancelled or ran out of time
+    void checkCancelled(const Transfer& transfer, CURLcode result);
+
+    // runs tidyHTML() over successful replies unless it was disabled, must
+    // be called without holding _curlMutex
+    void tidyReply(ReplyPtr reply, const Transfer& transfer);
+
+    // returns a reply if the request can be answered from the WebCache, otherwise
+    // sets up the transfer to store the response and/or revalidate a stale entry
+    ReplyPtr checkCache(Transfer& transfer, Method method, const QString& payload);
+    void updateCache(const Transfer& transfer, const std::string& finalUrl, const std::string& data);
+
+    curl_slist* setHeaders(CURL* curl, const WebCache::Entry* cached = nullptr);
     void unsetHeaders(curl_slist* headers);
     void initCurlSettings();
+    void applyHttpVersion();
+
+    mutable Mutex       _curlMutex;
+
+    // guards _lastUrl and _pendingCookies, only ever held briefly so that
+    // finishing an async request doesn't wait on a blocking one
+    mutable Mutex                       _stateMutex;
+    mutable std::vector<std::string>    _pendingCookies;    // set by async replies, not yet in _curl
+
+    Mutex                       _asyncMutex;
+    std::condition_variable     _asyncCondition;
+    std::size_t                 _asyncCount = 0;                // in-flight async requests, guarded by _asyncMutex
 
-    Mutex               _curlMutex;
+    SingleFlight<QString, ReplyPtr> _getFlights;                // coalesces duplicate GetUrl() calls
 
     CURL*               _curl = nullptr;                        // the curl object
-    std::string         _buffer;                                // buffer for response text
-    char                _errbuf[CURL_ERROR_SIZE];               // detailed error buffer
     StringMap           _headers;                               // map of headers that get set before requests and unset after
     QTextCodec*         _textCodec;                             // TODO: learn more about this
     QString             _lastUrl;                               // realized url from the last successful request
     QString             _contentType = "application/x-www-form-urlencoded";
 
     bool                _throwOnFail = true;                   // whether or not to throw, can be overriden in actual call
+    bool                _useTidy = true;                        // NOTIDY still overrides this per request
+    bool                _useHttp2 = isHttp2Available();
+    QString             _cacheIdentity;
 
     bool                _useEncryption = false;                 // whether or not to encrypt the result, can be overridden in actual call
     QString             _strEncyrptionKey;
@@ -0,0 +1,237 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include "WebRequestEngine.h"
+#include "Exception.h"
+
+#include <Utils/OwlLogger.h>
+
+namespace owl
+{
+
+WebRequestEngine& WebRequestEngine::instance()
+{
+    static WebRequestEngine __engine;
+    return __engine;
+}
+
+WebRequestEngine::WebRequestEngine()
+    : _logger(owl::initializeLogger("WebRequestEngine"))
+{
+    _multi = curl_multi_init();
+
+    if (!_multi)
+    {
+        OWL_THROW_EXCEPTION(Exception("Could not create CURL multi instance"));
+    }
+
+    curl_multi_setopt(_multi, CURLMOPT_MAX_HOST_CONNECTIONS, ENGINE_MAX_HOST_CONNECTIONS);
+
+    // transfers to the same HTTP/2 server share one connection
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    _thread = std::thread(&WebRequestEngine::run, this);
+}
+
+WebRequestEngine::~WebRequestEngine()
+{
+    {
+        Lock lock(_mutex);
+        _stop = true;
+    }
+
+    wakeup();
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+
+    curl_multi_cleanup(_multi);
+}
+
+void WebRequestEngine::submit(CURL* handle, CompletionHandler handler, Clock::time_point notBefore)
+{
+    {
+        Lock lock(_mutex);
+
+        if (_stop)
+        {
+            OWL_THROW_EXCEPTION(Exception("WebRequestEngine is shutting down"));
+        }
+
+        _incoming.push_back(Submission { handle, std::move(handler), notBefore });
+        _pendingCount++;
+    }
+
+    wakeup();
+}
+
+void WebRequestEngine::wakeup()
+{
+    _condition.notify_one();
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    // curl_multi_wakeup() was added in 7.68.0, older versions of libcurl
+    // rely on the poll timeout to pick up newly submitted transfers
+    curl_multi_wakeup(_multi);
+#endif
+}
+
+void WebRequestEngine::run()
+{
+    while (true)
+    {
+        {
+            UniqueLock lock(_mutex);
+
+            // with nothing in flight there is no reason to spin on
+            // curl_multi_poll(), so sleep until there is work to do
+            if (_active.empty())
+            {
+                auto ready = [this]() { return _stop || !_incoming.empty(); };
+
+                if (_delayed.empty())
+                {
+                    _condition.wait(lock, ready);
+                }
+                else
+                {
+                    _condition.wait_until(lock, _delayed.begin()->first, ready);
+                }
+            }
+
+            if (_stop)
+            {
+                break;
+            }
+        }
+
+        addIncoming();
+        addDelayed();
+
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(_multi, &running);
+        if (mc != CURLM_OK)
+        {
+            _logger->warn("curl_multi_perform() failed: {}", curl_multi_strerror(mc));
+        }
+
+        completeTransfers();
+
+        if (running > 0)
+        {
+            int timeout = ENGINE_POLL_TIMEOUT_MS;
+            if (!_delayed.empty())
+            {
+                const auto untilNext = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    _delayed.begin()->first - Clock::now()).count();
+                timeout = static_cast<int>(std::max<long long>(0, std::min<long long>(timeout, untilNext)));
+            }
+
+            curl_multi_poll(_multi, nullptr, 0, timeout, nullptr);
+        }
+    }
+
+    // fail anything that was still queued, waiting or in flight
+    addIncoming();
+    for (auto& kv : _delayed)
+    {
+        complete(kv.second.handler, kv.second.handle, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    _delayed.clear();
+
+    for (auto& kv : _active)
+    {
+        curl_multi_remove_handle(_multi, kv.first);
+        complete(kv.second, kv.first, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    _active.clear();
+}
+
+void WebRequestEngine::addIncoming()
+{
+    std::vector<Submission> incoming;
+
+    {
+        Lock lock(_mutex);
+        incoming.swap(_incoming);
+    }
+
+    for (auto& item : incoming)
+    {
+        const auto notBefore = item.notBefore;
+        _delayed.emplace(notBefore, std::move(item));
+    }
+}
+
+void WebRequestEngine::addDelayed()
+{
+    const auto now = Clock::now();
+
+    while (!_delayed.empty() && _delayed.begin()->first <= now)
+    {
+        Submission item = std::move(_delayed.begin()->second);
+        _delayed.erase(_delayed.begin());
+
+        CURLMcode mc = curl_multi_add_handle(_multi, item.handle);
+        if (mc != CURLM_OK)
+        {
+            _logger->warn("curl_multi_add_handle() failed: {}", curl_multi_strerror(mc));
+            complete(item.handler, item.handle, CURLE_FAILED_INIT);
+            continue;
+        }
+
+        _active.emplace(item.handle, std::move(item.handler));
+    }
+}
+
+void WebRequestEngine::completeTransfers()
+{
+    int msgsLeft = 0;
+    CURLMsg* msg = nullptr;
+
+    while ((msg = curl_multi_info_read(_multi, &msgsLeft)) != nullptr)
+    {
+        if (msg->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        // the message is invalidated by curl_multi_remove_handle() so
+        // grab what we need from it first
+        CURL* handle = msg->easy_handle;
+        const CURLcode result = msg->data.result;
+
+        curl_multi_remove_handle(_multi, handle);
+
+        auto it = _active.find(handle);
+        if (it == _active.end())
+        {
+            continue;
+        }
+
+        CompletionHandler handler = std::move(it->second);
+        _active.erase(it);
+
+        complete(handler, handle, result);
+    }
+}
+
+void WebRequestEngine::complete(const CompletionHandler& handler, CURL* handle, CURLcode result)
+{
+    try
+    {
+        handler(handle, result);
+    }
+    catch (const std::exception& ex)
+    {
+        _logger->error("Unhandled exception in request completion handler: {}", ex.what());
+    }
+
+    _pendingCount--;
+}
+
+} // namespace
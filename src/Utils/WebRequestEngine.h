@@ -0,0 +1,93 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+namespace spdlog
+{
+    class logger;
+}
+
+namespace owl
+{
+
+// Maximum time in milliseconds the event loop will block waiting on socket
+// activity before checking for newly submitted transfers
+const int       ENGINE_POLL_TIMEOUT_MS      = 50;
+const long      ENGINE_MAX_HOST_CONNECTIONS = 6;
+
+// Drives any number of in-flight CURL easy handles from a single event
+// loop thread using one curl_multi handle. Completion handlers are invoked
+// on the engine's thread, so they should not block for long.
+class WebRequestEngine
+{
+    using Mutex         = std::mutex;
+    using Lock          = std::lock_guard<std::mutex>;
+    using UniqueLock    = std::unique_lock<std::mutex>;
+
+public:
+    using Clock             = std::chrono::steady_clock;
+    using CompletionHandler = std::function<void(CURL*, CURLcode)>;
+
+    static WebRequestEngine& instance();
+
+    WebRequestEngine();
+    virtual ~WebRequestEngine();
+
+    WebRequestEngine(const WebRequestEngine&) = delete;
+    WebRequestEngine& operator=(const WebRequestEngine&) = delete;
+
+    // Queues the transfer on the event loop. The engine does not take
+    // ownership of the handle, the handler is called exactly once after
+    // the transfer has finished (or failed) and the handle has been
+    // detached from the multi handle. The transfer is not started before
+    // notBefore, which is how rate limited requests wait without blocking.
+    void submit(CURL* handle, CompletionHandler handler, Clock::time_point notBefore = Clock::time_point());
+
+    // Number of transfers that have been submitted but not yet completed
+    std::size_t pendingCount() const { return _pendingCount; }
+
+private:
+    void run();
+    void wakeup();
+    void addIncoming();
+    void addDelayed();
+    void completeTransfers();
+
+    // runs a transfer's handler and counts it as done, an exception from the
+    // handler is logged so it can't take down the loop thread
+    void complete(const CompletionHandler& handler, CURL* handle, CURLcode result);
+
+    struct Submission
+    {
+        CURL*               handle;
+        CompletionHandler   handler;
+        Clock::time_point   notBefore;
+    };
+
+    mutable Mutex                               _mutex;
+    std::condition_variable                     _condition;
+
+    CURLM*                                      _multi = nullptr;
+    std::vector<Submission>                     _incoming;          // guarded by _mutex
+    std::multimap<Clock::time_point, Submission> _delayed;          // only touched by the loop thread
+    std::map<CURL*, CompletionHandler>          _active;            // only touched by the loop thread
+    std::atomic<std::size_t>                    _pendingCount { 0 };
+    bool                                        _stop = false;
+
+    std::thread                                 _thread;
+
+    std::shared_ptr<spdlog::logger>             _logger;
+};
+
+} // namespace
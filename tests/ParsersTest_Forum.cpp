@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/data/test_case.hpp>
 
+#include <algorithm>
 #include <ostream>
 
 #include "../src/Parsers/Forum.h"
@@ -19,4 +20,78 @@ BOOST_AUTO_TEST_CASE(testForum)
     BOOST_CHECK_EQUAL(f.getName().toStdString(), "General");
 }
 
+namespace
+{
+
+owl::ForumPtr makeForum(const QString& id, const QString& name, int order,
+    owl::Forum::ForumType type = owl::Forum::FORUM)
+{
+    auto forum = std::make_shared<owl::Forum>(id, name, type);
+    forum->setDisplayOrder(order);
+    return forum;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(fingerprintTest)
+{
+    const owl::ForumList list { makeForum("1", "News", 1), makeForum("2", "General", 2) };
+    const owl::ForumList same { makeForum("1", "News", 1), makeForum("2", "General", 2) };
+
+    BOOST_CHECK(!owl::Forum::fingerprint(list).isEmpty());
+    BOOST_CHECK(owl::Forum::fingerprint(list) == owl::Forum::fingerprint(same));
+
+    const owl::ForumList renamed { makeForum("1", "Announcements", 1), makeForum("2", "General", 2) };
+    BOOST_CHECK(owl::Forum::fingerprint(list) != owl::Forum::fingerprint(renamed));
+
+    const owl::ForumList reordered { makeForum("1", "News", 2), makeForum("2", "General", 1) };
+    BOOST_CHECK(owl::Forum::fingerprint(list) != owl::Forum::fingerprint(reordered));
+
+    const owl::ForumList retyped { makeForum("1", "News", 1, owl::Forum::LINK), makeForum("2", "General", 2) };
+    BOOST_CHECK(owl::Forum::fingerprint(list) != owl::Forum::fingerprint(retyped));
+}
+
+BOOST_AUTO_TEST_CASE(diffForumsTest)
+{
+    const owl::ForumList stored
+    {
+        makeForum("1", "News", 1),
+        makeForum("2", "General", 2),
+        makeForum("3", "Off Topic", 3),
+        makeForum("4", "Archive", 4)
+    };
+
+    const owl::ForumList current
+    {
+        makeForum("1", "News", 1),
+        makeForum("3", "Off Topic", 2),
+        makeForum("2", "General Discussion", 3),
+        makeForum("5", "Help", 4, owl::Forum::CATEGORY)
+    };
+
+    BOOST_CHECK(owl::Forum::diffForums("0", stored, stored).isEmpty());
+
+    const owl::ForumChangeList changes = owl::Forum::diffForums("0", stored, current);
+
+    auto count = [&changes](owl::ForumChange::ChangeType type, const QString& id)
+    {
+        return std::count_if(changes.begin(), changes.end(),
+            [type, &id](const owl::ForumChange& change)
+            {
+                return change.type == type && change.forum->getId() == id && change.parentId == "0";
+            });
+    };
+
+    BOOST_CHECK_EQUAL(changes.size(), 6);
+    BOOST_CHECK_EQUAL(count(owl::ForumChange::ADDED, "5"), 1);
+    BOOST_CHECK_EQUAL(count(owl::ForumChange::REMOVED, "4"), 1);
+    BOOST_CHECK_EQUAL(count(owl::ForumChange::RENAMED, "2"), 1);
+    BOOST_CHECK_EQUAL(count(owl::ForumChange::REORDERED, "2"), 1);
+    BOOST_CHECK_EQUAL(count(owl::ForumChange::REORDERED, "3"), 1);
+
+    // forums that didn't change aren't mentioned at all
+    BOOST_CHECK_EQUAL(std::count_if(changes.begin(), changes.end(),
+        [](const owl::ForumChange& change) { return change.forum->getId() == "1"; }), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
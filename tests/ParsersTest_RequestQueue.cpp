@@ -0,0 +1,223 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+#include <QtCore>
+
+#include "../src/Parsers/RequestQueue.h"
+
+using Priority = owl::RequestQueue::Priority;
+
+namespace
+{
+
+// the queue delivers results through QFutureWatcher which needs an event loop
+struct ApplicationFixture
+{
+    ApplicationFixture()
+    {
+        if (!QCoreApplication::instance())
+        {
+            static int argc = 1;
+            static char name[] = "ParsersTest";
+            static char* argv[] = { name, nullptr };
+            static QCoreApplication app(argc, argv);
+        }
+    }
+};
+
+// spins the event loop until the queue is idle
+void waitForQueue(const owl::RequestQueue& queue)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while ((queue.pendingCount() > 0 || queue.runningCount() > 0) && timer.elapsed() < 5000)
+    {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(RequestQueue, ApplicationFixture)
+
+BOOST_AUTO_TEST_CASE(priorityTest)
+{
+    owl::RequestQueue queue;
+    QStringList order;
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    auto record = [&order](const QString& name)
+    {
+        return [&order, name](QFuture<QVariant>) { order.push_back(name); };
+    };
+
+    // keeps the queue busy while everything else is queued up behind it
+    queue.enqueue(Priority::NORMAL, QString(), [released]() { released.wait(); return QVariant(); }, record("first"));
+
+    queue.enqueue(Priority::BACKGROUND, QString(), []() { return QVariant(); }, record("background"));
+    queue.enqueue(Priority::NORMAL, QString(), []() { return QVariant(); }, record("normal"));
+    queue.enqueue(Priority::INTERACTIVE, QString(), []() { return QVariant(); }, record("interactive1"));
+    queue.enqueue(Priority::INTERACTIVE, QString(), []() { return QVariant(); }, record("interactive2"));
+
+    BOOST_CHECK_EQUAL(queue.runningCount(), 1u);
+    BOOST_CHECK_EQUAL(queue.pendingCount(), 4u);
+
+    release.set_value();
+    waitForQueue(queue);
+
+    const QStringList expected { "first", "interactive1", "interactive2", "normal", "background" };
+    BOOST_CHECK(order == expected);
+}
+
+BOOST_AUTO_TEST_CASE(supersedeTest)
+{
+    owl::RequestQueue queue;
+    QList<quint64> completed;
+    QList<quint64> cancelled;
+    QVariantList results;
+
+    QObject::connect(&queue, &owl::RequestQueue::requestCompleted, [&completed](quint64 id) { completed.push_back(id); });
+    QObject::connect(&queue, &owl::RequestQueue::requestCancelled, [&cancelled](quint64 id) { cancelled.push_back(id); });
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    auto handler = [&results](QFuture<QVariant> future) { results.push_back(future.result()); };
+
+    const auto running = queue.enqueue(Priority::INTERACTIVE, "threads", [released]() { released.wait(); return QVariant(1); }, handler);
+    const auto pending = queue.enqueue(Priority::INTERACTIVE, "threads", []() { return QVariant(2); }, handler);
+    const auto latest = queue.enqueue(Priority::INTERACTIVE, "threads", []() { return QVariant(3); }, handler);
+    const auto other = queue.enqueue(Priority::NORMAL, "posts", []() { return QVariant(4); }, handler);
+
+    // the running request was superseded twice but only cancelled once
+    BOOST_CHECK(cancelled == (QList<quint64> { running, pending }));
+
+    release.set_value();
+    waitForQueue(queue);
+
+    BOOST_CHECK(completed == (QList<quint64> { latest, other }));
+    BOOST_CHECK(results == (QVariantList { 3, 4 }));
+
+    // finished requests can't be cancelled
+    BOOST_CHECK(!queue.cancel(latest));
+}
+
+BOOST_AUTO_TEST_CASE(cancelTest)
+{
+    owl::RequestQueue queue;
+    bool bCalled = false;
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    const auto blocker = queue.enqueue(Priority::NORMAL, QString(), [released]() { released.wait(); return QVariant(); },
+        [&bCalled](QFuture<QVariant>) { bCalled = true; });
+
+    const auto waiting = queue.enqueue(Priority::NORMAL, QString(), []() { return QVariant(); },
+        [&bCalled](QFuture<QVariant>) { bCalled = true; });
+
+    BOOST_CHECK(queue.cancel(waiting));
+    BOOST_CHECK_EQUAL(queue.pendingCount(), 0u);
+
+    BOOST_CHECK(queue.cancel(blocker));
+    BOOST_CHECK(!queue.cancel(blocker));
+
+    release.set_value();
+    waitForQueue(queue);
+
+    BOOST_CHECK(!bCalled);
+}
+
+BOOST_AUTO_TEST_CASE(cancelRunningTest)
+{
+    owl::RequestQueue queue;
+    std::promise<void> started;
+    std::atomic<bool> bStopped { false };
+
+    // the running work sees its token cancelled once it is superseded
+    queue.enqueue(Priority::INTERACTIVE, QStringLiteral("posts"),
+        [&started, &bStopped]()
+        {
+            started.set_value();
+
+            const auto token = owl::CancellationToken::current();
+            while (!token->isCancelled())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+
+            bStopped = true;
+            return QVariant();
+        },
+        [](QFuture<QVariant>) {});
+
+    started.get_future().wait();
+    queue.enqueue(Priority::INTERACTIVE, QStringLiteral("posts"), []() { return QVariant(); }, [](QFuture<QVariant>) {});
+
+    waitForQueue(queue);
+    BOOST_CHECK(bStopped);
+}
+
+BOOST_AUTO_TEST_CASE(preemptTest)
+{
+    owl::RequestQueue queue;
+    QStringList order;
+    QList<quint64> cancelled;
+    std::promise<void> started;
+    std::atomic<bool> bRunning { false };
+    std::atomic<bool> bOverlapped { false };
+
+    QObject::connect(&queue, &owl::RequestQueue::requestCancelled, [&cancelled](quint64 id) { cancelled.push_back(id); });
+
+    // runs until it is stopped
+    const auto background = queue.enqueue(Priority::BACKGROUND, QStringLiteral("unread"),
+        [&started, &bRunning]()
+        {
+            bRunning = true;
+            started.set_value();
+
+            const auto token = owl::CancellationToken::current();
+            while (!token->isCancelled())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+
+            // still busy for a moment after noticing
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            bRunning = false;
+            return QVariant();
+        },
+        [&order](QFuture<QVariant>) { order.push_back("background"); });
+
+    started.get_future().wait();
+    queue.enqueue(Priority::INTERACTIVE, QStringLiteral("posts"),
+        [&bRunning, &bOverlapped]()
+        {
+            bOverlapped = bRunning.load();
+            return QVariant();
+        },
+        [&order](QFuture<QVariant>) { order.push_back("interactive"); });
+
+    // the background request keeps its slot until it has stopped
+    BOOST_CHECK(cancelled == (QList<quint64> { background }));
+    BOOST_CHECK_EQUAL(queue.runningCount(), 1u);
+    BOOST_CHECK_EQUAL(queue.pendingCount(), 1u);
+
+    waitForQueue(queue);
+
+    // and is dropped rather than run again
+    const QStringList expected { "interactive" };
+    BOOST_CHECK(order == expected);
+    BOOST_CHECK(!bOverlapped);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
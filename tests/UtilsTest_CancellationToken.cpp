@@ -0,0 +1,128 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include <QtCore>
+
+#include "../src/Utils/CancellationToken.h"
+#include "../src/Utils/Exception.h"
+
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(CancellationToken)
+
+BOOST_AUTO_TEST_CASE(cancelTest)
+{
+    owl::CancellationToken token;
+    BOOST_CHECK(!token.isCancelled());
+    BOOST_CHECK(!token.hasDeadline());
+    BOOST_CHECK(token.remaining() == owl::CancellationToken::Milliseconds::max());
+    BOOST_CHECK_NO_THROW(token.throwIfCancelled());
+
+    token.cancel();
+    BOOST_CHECK(token.isCancelled());
+    BOOST_CHECK_THROW(token.throwIfCancelled(), owl::CancelledException);
+
+    // being cancelled on purpose isn't a timeout
+    try
+    {
+        token.throwIfCancelled();
+    }
+    catch (const owl::TimeoutException&)
+    {
+        BOOST_ERROR("cancel() reported as a timeout");
+    }
+    catch (const owl::CancelledException&)
+    {
+    }
+}
+
+BOOST_AUTO_TEST_CASE(deadlineTest)
+{
+    owl::CancellationToken token(50ms);
+    BOOST_CHECK(token.hasDeadline());
+    BOOST_CHECK(!token.isCancelled());
+    BOOST_CHECK(token.remaining() <= 50ms);
+
+    std::this_thread::sleep_for(80ms);
+
+    BOOST_CHECK(token.isCancelled());
+    BOOST_CHECK(token.remaining() == owl::CancellationToken::Milliseconds::zero());
+    BOOST_CHECK_THROW(token.throwIfCancelled(), owl::CancelledException);
+    BOOST_CHECK_THROW(token.throwIfCancelled(), owl::TimeoutException);
+}
+
+BOOST_AUTO_TEST_CASE(waitForTest)
+{
+    owl::CancellationToken token;
+    BOOST_CHECK(token.waitFor(20ms));
+
+    // a cancel from another thread ends the wait early
+    std::thread canceller([&token]()
+    {
+        std::this_thread::sleep_for(50ms);
+        token.cancel();
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    BOOST_CHECK(!token.waitFor(60s));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < 5s);
+
+    canceller.join();
+
+    // a deadline ends it too
+    owl::CancellationToken deadline(30ms);
+    BOOST_CHECK(!deadline.waitFor(60s));
+}
+
+BOOST_AUTO_TEST_CASE(parentTest)
+{
+    auto parent = std::make_shared<owl::CancellationToken>(10s);
+    owl::CancellationToken child(60s, parent);
+
+    // the earlier deadline wins
+    BOOST_CHECK(child.deadline() == parent->deadline());
+    BOOST_CHECK(child.remaining() <= 10s);
+
+    BOOST_CHECK(!child.isCancelled());
+    parent->cancel();
+    BOOST_CHECK(child.isCancelled());
+
+    // cancelling a child leaves the parent alone
+    auto other = std::make_shared<owl::CancellationToken>();
+    owl::CancellationToken sibling(0ms, other);
+    sibling.cancel();
+    BOOST_CHECK(!other->isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(scopeTest)
+{
+    BOOST_CHECK(!owl::CancellationToken::current());
+
+    auto outer = std::make_shared<owl::CancellationToken>();
+    auto inner = std::make_shared<owl::CancellationToken>();
+
+    {
+        owl::CancellationToken::Scope outerScope(outer);
+        BOOST_CHECK(owl::CancellationToken::current() == outer);
+
+        {
+            owl::CancellationToken::Scope innerScope(inner);
+            BOOST_CHECK(owl::CancellationToken::current() == inner);
+
+            // the token is per thread
+            owl::CancellationTokenPtr seen = outer;
+            std::thread([&seen]() { seen = owl::CancellationToken::current(); }).join();
+            BOOST_CHECK(!seen);
+        }
+
+        BOOST_CHECK(owl::CancellationToken::current() == outer);
+    }
+
+    BOOST_CHECK(!owl::CancellationToken::current());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QtCore>
+#include <QTemporaryDir>
+
+#include "../src/Utils/CookieStore.h"
+#include "../src/Utils/WebClient.h"
+
+BOOST_AUTO_TEST_SUITE(CookieStore)
+
+BOOST_AUTO_TEST_CASE(obfuscateTest)
+{
+    const QByteArray key = owl::CookieStore::generateKey();
+    const QByteArray session = QByteArrayLiteral("example.com\tFALSE\t/\tFALSE\t0\txf_session\t0123456789abcdef\n");
+
+    const QByteArray sealed = owl::CookieStore::obfuscate(key, session);
+    BOOST_CHECK(!sealed.contains("xf_session"));
+    BOOST_CHECK(owl::CookieStore::deobfuscate(key, sealed) == session);
+
+    // the same session never comes out the same way twice
+    BOOST_CHECK(owl::CookieStore::obfuscate(key, session) != sealed);
+
+    // wrong key
+    BOOST_CHECK(owl::CookieStore::deobfuscate(owl::CookieStore::generateKey(), sealed).isEmpty());
+
+    // tampered data
+    QByteArray tampered = sealed;
+    tampered[tampered.size() / 2] = static_cast<char>(tampered[tampered.size() / 2] ^ 0x01);
+    BOOST_CHECK(owl::CookieStore::deobfuscate(key, tampered).isEmpty());
+
+    // truncated data
+    BOOST_CHECK(owl::CookieStore::deobfuscate(key, sealed.left(10)).isEmpty());
+    BOOST_CHECK(owl::CookieStore::deobfuscate(key, QByteArray()).isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(storeTest)
+{
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+
+    owl::CookieStore store;
+    BOOST_CHECK(!store.isEnabled());
+    BOOST_CHECK(!store.save("board", "session"));
+
+    store.setPath(dir.path());
+    store.setKey(owl::CookieStore::generateKey());
+    BOOST_REQUIRE(store.isEnabled());
+
+    BOOST_CHECK(store.load("board").isEmpty());
+    BOOST_CHECK(store.save("board", "session"));
+    BOOST_CHECK(store.load("board") == QByteArray("session"));
+    BOOST_CHECK(store.load("other").isEmpty());
+
+#ifndef Q_OS_WIN
+    // other users can't get at the sessions
+    const auto others = QFileDevice::ReadGroup | QFileDevice::WriteGroup | QFileDevice::ExeGroup
+        | QFileDevice::ReadOther | QFileDevice::WriteOther | QFileDevice::ExeOther;
+
+    const auto files = QDir(dir.path()).entryInfoList(QDir::Files);
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+    BOOST_CHECK((files.first().permissions() & others) == 0);
+    BOOST_CHECK((QFileInfo(dir.path()).permissions() & others) == 0);
+#endif
+
+    // sessions written with another key are ignored
+    store.setKey(owl::CookieStore::generateKey());
+    BOOST_CHECK(store.load("board").isEmpty());
+
+    store.remove("board");
+    BOOST_CHECK(QDir(dir.path()).entryList(QDir::Files).isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(cookieRoundTripTest)
+{
+    const QByteArray cookie = QByteArrayLiteral("example.com\tFALSE\t/\tFALSE\t0\tsession\tabc123");
+
+    owl::WebClient source;
+    source.importCookies(cookie + "\n");
+
+    const QByteArray exported = source.exportCookies();
+    BOOST_CHECK(exported.contains("session\tabc123"));
+
+    owl::WebClient dest;
+    BOOST_CHECK(dest.exportCookies().isEmpty());
+    dest.importCookies(exported);
+    BOOST_CHECK(dest.exportCookies() == exported);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,161 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QtCore>
+
+#include "../src/Utils/HtmlScanner.h"
+
+namespace
+{
+
+const QString listing =
+    "<!DOCTYPE html><html><head><script>if (a < b) { x = '<li class=\"discussionListItem\">'; }</script></head>"
+    "<body><ol>"
+    "<li id=\"thread-1\" class=\"discussionListItem sticky\">"
+        "<!-- <a class=\"PreviewTooltip\">commented out</a> -->"
+        "<a class=\"PreviewTooltip\" href=\"threads/one.1/\">First <b>thread</b></a>"
+        "<img src=\"avatar.png\" alt='it\"s'>"
+        "<a class=\"username\">author</a>"
+    "</li>"
+    "<li id=\"thread-2\" class=\"discussionListItem\">"
+        "<a class=\"PreviewTooltipX\">not a match</a>"
+        "<a class=\"PreviewTooltip\" href=\"threads/two.2/\">Second thread</a>"
+    "</li>"
+    "</ol>"
+    "<a class=\"PreviewTooltip\" href=\"outside\">Outside</a>"
+    "</body></html>";
+
+struct Item
+{
+    QString id;
+    QString href;
+    QString title;
+};
+
+QList<Item> scan(const QStringList& chunks)
+{
+    QList<Item> items;
+
+    owl::HtmlScanner scanner;
+    scanner.onStart("li.discussionListItem", [&](const owl::HtmlScanner::Element& e)
+    {
+        items.append({ e.attribute("id"), QString(), QString() });
+    });
+    scanner.onEnd("li.discussionListItem a.PreviewTooltip", [&](const owl::HtmlScanner::Element& e)
+    {
+        items.last().href = e.attribute("href");
+        items.last().title = e.text;
+    });
+
+    for (const auto& chunk : chunks)
+    {
+        scanner.feed(chunk);
+    }
+    scanner.finish();
+
+    return items;
+}
+
+void checkItems(const QList<Item>& items)
+{
+    BOOST_REQUIRE_EQUAL(items.size(), 2);
+    BOOST_CHECK_EQUAL(items.at(0).id.toStdString(), "thread-1");
+    BOOST_CHECK_EQUAL(items.at(0).href.toStdString(), "threads/one.1/");
+    BOOST_CHECK_EQUAL(items.at(0).title.toStdString(), "First thread");
+    BOOST_CHECK_EQUAL(items.at(1).id.toStdString(), "thread-2");
+    BOOST_CHECK_EQUAL(items.at(1).href.toStdString(), "threads/two.2/");
+    BOOST_CHECK_EQUAL(items.at(1).title.toStdString(), "Second thread");
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HtmlScannerTest)
+
+BOOST_AUTO_TEST_CASE(scanTest)
+{
+    checkItems(scan({ listing }));
+}
+
+BOOST_AUTO_TEST_CASE(chunkedTest)
+{
+    // every possible split of the page into two chunks, and one character at a time
+    for (int i = 0; i <= listing.length(); i++)
+    {
+        checkItems(scan({ listing.left(i), listing.mid(i) }));
+    }
+
+    QStringList characters;
+    for (const auto c : listing)
+    {
+        characters.append(QString(c));
+    }
+    checkItems(scan(characters));
+}
+
+BOOST_AUTO_TEST_CASE(utf8Test)
+{
+    const QByteArray page = QString("<p>caf\u00e9 \u00fcber</p>").toUtf8();
+    QString text;
+
+    owl::HtmlScanner scanner;
+    scanner.onEnd("p", [&](const owl::HtmlScanner::Element& e) { text = e.text; });
+
+    // one byte at a time splits the two byte characters
+    for (const char c : page)
+    {
+        scanner.feedUtf8(std::string_view(&c, 1));
+    }
+    scanner.finish();
+
+    BOOST_CHECK(text == QString("caf\u00e9 \u00fcber"));
+}
+
+BOOST_AUTO_TEST_CASE(unclosedTest)
+{
+    int closed = 0;
+    QString text;
+
+    owl::HtmlScanner scanner;
+    scanner.onEnd("div p", [&](const owl::HtmlScanner::Element&) { closed++; });
+    scanner.onEnd("div", [&](const owl::HtmlScanner::Element& e) { text = e.text; });
+
+    // the end-tag of the div closes the paragraphs inside it, a stray
+    // end-tag is ignored and finish() closes the div
+    scanner.feed("<div><p>one<p>two</span></div><div>three <br/>four<p");
+    scanner.finish();
+
+    BOOST_CHECK_EQUAL(closed, 2);
+    BOOST_CHECK_EQUAL(text.toStdString(), "three four");
+}
+
+BOOST_AUTO_TEST_CASE(whitespaceTest)
+{
+    QString title;
+    QString author;
+    QString preview;
+
+    owl::HtmlScanner scanner;
+    scanner.onEnd("li a.PreviewTooltip", [&](const owl::HtmlScanner::Element& e) { title = e.text; });
+    scanner.onEnd("li a.username", [&](const owl::HtmlScanner::Element& e) { author = e.text; });
+    scanner.onEnd("li h4.subtitle", [&](const owl::HtmlScanner::Element& e) { preview = e.text; });
+
+    // indented the way XenForo's templates are, the text is passed on as is
+    scanner.feed(
+        "<li class=\"discussionListItem\">\n"
+        "\t<h3 class=\"title\">\n"
+        "\t\t<a class=\"PreviewTooltip\" href=\"threads/one.1/\">\n\t\t\tFirst\n\t\t\t<b>thread</b>\n\t\t</a>\n"
+        "\t</h3>\n"
+        "\t<a class=\"username\">\n\t\tauthor\n\t</a>\n"
+        "\t<h4 class=\"subtitle\">\n\t\tSome  preview\n\t\ttext\n\t</h4>\n"
+        "</li>");
+    scanner.finish();
+
+    BOOST_CHECK_EQUAL(title.toStdString(), "\n\t\t\tFirst\n\t\t\tthread\n\t\t");
+    BOOST_CHECK_EQUAL(title.simplified().toStdString(), "First thread");
+    BOOST_CHECK_EQUAL(author.trimmed().toStdString(), "author");
+    BOOST_CHECK_EQUAL(preview.simplified().toStdString(), "Some preview text");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
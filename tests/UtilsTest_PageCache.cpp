@@ -0,0 +1,71 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include <QtCore>
+
+#include "../src/Utils/PageCache.h"
+
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(PageCache)
+
+BOOST_AUTO_TEST_CASE(takeTest)
+{
+    owl::PageCache cache;
+    const QString key = owl::PageCache::makeKey("posts", "123", 2, 25);
+
+    BOOST_CHECK(!cache.take(key).isValid());
+
+    cache.put(key, QString("page two"));
+    BOOST_CHECK(cache.contains(key));
+    BOOST_CHECK(!cache.contains(owl::PageCache::makeKey("posts", "123", 3, 25)));
+    BOOST_CHECK(!cache.contains(owl::PageCache::makeKey("posts", "123", 2, 50)));
+
+    // entries are handed out once
+    BOOST_CHECK_EQUAL(cache.take(key).toString().toStdString(), "page two");
+    BOOST_CHECK(!cache.contains(key));
+    BOOST_CHECK(!cache.take(key).isValid());
+}
+
+BOOST_AUTO_TEST_CASE(expiryTest)
+{
+    owl::PageCache cache(50ms);
+    const QString key = owl::PageCache::makeKey("threads", "7", 1, 25);
+
+    cache.put(key, 42);
+    BOOST_CHECK(cache.contains(key));
+
+    std::this_thread::sleep_for(80ms);
+
+    BOOST_CHECK(!cache.contains(key));
+    BOOST_CHECK(!cache.take(key).isValid());
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(capacityTest)
+{
+    owl::PageCache cache(60s, 2);
+
+    cache.put("a", 1);
+    std::this_thread::sleep_for(2ms);
+    cache.put("b", 2);
+    std::this_thread::sleep_for(2ms);
+    cache.put("c", 3);
+
+    // the oldest entry makes room
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(!cache.contains("a"));
+    BOOST_CHECK(cache.contains("b"));
+    BOOST_CHECK(cache.contains("c"));
+
+    // replacing an entry doesn't evict anything
+    cache.put("c", 4);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK_EQUAL(cache.take("c").toInt(), 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,4 +25,143 @@ BOOST_DATA_TEST_CASE(testParse, data::make(htmlData), htmlText)
     BOOST_CHECK(doc.parse(QString::fromStdString(htmlText)));
 }
 
+BOOST_AUTO_TEST_CASE(testAttributes)
+{
+    QSgml doc;
+    doc.parse(R"(<div id="main" class='a b' data-x=1 hidden><INPUT Type = "text" disabled></div>)");
+
+    const auto divs = doc.getElementsByName("div");
+    BOOST_REQUIRE_EQUAL(divs.size(), 1);
+    BOOST_CHECK_EQUAL(divs.at(0)->getArgValue("id").toStdString(), "main");
+    BOOST_CHECK_EQUAL(divs.at(0)->getArgValue("class").toStdString(), "a b");
+    BOOST_CHECK_EQUAL(divs.at(0)->getArgValue("data-x").toStdString(), "1");
+    BOOST_CHECK(divs.at(0)->hasAttribute("hidden"));
+
+    // a void element doesn't swallow what follows it
+    const auto inputs = doc.getElementsByName("input");
+    BOOST_REQUIRE_EQUAL(inputs.size(), 1);
+    BOOST_CHECK_EQUAL(inputs.at(0)->getArgValue("type").toStdString(), "text");
+    BOOST_CHECK(inputs.at(0)->hasAttribute("disabled"));
+    BOOST_CHECK_EQUAL(inputs.at(0)->Parent, divs.at(0));
+    BOOST_CHECK_EQUAL(inputs.at(0)->Children.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testExceptionTags)
+{
+    QSgml doc;
+    doc.parse("<html><body><SCRIPT>if (a < b) { x = '<p>'; }</Script>"
+        "<p class=\"after\">text</p></body></html>");
+
+    // the markup inside the script isn't parsed and its end-tag is found
+    // regardless of case
+    const auto paragraphs = doc.getElementsByName("p");
+    BOOST_REQUIRE_EQUAL(paragraphs.size(), 1);
+    BOOST_CHECK_EQUAL(paragraphs.at(0)->getArgValue("class").toStdString(), "after");
+    BOOST_CHECK_EQUAL(doc.getText(paragraphs.at(0)).toStdString(), "text");
+}
+
+BOOST_AUTO_TEST_CASE(testUnterminated)
+{
+    // none of these may hang or read past the end of the document
+    for (const auto html : { "<div><script>var a = 1;", "<div><!-- comment", "<div class=\"a>", "<p>text<" })
+    {
+        QSgml doc;
+        BOOST_CHECK(doc.parse(QString::fromLatin1(html)));
+        BOOST_CHECK_EQUAL(doc.getElementsByName("div").size() + doc.getElementsByName("p").size(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testReparse)
+{
+    // enough tags to need several of the arena's blocks
+    QString html { "<ul>" };
+    for (int i = 0; i < 5000; i++)
+    {
+        html += QString("<li id=\"%1\">item</li>").arg(i);
+    }
+    html += "</ul>";
+
+    QSgml doc;
+    doc.parse(html);
+
+    const auto items = doc.getElementsByName("li");
+    BOOST_REQUIRE_EQUAL(items.size(), 5000);
+    BOOST_CHECK_EQUAL(items.at(4999)->getArgValue("id").toStdString(), "4999");
+
+    // the tags of the first document are gone and don't leak into the second
+    doc.parse("<ul><li id=\"a\">one</li></ul>");
+    const auto reparsed = doc.getElementsByName("li");
+    BOOST_REQUIRE_EQUAL(reparsed.size(), 1);
+    BOOST_CHECK_EQUAL(reparsed.at(0)->getArgValue("id").toStdString(), "a");
+}
+
+BOOST_AUTO_TEST_CASE(testLazyAttributes)
+{
+    // the tags' attributes refer to the document's copy of the string it was made from
+    QSgml doc { QString(R"(<p ID="first" class="x" style="color: red" title='a "b"' class="y">text</p>)") };
+
+    const auto paragraphs = doc.getElementsByName("p");
+    BOOST_REQUIRE_EQUAL(paragraphs.size(), 1);
+
+    auto p = paragraphs.at(0);
+    BOOST_CHECK_EQUAL(p->getArgValue("id").toStdString(), "first");
+    BOOST_CHECK_EQUAL(p->getArgValue("class").toStdString(), "y");
+    BOOST_CHECK_EQUAL(p->getArgValue("title").toStdString(), "a \"b\"");
+    BOOST_CHECK(p->hasAttribute("style"));
+    BOOST_CHECK(!p->hasAttribute("href"));
+
+    const auto& attributes = p->getAttributes();
+    BOOST_CHECK_EQUAL(attributes.size(), 4);
+    BOOST_CHECK_EQUAL(attributes.value("style").toStdString(), "color: red");
+
+    p->setAttribute("class", "z");
+    p->setAttribute("hidden", QString());
+    BOOST_CHECK_EQUAL(p->getArgValue("class").toStdString(), "z");
+    BOOST_CHECK(p->hasAttribute("hidden"));
+    BOOST_CHECK_EQUAL(p->getArgValue("id").toStdString(), "first");
+}
+
+BOOST_AUTO_TEST_CASE(testSelect)
+{
+    QSgml doc;
+    doc.parse(
+        "<ol>"
+        "<li id=\"thread-1\" class=\"discussionListItem sticky\">"
+            "<a class=\"PreviewTooltip\" href=\"t1\">One</a>"
+            "<div class=\"listBlock stats\"><dl class=\"major\"><dd>3</dd></dl></div>"
+        "</li>"
+        "<li id=\"thread-2\" class=\"discussionListItem\">"
+            "<a class=\"PreviewTooltipX\" href=\"x\">Not a match</a>"
+            "<a class=\"PreviewTooltip\" href=\"t2\">Two</a>"
+        "</li>"
+        "</ol>"
+        "<a class=\"PreviewTooltip\" href=\"outside\">Three</a>");
+
+    const auto items = doc.select("li.discussionListItem");
+    BOOST_REQUIRE_EQUAL(items.size(), 2);
+    BOOST_CHECK_EQUAL(doc.select("LI.discussionListItem.sticky").size(), 1);
+    BOOST_CHECK_EQUAL(doc.select("#thread-2").value(0), items.at(1));
+
+    // classes are whole words and the results come in document order
+    const auto links = doc.select("a.PreviewTooltip");
+    BOOST_REQUIRE_EQUAL(links.size(), 3);
+    BOOST_CHECK_EQUAL(links.at(0)->getArgValue("href").toStdString(), "t1");
+    BOOST_CHECK_EQUAL(links.at(2)->getArgValue("href").toStdString(), "outside");
+
+    // descendant selectors and scopes
+    BOOST_CHECK_EQUAL(doc.select("ol a.PreviewTooltip").size(), 2);
+    BOOST_CHECK_EQUAL(doc.select("div.stats dl.major dd").size(), 1);
+    BOOST_CHECK(doc.selectFirst(items.at(1), "div.stats") == nullptr);
+    BOOST_CHECK_EQUAL(doc.selectFirst(items.at(1), "a.PreviewTooltip")->getArgValue("href").toStdString(), "t2");
+    BOOST_CHECK_EQUAL(doc.select(items.at(0), "li a").size(), 0);
+
+    BOOST_CHECK(doc.select("span").isEmpty());
+    BOOST_CHECK(doc.select("a.missing").isEmpty());
+
+    // the index is rebuilt for a new document
+    doc.parse("<p class=\"PreviewTooltip\">new</p>");
+    BOOST_CHECK(doc.select("a.PreviewTooltip").isEmpty());
+    BOOST_CHECK_EQUAL(doc.select(".PreviewTooltip").size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,102 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QtCore>
+
+#include "../src/Utils/RateLimiter.h"
+
+using Milliseconds = owl::RateLimiter::Milliseconds;
+
+BOOST_AUTO_TEST_SUITE(RateLimiter)
+
+BOOST_AUTO_TEST_CASE(parseRetryAfterTest)
+{
+    const QDateTime now = QDateTime(QDate(2019, 3, 10), QTime(12, 0, 0), Qt::UTC);
+
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter("120", now) == Milliseconds(120000));
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter(" 0 ", now) == Milliseconds(0));
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter("Sun, 10 Mar 2019 12:00:30 GMT", now) == Milliseconds(30000));
+
+    // a date in the past means "right away"
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter("Sun, 10 Mar 2019 11:00:00 GMT", now) == Milliseconds(0));
+
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter(QString(), now).count() < 0);
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter("-5", now).count() < 0);
+    BOOST_CHECK(owl::RateLimiter::parseRetryAfter("soon", now).count() < 0);
+}
+
+BOOST_AUTO_TEST_CASE(backoffDelayTest)
+{
+    const Milliseconds base { 1000 };
+    const Milliseconds max { 10000 };
+
+    // with a jitter of 1 the delay doubles with every attempt
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(1, base, max, 1.0) == Milliseconds(1000));
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(2, base, max, 1.0) == Milliseconds(2000));
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(3, base, max, 1.0) == Milliseconds(4000));
+
+    // capped at max
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(10, base, max, 1.0) == max);
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(1000, base, max, 1.0) == max);
+
+    // no jitter halves the delay
+    BOOST_CHECK(owl::RateLimiter::backoffDelay(3, base, max, 0.0) == Milliseconds(2000));
+}
+
+BOOST_AUTO_TEST_CASE(acquireTest)
+{
+    owl::RateLimiter::Config config;
+    config.initialRate = 1.0;
+    config.burst = 3.0;
+
+    owl::RateLimiter limiter(config);
+
+    // the burst goes out right away
+    for (int i = 0; i < 3; i++)
+    {
+        BOOST_CHECK(limiter.acquire("example.com") == Milliseconds::zero());
+    }
+
+    // after that each request waits its turn
+    const auto first = limiter.acquire("example.com");
+    const auto second = limiter.acquire("example.com");
+    BOOST_CHECK(first.count() > 0);
+    BOOST_CHECK(second > first);
+
+    // other hosts are unaffected
+    BOOST_CHECK(limiter.acquire("example.org") == Milliseconds::zero());
+}
+
+BOOST_AUTO_TEST_CASE(throttleTest)
+{
+    owl::RateLimiter::Config config;
+    config.initialRate = 4.0;
+    config.increase = 0.5;
+
+    owl::RateLimiter limiter(config);
+
+    limiter.update("example.com", 200);
+    BOOST_CHECK_CLOSE(limiter.getRate("example.com"), 4.5, 0.001);
+
+    limiter.update("example.com", 429, "2");
+    BOOST_CHECK_CLOSE(limiter.getRate("example.com"), 2.25, 0.001);
+
+    const auto wait = limiter.acquire("example.com");
+    BOOST_CHECK(wait.count() > 1900);
+    BOOST_CHECK(wait.count() <= 2000);
+
+    // a Retry-After longer than backoffMax is capped
+    limiter.update("example.org", 503, "7200");
+    BOOST_CHECK(limiter.acquire("example.org") <= config.backoffMax);
+
+    // a failed transfer (no status) leaves the rate alone
+    limiter.update("example.com", 0);
+    BOOST_CHECK_CLOSE(limiter.getRate("example.com"), 2.25, 0.001);
+
+    BOOST_CHECK(owl::RateLimiter::isThrottled(503));
+    BOOST_CHECK(!owl::RateLimiter::isThrottled(500));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QtCore>
+
+#include "../src/Utils/RefreshPolicy.h"
+
+using Outcome = owl::RefreshPolicy::Outcome;
+using Seconds = owl::RefreshPolicy::Seconds;
+
+namespace
+{
+
+QDateTime at(int hour)
+{
+    return QDateTime(QDate(2019, 6, 1), QTime(hour, 0));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(RefreshPolicy)
+
+BOOST_AUTO_TEST_CASE(boundsTest)
+{
+    owl::RefreshPolicy::Config config;
+    config.minInterval = Seconds(60);
+    config.maxInterval = Seconds(3600);
+    config.initialInterval = Seconds(300);
+
+    owl::RefreshPolicy policy(config);
+    BOOST_CHECK_EQUAL(policy.getInterval().count(), 300);
+
+    // a quiet board drifts out to the upper bound
+    for (int i = 0; i < 20; i++)
+    {
+        const auto next = policy.update(Outcome::UNCHANGED, at(3));
+        BOOST_CHECK(next <= config.maxInterval);
+    }
+    BOOST_CHECK_EQUAL(policy.getInterval().count(), 3600);
+
+    // and a busy one comes back in to the lower bound
+    for (int i = 0; i < 20; i++)
+    {
+        const auto next = policy.update(Outcome::CHANGED, at(3));
+        BOOST_CHECK(next >= config.minInterval);
+    }
+    BOOST_CHECK_EQUAL(policy.getInterval().count(), 60);
+
+    // tightening the bounds clamps what was learned
+    config.minInterval = Seconds(120);
+    policy.setConfig(config);
+    BOOST_CHECK_EQUAL(policy.getInterval().count(), 120);
+}
+
+BOOST_AUTO_TEST_CASE(backoffTest)
+{
+    owl::RefreshPolicy::Config config;
+    config.errorBase = Seconds(60);
+    config.errorMax = Seconds(400);
+
+    owl::RefreshPolicy policy(config);
+    const auto interval = policy.getInterval();
+
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12)).count(), 60);
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12)).count(), 120);
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12)).count(), 240);
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12)).count(), 400);
+    BOOST_CHECK_EQUAL(policy.getErrorCount(), 4u);
+
+    // jitter spreads the delay between half and all of it
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12), 0.0).count(), 200);
+
+    // errors don't change the learned interval and a success resets them
+    BOOST_CHECK(policy.getInterval() == interval);
+    policy.update(Outcome::UNCHANGED, at(12));
+    BOOST_CHECK_EQUAL(policy.getErrorCount(), 0u);
+    BOOST_CHECK_EQUAL(policy.update(Outcome::FAILED, at(12)).count(), 60);
+}
+
+BOOST_AUTO_TEST_CASE(timeOfDayTest)
+{
+    owl::RefreshPolicy::Config config;
+    config.minInterval = Seconds(10);
+    config.maxInterval = Seconds(3600);
+
+    owl::RefreshPolicy policy(config);
+
+    // the board is busy in the evening
+    for (int i = 0; i < 10; i++)
+    {
+        policy.update(Outcome::CHANGED, at(20));
+    }
+
+    BOOST_CHECK(policy.getActivity(20) > 0.5);
+    BOOST_CHECK_EQUAL(policy.getActivity(3), 0.0);
+
+    owl::RefreshPolicy evening = policy;
+    owl::RefreshPolicy night = policy;
+
+    const auto eveningNext = evening.update(Outcome::UNCHANGED, at(20));
+    const auto nightNext = night.update(Outcome::UNCHANGED, at(3));
+
+    BOOST_CHECK(evening.getInterval() == night.getInterval());
+    BOOST_CHECK(eveningNext < nightNext);
+    BOOST_CHECK(nightNext == night.getInterval());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QtCore>
+
+#include "../src/Utils/SharedSnapshot.h"
+
+namespace
+{
+
+struct Info
+{
+    QString name;
+    int     version = 0;
+    bool    loaded = false;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SharedSnapshot)
+
+BOOST_AUTO_TEST_CASE(updateTest)
+{
+    owl::SharedSnapshot<Info> info;
+    BOOST_CHECK(!info.get()->loaded);
+
+    const auto before = info.get();
+    info.update([](Info& i) { i.name = "board"; i.loaded = true; });
+    info.update([](Info& i) { i.version = 2; });
+
+    // a snapshot that was taken earlier doesn't change
+    BOOST_CHECK(!before->loaded);
+    BOOST_CHECK(before->name.isEmpty());
+
+    const auto after = info.get();
+    BOOST_CHECK(after->loaded);
+    BOOST_CHECK_EQUAL(after->name.toStdString(), "board");
+    BOOST_CHECK_EQUAL(after->version, 2);
+}
+
+BOOST_AUTO_TEST_CASE(discoverOnceTest)
+{
+    owl::SharedSnapshot<Info> info;
+    std::atomic<int> discoveries { 0 };
+
+    auto discover = [&]()
+    {
+        if (info.get()->loaded)
+        {
+            return;
+        }
+
+        const auto lock = info.lockDiscovery();
+        if (info.get()->loaded)
+        {
+            return;
+        }
+
+        discoveries++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        info.update([](Info& i) { i.loaded = true; });
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back(discover);
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    BOOST_CHECK_EQUAL(discoveries.load(), 1);
+    BOOST_CHECK(info.get()->loaded);
+}
+
+BOOST_AUTO_TEST_CASE(reentrantDiscoveryTest)
+{
+    owl::SharedSnapshot<Info> info;
+
+    {
+        const auto outer = info.lockDiscovery();
+        {
+            // e.g. a login in the middle of loading the config
+            const auto inner = info.lockDiscovery();
+            info.update([](Info& i) { i.version = 1; });
+        }
+
+        info.update([](Info& i) { i.loaded = true; });
+    }
+
+    // the nested update isn't lost
+    BOOST_CHECK_EQUAL(info.get()->version, 1);
+    BOOST_CHECK(info.get()->loaded);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
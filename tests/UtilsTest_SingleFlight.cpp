@@ -0,0 +1,75 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QtCore>
+
+#include "../src/Utils/SingleFlight.h"
+
+BOOST_AUTO_TEST_SUITE(SingleFlight)
+
+BOOST_AUTO_TEST_CASE(coalesceTest)
+{
+    owl::SingleFlight<std::string, int> flights;
+    std::atomic<int> calls { 0 };
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    auto work = [&]()
+    {
+        calls++;
+        released.wait();
+        return 42;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<int> results(8, 0);
+
+    // the first caller blocks inside the function until every other caller is waiting on it
+    threads.emplace_back([&]() { results[0] = flights.run("key", work); });
+    while (flights.size() == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    for (std::size_t i = 1; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i]() { results[i] = flights.run("key", work); });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    release.set_value();
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    BOOST_CHECK_EQUAL(calls.load(), 1);
+    BOOST_CHECK_EQUAL(flights.size(), 0u);
+    for (const auto result : results)
+    {
+        BOOST_CHECK_EQUAL(result, 42);
+    }
+
+    // once finished the key is forgotten and the next call runs again
+    BOOST_CHECK_EQUAL(flights.run("key", []() { return 7; }), 7);
+    BOOST_CHECK_EQUAL(flights.run("other", work), 42);
+    BOOST_CHECK_EQUAL(calls.load(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(exceptionTest)
+{
+    owl::SingleFlight<std::string, int> flights;
+
+    BOOST_CHECK_THROW(flights.run("key", []() -> int { throw std::runtime_error("failed"); }), std::runtime_error);
+    BOOST_CHECK_EQUAL(flights.size(), 0u);
+    BOOST_CHECK_EQUAL(flights.run("key", []() { return 1; }), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
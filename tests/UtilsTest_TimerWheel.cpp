@@ -0,0 +1,77 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+#include <QtCore>
+
+#include "../src/Utils/TimerWheel.h"
+
+BOOST_AUTO_TEST_SUITE(TimerWheel)
+
+BOOST_AUTO_TEST_CASE(dueTest)
+{
+    owl::TimerWheel wheel(4);
+
+    // less than, exactly and more than one turn of the wheel
+    wheel.schedule(1, 1);
+    wheel.schedule(2, 4);
+    wheel.schedule(3, 5);
+    wheel.schedule(4, 9);
+    BOOST_CHECK_EQUAL(wheel.size(), 4u);
+
+    std::map<owl::TimerWheel::Key, int> dueAt;
+    for (int tick = 1; tick <= 10; tick++)
+    {
+        for (const auto key : wheel.advance())
+        {
+            dueAt[key] = tick;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(dueAt[1], 1);
+    BOOST_CHECK_EQUAL(dueAt[2], 4);
+    BOOST_CHECK_EQUAL(dueAt[3], 5);
+    BOOST_CHECK_EQUAL(dueAt[4], 9);
+    BOOST_CHECK_EQUAL(wheel.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(cancelTest)
+{
+    owl::TimerWheel wheel(8);
+
+    wheel.schedule(1, 2);
+    wheel.schedule(2, 2);
+    BOOST_CHECK(wheel.contains(1));
+
+    BOOST_CHECK(wheel.cancel(1));
+    BOOST_CHECK(!wheel.cancel(1));
+    BOOST_CHECK(!wheel.contains(1));
+
+    wheel.advance();
+    const auto due = wheel.advance();
+    BOOST_REQUIRE_EQUAL(due.size(), 1u);
+    BOOST_CHECK_EQUAL(due.front(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(rescheduleTest)
+{
+    owl::TimerWheel wheel(8);
+
+    // scheduling a key again moves it rather than adding a second timer
+    wheel.schedule(1, 1);
+    wheel.schedule(1, 3);
+    BOOST_CHECK_EQUAL(wheel.size(), 1u);
+
+    BOOST_CHECK(wheel.advance().empty());
+    BOOST_CHECK(wheel.advance().empty());
+    BOOST_CHECK_EQUAL(wheel.advance().size(), 1u);
+
+    // zero ticks means the next one
+    wheel.schedule(5, 0);
+    BOOST_CHECK_EQUAL(wheel.advance().size(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
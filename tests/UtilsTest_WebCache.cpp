@@ -0,0 +1,142 @@
+// Owl - www.owlclient.com
+// Copyright (c) 2012-2019, Adalid Claure <aclaure@gmail.com>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QtCore>
+#include <QTemporaryDir>
+
+#include "../src/Utils/OwlUtils.h"
+#include "../src/Utils/WebCache.h"
+
+BOOST_AUTO_TEST_SUITE(WebCache)
+
+BOOST_AUTO_TEST_CASE(parseHttpDateTest)
+{
+    const QDateTime expected { QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC };
+
+    BOOST_CHECK(owl::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT") == expected);
+    BOOST_CHECK(owl::parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT") == expected);
+    BOOST_CHECK(owl::parseHttpDate("Sun Nov  6 08:49:37 1994") == expected);
+    BOOST_CHECK(!owl::parseHttpDate("0").isValid());
+    BOOST_CHECK(!owl::parseHttpDate(QString()).isValid());
+}
+
+BOOST_AUTO_TEST_CASE(expiresFromHeadersTest)
+{
+    const QDateTime now { QDate(2019, 1, 1), QTime(12, 0, 0), Qt::UTC };
+    QDateTime result;
+
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders("max-age=60", QString(), now, result));
+    BOOST_CHECK(result == now.addSecs(60));
+
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders("private, max-age=0", QString(), now, result));
+    BOOST_CHECK(result == now);
+
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders("no-cache, max-age=600", QString(), now, result));
+    BOOST_CHECK(result == now);
+
+    BOOST_CHECK(!owl::WebCache::expiresFromHeaders("private, no-store", QString(), now, result));
+
+    // max-age wins over Expires
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders("max-age=30", "Tue, 01 Jan 2019 13:00:00 GMT", now, result));
+    BOOST_CHECK(result == now.addSecs(30));
+
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders(QString(), "Tue, 01 Jan 2019 13:00:00 GMT", now, result));
+    BOOST_CHECK(result == now.addSecs(3600));
+
+    BOOST_CHECK(owl::WebCache::expiresFromHeaders(QString(), "-1", now, result));
+    BOOST_CHECK(result == now);
+}
+
+BOOST_AUTO_TEST_CASE(isStorableTest)
+{
+    BOOST_CHECK(owl::WebCache::isStorable("max-age=60", false));
+    BOOST_CHECK(owl::WebCache::isStorable(QString(), false));
+    BOOST_CHECK(owl::WebCache::isStorable("no-cache", false));
+    BOOST_CHECK(!owl::WebCache::isStorable("private, max-age=60", false));
+    BOOST_CHECK(!owl::WebCache::isStorable("no-store", false));
+
+    // keys scoped to an identity can hold private responses
+    BOOST_CHECK(owl::WebCache::isStorable("private, max-age=0", true));
+    BOOST_CHECK(owl::WebCache::isStorable("max-age=60", true));
+    BOOST_CHECK(!owl::WebCache::isStorable("private, no-store", true));
+}
+
+BOOST_AUTO_TEST_CASE(storeAndFindTest)
+{
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+
+    owl::WebCache cache;
+    BOOST_CHECK(!cache.isEnabled());
+
+    cache.setPath(dir.path());
+    BOOST_REQUIRE(cache.isEnabled());
+
+    const QString key = owl::WebCache::makeKey("GET", "https://www.owlclient.com/", QString());
+    BOOST_CHECK(key != owl::WebCache::makeKey("POST", "https://www.owlclient.com/", QString()));
+    BOOST_CHECK(key != owl::WebCache::makeKey("GET", "https://www.owlclient.com/", "a=b"));
+    BOOST_CHECK(key != owl::WebCache::makeKey("GET", "https://www.owlclient.com/", QString(), "user"));
+    BOOST_CHECK(cache.find(key) == nullptr);
+
+    owl::WebCache::Entry entry;
+    entry.expires = QDateTime::currentDateTimeUtc().addSecs(60);
+    entry.etag = "\"abc123\"";
+    entry.finalUrl = "https://www.owlclient.com/index.html";
+    entry.data = std::string("<html>\0</html>", 14);
+    cache.store(key, entry);
+
+    auto found = cache.find(key);
+    BOOST_REQUIRE(found != nullptr);
+    BOOST_CHECK(found->isFresh());
+    BOOST_CHECK(found->hasValidator());
+    BOOST_CHECK_EQUAL(found->etag.toStdString(), entry.etag.toStdString());
+    BOOST_CHECK(found->lastModified.isEmpty());
+    BOOST_CHECK_EQUAL(found->finalUrl, entry.finalUrl);
+    BOOST_CHECK(found->data == entry.data);
+
+    cache.remove(key);
+    BOOST_CHECK(cache.find(key) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(evictTest)
+{
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+
+    owl::WebCache cache;
+    cache.setPath(dir.path());
+
+    owl::WebCache::Entry entry;
+    entry.expires = QDateTime::currentDateTimeUtc().addSecs(60);
+    entry.data = std::string(1000, 'x');
+
+    const QString first = owl::WebCache::makeKey("GET", "https://www.owlclient.com/1", QString());
+    const QString second = owl::WebCache::makeKey("GET", "https://www.owlclient.com/2", QString());
+    const QString third = owl::WebCache::makeKey("GET", "https://www.owlclient.com/3", QString());
+
+    cache.store(first, entry);
+    const qint64 entrySize = QFileInfo(QDir(dir.path()).filePath(first + ".cache")).size();
+    BOOST_REQUIRE(entrySize > 1000);
+
+    // room for two entries
+    cache.setMaxSize(entrySize * 2 + entrySize / 2);
+    BOOST_CHECK(cache.find(first) != nullptr);
+
+    QThread::msleep(50);
+    cache.store(second, entry);
+
+    // using the first entry makes the second one the least recently used
+    QThread::msleep(50);
+    BOOST_CHECK(cache.find(first) != nullptr);
+
+    QThread::msleep(50);
+    cache.store(third, entry);
+
+    BOOST_CHECK(cache.find(first) != nullptr);
+    BOOST_CHECK(cache.find(second) == nullptr);
+    BOOST_CHECK(cache.find(third) != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
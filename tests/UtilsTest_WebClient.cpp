@@ -66,6 +66,34 @@ BOOST_DATA_TEST_CASE(statusTests, data::make(statusData), url, expectedResponse,
     BOOST_CHECK_EQUAL(reply->status(), expectedStatus);
 }
 
+BOOST_AUTO_TEST_CASE(asyncStatusTests)
+{
+    owl::WebClient client;
+    client.setThrowOnFail(false);
+
+    // submit every request before waiting on any of them so they are all in flight together
+    std::vector<std::future<owl::WebClient::ReplyPtr>> futures;
+    for (const auto& [url, expectedResponse, expectedStatus] : statusData)
+    {
+        futures.push_back(client.GetUrlAsync(QString::fromLatin1(url), owl::WebClient::NOTIDY | owl::WebClient::NOCACHE));
+    }
+
+    for (std::size_t i = 0; i < futures.size(); i++)
+    {
+        auto reply = futures[i].get();
+        BOOST_REQUIRE(reply != nullptr);
+        BOOST_CHECK_EQUAL(reply->text().toStdString(), std::get<1>(statusData[i]));
+        BOOST_CHECK_EQUAL(reply->status(), std::get<2>(statusData[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(asyncThrowTest)
+{
+    owl::WebClient client;
+    auto future = client.GetUrlAsync(QStringLiteral("https://httpstat.us/404"), owl::WebClient::NOTIDY | owl::WebClient::NOCACHE);
+    BOOST_CHECK_THROW(future.get(), owl::WebException);
+}
+
 // [0] - the initial url
 // [1] - the expected finalUrl
 std::tuple<const char*, const char*> redirectData[]
@@ -215,14 +243,36 @@ BOOST_DATA_TEST_CASE(rawDataTest, data::make(rawData), url, expectedHash)
 
     auto reply = client.GetUrl(QString::fromLatin1(url), owl::WebClient::NOTIDY);
 
+    BOOST_REQUIRE(reply != nullptr);
+
     QByteArray byteArray(reply->data().c_str(), 
         static_cast<uint>(reply->data().size()));
     const QByteArray hash = QCryptographicHash::hash(byteArray, QCryptographicHash::Sha1);
     const QString result = QString{ hash.toHex() }.toUpper();
 
-    BOOST_REQUIRE(reply != nullptr);
+    // the views must see exactly the same bytes without copying them
+    BOOST_CHECK(reply->view().data() == reply->data().data());
+    BOOST_CHECK(reply->byteArray().constData() == reply->data().data());
+    BOOST_CHECK_EQUAL(reply->view().size(), reply->data().size());
+
     BOOST_CHECK_EQUAL(reply->status(), 200);
     BOOST_CHECK_EQUAL(result.toStdString(), expectedHash);
 }
 
+BOOST_AUTO_TEST_CASE(compressionTest)
+{
+    owl::WebClient client;
+    client.setThrowOnFail(false);
+
+    // the response is always gzip'd and should be decoded transparently
+    auto reply = client.GetUrl(QStringLiteral("https://httpbin.org/gzip"), owl::WebClient::NOTIDY | owl::WebClient::NOCACHE);
+
+    BOOST_REQUIRE(reply != nullptr);
+    BOOST_CHECK_EQUAL(reply->status(), 200);
+    BOOST_CHECK(reply->text().contains("\"gzipped\": true"));
+    BOOST_CHECK(reply->wireSize() > 0);
+    BOOST_CHECK_EQUAL(reply->contentSize(), reply->data().size());
+    BOOST_CHECK(reply->wireSize() < reply->contentSize());
+}
+
 BOOST_AUTO_TEST_SUITE_END()